@@ -15,6 +15,7 @@
 #ifndef BINARY_READER_INCLUDE_CODECS_H_
 #define BINARY_READER_INCLUDE_CODECS_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -24,6 +25,35 @@
 
 namespace binary_reader {
 
+/// <summary>
+/// Identifies one of the built-in codecs.  Codecs can be compared by ID
+/// without looking at their names.
+/// </summary>
+enum class CodecId {
+  Unknown,
+  Utf8,
+  Latin1,
+  Windows1250,
+  Windows1251,
+  Windows1252,
+  Windows1253,
+  Windows1254,
+  Windows1255,
+  Windows1256,
+  Windows1257,
+  Windows1258,
+  Utf16Le,
+  Utf16Be,
+  ShiftJis,
+  Gb18030,
+};
+
+/// <summary>
+/// Finds the built-in codec ID for the given codec name (e.g. "utf-8").
+/// </summary>
+/// <returns>The codec ID, or CodecId::Unknown if there isn't one.</returns>
+CodecId GetCodecId(const std::string& name);
+
 /// <summary>
 /// Defines an interface for a text converter.  A text converter will convert
 /// between a byte buffer and a UTF-16 string.  A converter instance handles a
@@ -54,19 +84,69 @@ class TextConverter {
   virtual void Reset() = 0;
 };
 
+/// <summary>
+/// Defines a character encoding.  This creates TextConverter objects for
+/// streaming conversions and can convert complete buffers directly.
+/// </summary>
 class Codec {
  public:
-  Codec() {}
+  Codec();
   virtual ~Codec() {}
   Codec(const Codec&) = delete;
   Codec(Codec&&) = delete;
   Codec& operator=(const Codec&) = delete;
   Codec& operator=(Codec&&) = delete;
 
+  /// <summary>
+  /// Returns the built-in codec this implements, if any.  Callers can use this
+  /// to use a faster path for known encodings.
+  /// </summary>
+  virtual CodecId id() const {
+    return CodecId::Unknown;
+  }
+
   /// <summary>
   /// Returns a new instance of a converter.
   /// </summary>
   virtual std::shared_ptr<TextConverter> CreateCoder() = 0;
+
+  /// <summary>
+  /// Decodes a complete buffer and appends it to |output|.  This doesn't keep
+  /// any state between calls.  The built-in codecs report a sequence cut off
+  /// at the end as an error; the default implementation drops it.
+  ///
+  /// The built-in codecs do this without any allocations other than the
+  /// output.  The default implementation uses GetThreadCoder.
+  /// </summary>
+  virtual TextConverter::Status DecodeBuffer(const uint8_t* buffer,
+                                             size_t size,
+                                             std::u16string* output,
+                                             ErrorInfo* error);
+
+  /// <summary>
+  /// Encodes a complete buffer and appends it to |output|.  This doesn't keep
+  /// any state between calls.
+  ///
+  /// The built-in codecs do this without any allocations other than the
+  /// output.  The default implementation uses GetThreadCoder.
+  /// </summary>
+  virtual TextConverter::Status EncodeBuffer(const char16_t* buffer,
+                                             size_t size,
+                                             std::vector<uint8_t>* output,
+                                             ErrorInfo* error);
+
+  /// <summary>
+  /// Returns a converter for the calling thread that has been reset.  Each
+  /// thread keeps a few recently used converters, so repeated calls don't
+  /// allocate.  A converter is only reused once the caller has released it;
+  /// while it is held, this creates a new one.
+  /// </summary>
+  std::shared_ptr<TextConverter> GetThreadCoder();
+
+ private:
+  // Identifies this codec in the per-thread converter cache.  Unlike the
+  // address, this is never reused by another codec.
+  const uint64_t serial_;
 };
 
 /// <summary>
@@ -112,6 +192,15 @@ class CodecCollection {
   /// </summary>
   static std::shared_ptr<CodecCollection> CreateDefaultCollection();
 
+  /// <summary>
+  /// Returns the process-wide instance of the given built-in codec.  These
+  /// are created once, are immutable, and are shared with every collection
+  /// returned from CreateDefaultCollection.  This is safe to call from any
+  /// thread.
+  /// </summary>
+  /// <returns>The Codec instance, or null for CodecId::Unknown.</returns>
+  static const std::shared_ptr<Codec>& GetBuiltinCodec(CodecId id);
+
  private:
   std::unordered_map<std::string, std::shared_ptr<Codec>> codecs_;
 };
@@ -32,6 +32,7 @@ enum class ErrorKind : uint16_t {
   Unknown = 0,
   CannotOpen,
   IoError,
+  ConcurrentReadUnsupported,
 
   ShadowingType = 6000,
   ShadowingMember,
@@ -49,6 +50,15 @@ enum class ErrorKind : uint16_t {
 
   UnexpectedEndOfStream = 10000,
   LittleEndianAlign,
+  UnexpectedFieldValue,
+  VarintAlign,
+  VarintTooLong,
+  ChecksumAlign,
+  ChecksumMismatch,
+  ChecksumNoPreviousField,
+  StringAlign,
+  InvalidString,
+  StaleObject,
 
   FieldsMustBeStatic = 12000,
 };
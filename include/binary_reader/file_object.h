@@ -15,16 +15,84 @@
 #ifndef BINARY_READER_INCLUDE_FILE_OBJECT_H_
 #define BINARY_READER_INCLUDE_FILE_OBJECT_H_
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "binary_reader/error_collection.h"
+#include "binary_reader/size.h"
 #include "binary_reader/value.h"
 
 namespace binary_reader {
 
 struct FileObjectInit;
+class TypeProgram;
+
+/// <summary>
+/// Memory statistics for the strings shared while parsing a file.  See
+/// FileParserOptions::set_intern_strings.
+/// </summary>
+struct StringInternStats final {
+  /// <summary>
+  /// The number of distinct strings stored.
+  /// </summary>
+  uint64_t strings = 0;
+  /// <summary>
+  /// The number of distinct encoded forms of those strings.  This is more
+  /// than |strings| if equal strings were stored with different encodings.
+  /// </summary>
+  uint64_t encodings = 0;
+  /// <summary>
+  /// The number of strings read that reused a stored string rather than being
+  /// decoded and allocated again.
+  /// </summary>
+  uint64_t hits = 0;
+  /// <summary>
+  /// The total encoded size of the reused strings; this is the string data
+  /// that wasn't copied.
+  /// </summary>
+  uint64_t bytes_shared = 0;
+  /// <summary>
+  /// About how much memory the table itself uses.
+  /// </summary>
+  uint64_t table_bytes = 0;
+};
+
+/// <summary>
+/// Refers to a field of a type, resolved ahead of time.  Getting a field's
+/// value through a handle skips looking the name up, which helps when reading
+/// the same fields from many objects.  See FileParser::ResolveField.
+///
+/// A handle is only valid for objects of the type it was resolved from; other
+/// objects treat it as a field that doesn't exist.  Default-constructed
+/// handles don't refer to any field.
+/// </summary>
+class FieldHandle final {
+ public:
+  FieldHandle() = default;
+
+  /// <summary>
+  /// Returns whether the handle refers to a field.
+  /// </summary>
+  bool valid() const {
+    return program_ != nullptr;
+  }
+  explicit operator bool() const {
+    return valid();
+  }
+
+ private:
+  friend class FileObject;
+  friend class FileParser;
+  FieldHandle(const TypeProgram* program, size_t index)
+      : program_(program), index_(index) {}
+
+  const TypeProgram* program_ = nullptr;
+  size_t index_ = 0;
+};
 
 /// <summary>
 /// Defines a parsed object from a file.  This is an instance of a type that is
@@ -32,12 +100,20 @@ struct FileObjectInit;
 /// occurance of the object within the file; this may only cover a small part of
 /// the binary file.
 ///
+/// Child objects are only valid until their parent is reparsed.  After that,
+/// getting their fields fails with ErrorKind::StaleObject.
+///
 /// Instances of this type can only be created by the file parser and not by the
 /// app.  Instance lifetime is controlled through a std::shared_ptr.
 ///
 /// This lazy-loads the fields in the object.  The field is only parsed when
 /// requesting the field's value.  The cached values can be cleared to reduce
 /// memory usage.
+///
+/// The const methods can be called from several threads at once, including
+/// on objects from the same file.  A field read by two threads at once may be
+/// parsed twice, but both get the same value.  Reading from threads other than
+/// the one that parsed the file needs a FileReader that supports ReadAt.
 /// </summary>
 class FileObject final {
  public:
@@ -46,14 +122,65 @@ class FileObject final {
   FileObject& operator=(const FileObject&) = delete;
   FileObject& operator=(FileObject&&) = delete;
 
+  /// <summary>
+  /// Returns whether this object is still valid, i.e. none of its parents
+  /// have been reparsed since it was created.  A stale object has no fields.
+  /// </summary>
+  bool valid() const;
+
+  /// <summary>
+  /// Returns the names of the fields in the object, in declaration order.  If
+  /// more than one field has the same name, only the last one is listed.
+  /// </summary>
   std::vector<std::string> GetFieldNames() const;
 
+  /// <summary>
+  /// Calls |visit| with the name and value of each field, in the same order
+  /// as GetFieldNames.  This doesn't allocate, so it is faster than getting
+  /// the names and then each value.  This uses null for fields that can't be
+  /// read.
+  /// </summary>
+  /// <param name="visit">
+  /// Called as <code>visit(const std::string&amp; name, const Value&amp;
+  /// value)</code>.
+  /// </param>
+  template <typename Visitor>
+  void ForEachField(Visitor&& visit) const {
+    (void)ForEachFieldImpl(&CallVisitor<Visitor>, VisitorPointer(visit),
+                           nullptr);
+  }
+  /// <summary>
+  /// Calls |visit| with the name and value of each field, in the same order
+  /// as GetFieldNames.  This stops at the first field that can't be read.
+  /// </summary>
+  /// <param name="visit">
+  /// Called as <code>visit(const std::string&amp; name, const Value&amp;
+  /// value)</code>.
+  /// </param>
+  /// <param name="errors">Will be filled with any errors that happen.</param>
+  /// <returns>True on success, false on error.</returns>
+  template <typename Visitor>
+  bool ForEachField(Visitor&& visit, ErrorCollection* errors) const {
+    return ForEachFieldImpl(&CallVisitor<Visitor>, VisitorPointer(visit),
+                            errors);
+  }
+
   /// <summary>
   /// Returns whether the given field exists within the object.  This return
   /// false for fields that aren't assigned a value due to a conditional branch.
   /// </summary>
   /// <param name="name">The name of the field to get.</param>
   bool HasField(const std::string& name) const;
+  bool HasField(FieldHandle field) const;
+
+  /// <summary>
+  /// Resolves the named field of this object's type.  The handle can be used
+  /// with any other object of the same type.
+  /// </summary>
+  /// <param name="name">The name of the field to resolve.</param>
+  /// <returns>The handle, or an invalid handle if the field doesn't
+  /// exist.</returns>
+  FieldHandle ResolveField(const std::string& name) const;
 
   /// <summary>
   /// Returns the value of the given field, or null if the field doesn't exist.
@@ -61,6 +188,7 @@ class FileObject final {
   /// </summary>
   /// <param name="name">The name of the field to get.</param>
   Value GetFieldValue(const std::string& name) const;
+  Value GetFieldValue(FieldHandle field) const;
   /// <summary>
   /// Gets the value of the given field.  This returns success and uses null if
   /// the field doesn't exist.
@@ -71,13 +199,43 @@ class FileObject final {
   /// <returns>True on success, false on error.</returns>
   bool GetFieldValue(const std::string& name, Value* value,
                      ErrorCollection* errors) const;
+  bool GetFieldValue(FieldHandle field, Value* value,
+                     ErrorCollection* errors) const;
+
+  /// <summary>
+  /// Returns the values of several fields at once, using null for fields that
+  /// don't exist.  This returns all nulls if an error occurs.
+  /// </summary>
+  /// <param name="names">The names of the fields to get.</param>
+  std::vector<Value> GetFieldValues(
+      const std::vector<std::string>& names) const;
+  std::vector<Value> GetFieldValues(
+      const std::vector<FieldHandle>& fields) const;
+  /// <summary>
+  /// Gets the values of several fields at once.  This is faster than getting
+  /// them one at a time when they aren't cached, since the fields are read in
+  /// file order and nearby fields are read from the file together.
+  /// </summary>
+  /// <param name="names">The names of the fields to get.</param>
+  /// <param name="values">
+  /// Will be filled with the values, in the same order as the fields.
+  /// </param>
+  /// <param name="errors">Will be filled with any errors that happen.</param>
+  /// <returns>True on success, false on error.</returns>
+  bool GetFieldValues(const std::vector<std::string>& names,
+                      std::vector<Value>* values,
+                      ErrorCollection* errors) const;
+  bool GetFieldValues(const std::vector<FieldHandle>& fields,
+                      std::vector<Value>* values,
+                      ErrorCollection* errors) const;
 
   /// <summary>
   /// Erases any cached values stored by this object.  Fields will need to be
   /// parsed again when getting their values.  Note that if the underlying file
   /// was changed, this won't update field types/layout, only their values.  So
   /// if a conditional branch changed, the field values will be incorrect.  Use
-  /// ReparseObject to update conditional branches.
+  /// ReparseObject to update conditional branches.  This must not be called
+  /// while other threads are using the object.
   /// </summary>
   void ClearCache();
 
@@ -85,26 +243,91 @@ class FileObject final {
   /// Reparses the object to determine which fields exist.  This also clears
   /// any existing cached values.  Note that if a parent object is reparsed,
   /// this instance is no longer valid; this function invalidates any child
-  /// FileObject.
+  /// FileObject.  This must not be called while other threads are using the
+  /// object.
   /// </summary>
   /// <param name="errors">Will be filled with any errors that happen.</param>
   /// <returns>True on success, false on error.</returns>
   bool ReparseObject(ErrorCollection* errors);
 
+  /// <summary>
+  /// Gets statistics about the strings shared while parsing the file this
+  /// object belongs to.  These are all zero unless string interning was
+  /// enabled in the FileParserOptions.
+  /// </summary>
+  StringInternStats GetStringInternStats() const;
+
  private:
   friend std::shared_ptr<FileObject> MakeFileObject(const FileObjectInit&);
   friend struct FileObjectDeleter;
+  friend class RecordCursor;
+  friend class TypeDefinition;
   FileObject(const FileObjectInit& init_data);
   ~FileObject();
 
+  /// <summary>
+  /// Moves the object to the given position and parses it again, reusing
+  /// its memory.  See RecordCursor.
+  /// </summary>
+  bool ParseAt(Size start, ErrorCollection* errors);
+
+  /// <summary>
+  /// Marks the object as not laid out yet, so it is laid out when its fields
+  /// are first used.  This is only for types where laying out the object
+  /// doesn't read the file, so deferring it doesn't delay any errors.
+  /// </summary>
+  void DeferLayout(Size end_position);
+  /// <summary>
+  /// Lays out the object if that was deferred.
+  /// </summary>
+  bool EnsureLaidOut(ErrorCollection* errors) const;
+
+  /// <summary>
+  /// Gets the file position just past the end of this object.  This is only
+  /// valid after a successful call to ReparseObject.
+  /// </summary>
+  Size end_position() const;
+
   /// <summary>
   /// Ensures the field at the given index has been parsed and its value is
-  /// cached.
+  /// cached, and gets the value.  This returns the value rather than leaving
+  /// the caller to read the cache, since another thread could evict it.
+  /// </summary>
+  bool EnsureField(size_t index, Value* value, ErrorCollection* errors) const;
+
+  /// <summary>
+  /// Gets the value of the field at the given index, or null if the index is
+  /// unset.
+  /// </summary>
+  bool GetFieldValueAt(std::optional<size_t> index, Value* value,
+                       ErrorCollection* errors) const;
+  bool GetFieldValuesAt(const std::vector<std::optional<size_t>>& indices,
+                        std::vector<Value>* values,
+                        ErrorCollection* errors) const;
+
+  using FieldVisitor = void (*)(void* visitor, const std::string& name,
+                                const Value& value);
+  template <typename Visitor>
+  static void* VisitorPointer(Visitor& visitor) {
+    return const_cast<void*>(static_cast<const void*>(&visitor));
+  }
+  template <typename Visitor>
+  static void CallVisitor(void* visitor, const std::string& name,
+                          const Value& value) {
+    (*static_cast<std::remove_reference_t<Visitor>*>(visitor))(name, value);
+  }
+  /// <summary>
+  /// Implements ForEachField.  If |errors| is nullptr, fields that can't be
+  /// read are visited with null instead.
   /// </summary>
-  bool EnsureField(size_t index, ErrorCollection* errors) const;
+  bool ForEachFieldImpl(FieldVisitor callback, void* visitor,
+                        ErrorCollection* errors) const;
 
   struct Impl;
-  std::unique_ptr<Impl> impl_;
+  struct ImplDeleter final {
+    void operator()(Impl* impl) const;
+  };
+  std::unique_ptr<Impl, ImplDeleter> impl_;
 };
 
 }  // namespace binary_reader
@@ -22,6 +22,7 @@
 #include "binary_reader/error_collection.h"
 #include "binary_reader/file_object.h"
 #include "binary_reader/file_system.h"
+#include "binary_reader/record_cursor.h"
 
 namespace binary_reader {
 
@@ -45,6 +46,50 @@ class FileParserOptions final {
   /// </summary>
   std::shared_ptr<FileSystem> file_system;
 
+  /// <summary>
+  /// Whether to share one copy of each short string read from a file.  This
+  /// saves memory and decoding time for formats that repeat the same strings
+  /// (e.g. tag names or labels) many times, and makes comparing them cheap.
+  /// The savings can be seen with FileObject::GetStringInternStats.  This
+  /// defaults to false.
+  /// </summary>
+  bool intern_strings() const;
+  void set_intern_strings(bool intern);
+
+  /// <summary>
+  /// Whether to allocate the objects and values of each parsed file from a
+  /// per-file arena.  This makes creating and freeing large object trees
+  /// faster, since the memory is released all at once when the last object
+  /// or value from the file is dropped.  Memory freed before then (e.g. by
+  /// FileObject::ClearCache) isn't reused, so this is best when the whole
+  /// tree is read and then dropped.  This defaults to false.
+  /// </summary>
+  bool use_arena() const;
+  void set_use_arena(bool use_arena);
+
+  /// <summary>
+  /// About how many bytes of field values (including child objects) each
+  /// parsed file can keep cached.  Once this is exceeded, the values that
+  /// were used least recently are dropped from their objects and are read
+  /// from the file again when next needed.  Values held by the app stay
+  /// valid, but getting an evicted child object again returns a new
+  /// FileObject.  This defaults to 0, which means no limit.
+  ///
+  /// Memory from an arena (see use_arena) isn't reused, so this only limits
+  /// the memory held by the objects when the arena isn't used.
+  /// </summary>
+  uint64_t cache_budget() const;
+  void set_cache_budget(uint64_t bytes);
+
+  /// <summary>
+  /// Whether to read every field of each object as soon as the object is
+  /// parsed, rather than when the field is first used.  This reads the file
+  /// front to back in one pass, which is faster when the whole file will be
+  /// used (e.g. to dump it).  This defaults to false.
+  /// </summary>
+  bool eager_decode() const;
+  void set_eager_decode(bool eager);
+
  private:
   // For forward compatibility. This allows adding new options through member
   // methods since we can't add fields without breaking ABI.
@@ -118,6 +163,17 @@ class FileParser final {
   /// </summary>
   std::vector<std::string> GetTypeNames() const;
 
+  /// <summary>
+  /// Resolves a field of one of the top-level types so its value can be read
+  /// from many objects without looking up the name each time.
+  /// </summary>
+  /// <param name="type">The name of the type containing the field.</param>
+  /// <param name="field">The name of the field.</param>
+  /// <returns>The handle, or an invalid handle if either name isn't
+  /// found.</returns>
+  FieldHandle ResolveField(const std::string& type,
+                           const std::string& field) const;
+
   /// <summary>
   /// Parses the given binary file and creates a FileObject for it.
   /// </summary>
@@ -150,6 +206,27 @@ class FileParser final {
                                         const std::string& type,
                                         ErrorCollection* errors);
 
+  /// <summary>
+  /// Opens the given binary file as a series of records of the given type,
+  /// stored back to back until the end of the file.  This doesn't parse any
+  /// records until RecordCursor::Next is called.
+  /// </summary>
+  /// <param name="path">The path to the binary file to read.</param>
+  /// <param name="type">The type name of each record.</param>
+  /// <param name="reader">The object to read the binary file from.</param>
+  /// <param name="errors">A list to hold the errors that happen.</param>
+  /// <returns>The cursor over the records, or nullptr on error.</returns>
+  std::unique_ptr<RecordCursor> ParseRecords(const std::string& path,
+                                             const std::string& type);
+  std::unique_ptr<RecordCursor> ParseRecords(const std::string& path,
+                                             const std::string& type,
+                                             ErrorCollection* errors);
+  std::unique_ptr<RecordCursor> ParseRecords(
+      std::shared_ptr<FileReader> reader, const std::string& type);
+  std::unique_ptr<RecordCursor> ParseRecords(
+      std::shared_ptr<FileReader> reader, const std::string& type,
+      ErrorCollection* errors);
+
  private:
   struct Impl;
   FileParser(std::unique_ptr<Impl> impl);
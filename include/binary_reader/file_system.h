@@ -29,7 +29,7 @@ namespace binary_reader {
 /// outside this object and their size cannot change at all.  The file position
 /// must be clamped to within the existing file data.
 ///
-/// This type is not thread-safe.
+/// This type is not thread-safe, except for ReadAt.
 /// </summary>
 class FileReader {
  public:
@@ -82,6 +82,37 @@ class FileReader {
   /// <returns>True on success, false on error.</returns>
   virtual bool Seek(uint64_t* position, ErrorCollection* errors) = 0;
 
+  /// <summary>
+  /// Returns whether ReadAt is supported.  This cannot change during the
+  /// lifetime of the object.
+  /// </summary>
+  virtual bool can_read_at() const {
+    return false;
+  }
+
+  /// <summary>
+  /// Reads bytes from the given absolute byte position, without using or
+  /// changing the current position.  This is used to read the file from
+  /// several threads at once, so it must be safe to call from any number of
+  /// threads, even while another thread is using Read and Seek.  This can
+  /// read less bytes than asked for, but must read at least one byte unless
+  /// at EOF.
+  ///
+  /// The default implementation doesn't support this and always fails.
+  /// </summary>
+  /// <param name="position">The position to read from.</param>
+  /// <param name="buffer">An output buffer to copy bytes into.</param>
+  /// <param name="size">
+  /// On input, contains the number of bytes to read; on output, it should be
+  /// updated to the number of bytes read.
+  /// </param>
+  /// <param name="error">
+  /// On error, will be filled with the error description.
+  /// </param>
+  /// <returns>True on success, false on error.</returns>
+  virtual bool ReadAt(uint64_t position, uint8_t* buffer, size_t* size,
+                      ErrorCollection* errors);
+
   /// <summary>
   /// Reads the whole file into the given buffer.  The current file position is
   /// ignored and will be seeked to the end of the file.  Any existing data in
@@ -15,9 +15,9 @@
 #ifndef BINARY_READER_INCLUDE_NUMBER_H_
 #define BINARY_READER_INCLUDE_NUMBER_H_
 
+#include <cstdint>
 #include <iostream>
 #include <type_traits>
-#include <variant>
 
 namespace binary_reader {
 
@@ -26,6 +26,9 @@ namespace binary_reader {
 /// max sized integer or double and converts between them as needed.  Values are
 /// compared by value, the signedness is handled like you'd expect of normal
 /// numbers.
+///
+/// This is trivially copyable and stores the number inline, so it can be
+/// passed by value and packed into a Value without any allocations.
 /// </summary>
 class Number final {
  public:
@@ -33,28 +36,25 @@ class Number final {
   template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
   explicit Number(T value) {
     if constexpr (std::is_floating_point_v<T>) {
-      value_ = static_cast<double>(value);
+      type_ = NumberType::Double;
+      double_ = static_cast<double>(value);
     } else if constexpr (std::is_signed_v<T>) {
-      if (value < 0)
-        value_ = static_cast<intmax_t>(value);
-      else
-        value_ = static_cast<uintmax_t>(value);
+      if (value < 0) {
+        type_ = NumberType::SignedInt;
+        signed_ = static_cast<intmax_t>(value);
+      } else {
+        type_ = NumberType::UnsignedInt;
+        unsigned_ = static_cast<uintmax_t>(value);
+      }
     } else {
-      value_ = static_cast<uintmax_t>(value);
+      type_ = NumberType::UnsignedInt;
+      unsigned_ = static_cast<uintmax_t>(value);
     }
   }
-  ~Number();
-
-  Number(const Number&);
-  Number(Number&&) noexcept;
-  Number& operator=(const Number&);
-  Number& operator=(Number&&) noexcept;
-
-  template <typename T>
-  Number& operator=(T&& value) {
-    Number temp{std::forward<T>(value)};
-    swap(value_, temp.value_);
-    return *this;
+
+  template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+  Number& operator=(T value) {
+    return *this = Number{value};
   }
 
   operator bool() const;
@@ -82,19 +82,31 @@ class Number final {
   double as_double() const;
 
  private:
-  enum class NumberType {
+  friend class Value;
+
+  enum class NumberType : uint8_t {
     UnsignedInt,
     SignedInt,
     Double,
   };
 
-  NumberType number_type() const;
+  NumberType number_type() const {
+    return type_;
+  }
 
   // Note that intmax_t is only used for negative values; positive integers
   // always use uintmax_t
-  std::variant<uintmax_t, intmax_t, double> value_;
+  union {
+    uintmax_t unsigned_;
+    intmax_t signed_;
+    double double_;
+  };
+  NumberType type_;
 };
 
+static_assert(std::is_trivially_copyable_v<Number>,
+              "Number must be trivially copyable");
+
 std::ostream& operator<<(std::ostream& os, const Number& value);
 
 }  // namespace binary_reader
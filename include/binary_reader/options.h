@@ -22,6 +22,7 @@
 #include <unordered_set>
 
 #include "binary_reader/cloneable_unique_ptr.h"
+#include "binary_reader/codecs.h"
 #include "binary_reader/utf_string.h"
 
 namespace binary_reader {
@@ -32,6 +33,12 @@ enum class OptionType : uint16_t {
   Unknown = 0,
   Signedness,
   ByteOrder,
+  ChecksumRange,
+  /// <summary>
+  /// The text encoding of a string; the values are CodecId, where
+  /// CodecId::Unknown means unset.
+  /// </summary>
+  Encoding,
 };
 
 enum class Signedness : uint16_t {
@@ -46,9 +53,24 @@ enum class ByteOrder : uint16_t {
   BigEndian,  // aka "network"
 };
 
+enum class ChecksumRange : uint16_t {
+  Unset = 0,
+  /// <summary>
+  /// Covers the object from its start up to the checksum field.
+  /// </summary>
+  Object,
+  /// <summary>
+  /// Covers only the field just before the checksum field, e.g. a payload
+  /// followed by its CRC.  It is an error for the checksum to be the first
+  /// field.
+  /// </summary>
+  PreviousField,
+};
+
 std::string to_string(OptionType type);
 std::string to_string(Signedness signedness);
 std::string to_string(ByteOrder byte_order);
+std::string to_string(ChecksumRange range);
 
 inline std::ostream& operator<<(std::ostream& os, OptionType opt) {
   return os << to_string(opt);
@@ -59,6 +81,9 @@ inline std::ostream& operator<<(std::ostream& os, Signedness opt) {
 inline std::ostream& operator<<(std::ostream& os, ByteOrder opt) {
   return os << to_string(opt);
 }
+inline std::ostream& operator<<(std::ostream& os, ChecksumRange opt) {
+  return os << to_string(opt);
+}
 
 OptionType GetOptionType(const UtfString& type);
 
@@ -144,6 +169,21 @@ class Options final {
         return default_;
       else
         return byte_order;
+    } else if constexpr (std::is_same<T, ChecksumRange>::value) {
+      const Options* self = this;
+      auto ret = std::any_cast<ChecksumRange>(
+          self->GetOption(OptionType::ChecksumRange));
+      if (ret == ChecksumRange::Unset)
+        return default_;
+      else
+        return ret;
+    } else if constexpr (std::is_same<T, CodecId>::value) {
+      const Options* self = this;
+      auto ret = std::any_cast<CodecId>(self->GetOption(OptionType::Encoding));
+      if (ret == CodecId::Unknown)
+        return default_;
+      else
+        return ret;
     } else {
       // Must depend on T to work correctly
       static_assert(!std::is_same<T, T>::value, "Unknown option type");
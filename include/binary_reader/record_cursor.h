@@ -0,0 +1,74 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BINARY_READER_INCLUDE_RECORD_CURSOR_H_
+#define BINARY_READER_INCLUDE_RECORD_CURSOR_H_
+
+#include <memory>
+
+#include "binary_reader/error_collection.h"
+#include "binary_reader/file_object.h"
+
+namespace binary_reader {
+
+struct RecordCursorInit;
+
+/// <summary>
+/// Reads a file that holds records of one type stored back to back, one
+/// record at a time.  Use FileParser::ParseRecords to create one.
+///
+/// The same FileObject is reused for each record, so scanning a file doesn't
+/// allocate a new object per record.  If the app keeps a reference to the
+/// current record, the next record gets a new object instead, so the kept
+/// object stays valid.  Child objects read from a reused record become stale
+/// when it moves to the next record, like when reparsing any other object.
+///
+/// This type is not thread-safe, but the records can be shared with other
+/// threads like any other FileObject (which keeps them from being reused).
+/// </summary>
+class RecordCursor final {
+ public:
+  RecordCursor(const RecordCursor&) = delete;
+  RecordCursor(RecordCursor&&) = delete;
+  RecordCursor& operator=(const RecordCursor&) = delete;
+  RecordCursor& operator=(RecordCursor&&) = delete;
+  ~RecordCursor();
+
+  /// <summary>
+  /// Moves to the next record.  This returns false at the end of the file,
+  /// or if the record can't be parsed; use |errors| to tell these apart.
+  /// </summary>
+  /// <param name="errors">Will be filled with any errors that happen.</param>
+  /// <returns>True if there is a record, false otherwise.</returns>
+  bool Next();
+  bool Next(ErrorCollection* errors);
+
+  /// <summary>
+  /// Gets the current record, or nullptr before the first call to Next or
+  /// after Next returns false.
+  /// </summary>
+  const std::shared_ptr<FileObject>& record() const;
+
+ private:
+  friend std::unique_ptr<RecordCursor> MakeRecordCursor(
+      const RecordCursorInit&);
+  explicit RecordCursor(const RecordCursorInit& init);
+
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace binary_reader
+
+#endif  // BINARY_READER_INCLUDE_RECORD_CURSOR_H_
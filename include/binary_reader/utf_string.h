@@ -19,6 +19,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <variant>
 #include <vector>
 
 #include "binary_reader/error.h"
@@ -30,35 +31,37 @@ class Codec;
 /// <summary>
 /// Defines a Unicode-aware string type that supports converting between
 /// different character encodings.
+///
+/// The string keeps whichever representation it was created with (UTF-8 or
+/// UTF-16) and only transcodes when the other one is requested.  Strings are
+/// compared by code point, so the representation doesn't affect equality or
+/// ordering.
 /// </summary>
 class UtfString final {
  public:
   UtfString();
   explicit UtfString(const std::u16string& str);
+  explicit UtfString(std::u16string&& str);
   ~UtfString();
   UtfString(const UtfString&);
   UtfString(UtfString&&);
   UtfString& operator=(const UtfString&);
   UtfString& operator=(UtfString&&);
 
-  bool operator==(const UtfString& other) const {
-    return utf16_buffer_ == other.utf16_buffer_;
-  }
-  bool operator!=(const UtfString& other) const {
-    return utf16_buffer_ != other.utf16_buffer_;
-  }
+  bool operator==(const UtfString& other) const;
+  bool operator<(const UtfString& other) const;
 
-  bool operator<(const UtfString& other) const {
-    return utf16_buffer_ < other.utf16_buffer_;
+  bool operator!=(const UtfString& other) const {
+    return !(*this == other);
   }
   bool operator<=(const UtfString& other) const {
-    return utf16_buffer_ <= other.utf16_buffer_;
+    return !(other < *this);
   }
   bool operator>(const UtfString& other) const {
-    return utf16_buffer_ > other.utf16_buffer_;
+    return other < *this;
   }
   bool operator>=(const UtfString& other) const {
-    return utf16_buffer_ >= other.utf16_buffer_;
+    return !(*this < other);
   }
 
   /// <summary>
@@ -70,13 +73,16 @@ class UtfString final {
   /// <param name="error">Will be filled with any errors that happen.</param>
   /// <returns>The resulting string.</returns>
   static UtfString FromEncoding(const uint8_t* bytes, size_t size,
-                                std::shared_ptr<Codec> codec, ErrorInfo* error);
+                                const std::shared_ptr<Codec>& codec,
+                                ErrorInfo* error);
   static UtfString FromEncoding(const char* bytes, size_t size,
-                                std::shared_ptr<Codec> codec, ErrorInfo* error);
+                                const std::shared_ptr<Codec>& codec,
+                                ErrorInfo* error);
 
   /// <summary>
-  /// Converts the given UTF-8 encoded string into a UtfString.  This uses the
-  /// built-in decoder and uses replacement characters for errors.
+  /// Converts the given UTF-8 encoded string into a UtfString.  Well-formed
+  /// input is stored as-is without decoding; otherwise this uses the built-in
+  /// decoder.
   ///
   /// Care should be taken when using this function as the input may not
   /// actually be UTF-8.  This is especially true on Windows, where it will
@@ -84,17 +90,18 @@ class UtfString final {
   /// </summary>
   /// <param name="str">The string to convert.</param>
   /// <returns>The converted string.</returns>
-  static UtfString FromUtf8(const std::string& str);
+  static UtfString FromUtf8(std::string str);
 
   /// <summary>
   /// Converts the current string to bytes using the given Codec.
   /// </summary>
-  std::vector<uint8_t> AsBytes(std::shared_ptr<Codec> codec,
+  std::vector<uint8_t> AsBytes(const std::shared_ptr<Codec>& codec,
                                ErrorInfo* error) const;
 
   /// <summary>
-  /// Converts the current string to a UTF-8 encoded string.  This uses the
-  /// built-in decoder and uses replacement characters for errors.
+  /// Converts the current string to a UTF-8 encoded string.  If the string
+  /// was created from UTF-8, this returns the original bytes; otherwise this
+  /// uses the built-in encoder.
   ///
   /// Care should be taken when using this function as the output may not
   /// be using UTF-8.  This is especially true on Windows, where it will
@@ -104,25 +111,49 @@ class UtfString final {
   std::string AsUtf8() const;
 
   /// <summary>
-  /// Converts the current string to a UTF-16 encoded string.  Since this type
-  /// uses UTF-16 internally, this will be the exact value, even with errors.
+  /// Converts the current string to a UTF-16 encoded string.  If the string
+  /// was created from UTF-16, this will be the exact value, even with errors.
   ///
   /// On Windows, this should be usable for Unicode methods (e.g. CreateFileW).
   /// </summary>
   /// <returns>The converted string.</returns>
-  std::u16string AsUtf16() const {
-    return utf16_buffer_;
-  }
+  std::u16string AsUtf16() const;
 
   /// <summary>
   /// Returns whether the string is empty.
   /// </summary>
   bool empty() const {
-    return utf16_buffer_.empty();
+    return is_utf8() ? utf8().empty() : utf16().empty();
+  }
+
+  /// <summary>
+  /// Returns a hash of the string.  Equal strings have the same hash, no
+  /// matter how they are stored.
+  /// </summary>
+  size_t hash() const;
+
+  /// <summary>
+  /// Returns about how many bytes of memory the string's characters use.
+  /// </summary>
+  size_t memory_size() const {
+    return is_utf8() ? utf8().capacity() : utf16().capacity() * 2;
   }
 
  private:
-  std::u16string utf16_buffer_;
+  friend std::ostream& operator<<(std::ostream& os, const UtfString& str);
+
+  bool is_utf8() const {
+    return buffer_.index() == 0;
+  }
+  const std::string& utf8() const {
+    return std::get<std::string>(buffer_);
+  }
+  const std::u16string& utf16() const {
+    return std::get<std::u16string>(buffer_);
+  }
+
+  // UTF-8 buffers are always well-formed; anything else is stored as UTF-16.
+  std::variant<std::string, std::u16string> buffer_;
 };
 
 std::ostream& operator<<(std::ostream& os, const UtfString& str);
@@ -132,7 +163,7 @@ std::ostream& operator<<(std::ostream& os, const UtfString& str);
 template <>
 struct std::hash<binary_reader::UtfString> {
   std::size_t operator()(const binary_reader::UtfString& str) const noexcept {
-    return std::hash<std::u16string>()(str.AsUtf16());
+    return str.hash();
   }
 };
 
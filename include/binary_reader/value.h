@@ -15,6 +15,9 @@
 #ifndef BINARY_READER_INCLUDE_VALUE_H_
 #define BINARY_READER_INCLUDE_VALUE_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <type_traits>
@@ -25,6 +28,7 @@
 
 namespace binary_reader {
 
+class Arena;
 class FileObject;
 
 enum class ValueType {
@@ -41,42 +45,66 @@ std::ostream& operator<<(std::ostream& os, ValueType value);
 /// similar to std::any, although the list of types it can be is fixed.  When
 /// accessing the value, the stored type must match the requested format; this
 /// will not convert values.
+///
+/// Values are stored as a 16-byte tagged cell.  Null and numbers are stored
+/// inline and are copied bitwise.  Strings and objects are stored in a
+/// reference-counted payload, so copying them only bumps a counter.
 /// </summary>
 class Value final {
  public:
-  Value();
-  template <typename T, typename = std::enable_if_t<
-                            !std::is_same_v<std::decay_t<T>, Value> &&
-                            !std::is_arithmetic_v<std::decay_t<T>>>>
-  explicit Value(T&& value) : value_(std::forward<T>(value)) {}
+  Value() : bits_(0), tag_(Tag::Null) {}
+  explicit Value(std::nullptr_t) : Value() {}
+  explicit Value(Number value) {
+    SetNumber(value);
+  }
   template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
-  explicit Value(T value) : value_(Number(value)) {}
-  Value(const Value&);
-  Value(Value&&);
-  ~Value();
+  explicit Value(T value) : Value(Number(value)) {}
+  explicit Value(const UtfString& value);
+  explicit Value(UtfString&& value);
+  explicit Value(std::shared_ptr<FileObject> value);
+  /// <summary>
+  /// Creates a string or object value whose payload is allocated from the
+  /// given arena, which the value keeps alive.  If |arena| is nullptr, this
+  /// is the same as the constructors above.
+  /// </summary>
+  Value(UtfString&& value, const std::shared_ptr<Arena>& arena);
+  Value(std::shared_ptr<FileObject> value,
+        const std::shared_ptr<Arena>& arena);
+  Value(const Value& other) : bits_(other.bits_), tag_(other.tag_) {
+    AddRef();
+  }
+  Value(Value&& other) noexcept : bits_(other.bits_), tag_(other.tag_) {
+    other.tag_ = Tag::Null;
+  }
+  ~Value() {
+    Release();
+  }
 
-  Value& operator=(const Value&);
-  Value& operator=(Value&&);
+  Value& operator=(const Value& other) {
+    other.AddRef();
+    Release();
+    bits_ = other.bits_;
+    tag_ = other.tag_;
+    return *this;
+  }
+  Value& operator=(Value&& other) noexcept {
+    if (this != &other) {
+      Release();
+      bits_ = other.bits_;
+      tag_ = other.tag_;
+      other.tag_ = Tag::Null;
+    }
+    return *this;
+  }
 
   template <typename T, typename = std::enable_if_t<
                             !std::is_same_v<std::decay_t<T>, Value>>>
   Value& operator=(T&& value) {
-    if constexpr (std::is_same_v<std::decay_t<T>, std::nullptr_t>)
-      value_ = std::monostate();
-    else
-      value_ = std::move(value);
-    return *this;
+    return *this = Value(std::forward<T>(value));
   }
 
-  bool operator==(const Value& other) const {
-    // TODO: Consider adding comparing objects.
-    return value_ == other.value_;
-  }
-  bool operator<(const Value& other) const {
-    // Since earlier variant entries are less than later elements, this
-    // comparison is what we want.
-    return value_ < other.value_;
-  }
+  bool operator==(const Value& other) const;
+  bool operator<(const Value& other) const;
 
   bool operator!=(const Value& other) const {
     return !(*this == other);
@@ -92,30 +120,98 @@ class Value final {
   }
 
   ValueType value_type() const {
-    return static_cast<ValueType>(value_.index());
+    switch (tag_) {
+      case Tag::Null:
+        return ValueType::Null;
+      case Tag::String:
+        return ValueType::String;
+      case Tag::Object:
+        return ValueType::Object;
+      default:
+        return ValueType::Number;
+    }
   }
 
   Number as_number() const {
-    return std::get<Number>(value_);
+    if (value_type() != ValueType::Number)
+      throw std::bad_variant_access();
+    Number ret;
+    ret.type_ = static_cast<Number::NumberType>(
+        static_cast<uint8_t>(tag_) - static_cast<uint8_t>(Tag::Unsigned));
+    std::memcpy(&ret.unsigned_, &bits_, sizeof(bits_));
+    return ret;
+  }
+  /// <summary>
+  /// Gets the string, which is shared by every copy of the value.  The
+  /// reference is only valid while the value is, so a temporary value
+  /// returns a copy instead.
+  /// </summary>
+  const UtfString& as_string() const&;
+  UtfString as_string() &&;
+  std::shared_ptr<FileObject> as_object() const;
+
+  /// <summary>
+  /// Returns a hash of the value.  Equal values have the same hash.  A
+  /// string's hash is computed once and shared by every copy of the value.
+  /// </summary>
+  size_t hash() const;
+
+  /// <summary>
+  /// Returns about how many bytes of memory the value uses outside of the
+  /// Value itself.  This doesn't include the memory used by an object.
+  /// </summary>
+  size_t memory_size() const;
+
+ private:
+  // Number tags must be in the same order as Number::NumberType.
+  enum class Tag : uint8_t {
+    Null,
+    Unsigned,
+    Signed,
+    Double,
+    String,
+    Object,
+  };
+  struct Payload;
+  struct StringPayload;
+  struct ObjectPayload;
+
+  void SetNumber(Number value) {
+    tag_ = static_cast<Tag>(static_cast<uint8_t>(Tag::Unsigned) +
+                            static_cast<uint8_t>(value.number_type()));
+    std::memcpy(&bits_, &value.unsigned_, sizeof(bits_));
+  }
+  bool has_payload() const {
+    return tag_ >= Tag::String;
   }
-  UtfString as_string() const {
-    return std::get<UtfString>(value_);
+  void AddRef() const {
+    if (has_payload())
+      AddRefPayload(payload_);
   }
-  std::shared_ptr<FileObject> as_object() const {
-    return std::get<std::shared_ptr<FileObject>>(value_);
+  void Release() {
+    if (has_payload())
+      ReleasePayload(payload_, tag_);
   }
 
- private:
-  // Order and types must match ValueType enum.
-  std::variant<std::monostate, Number, UtfString, std::shared_ptr<FileObject>>
-      value_;
+  static void AddRefPayload(Payload* payload);
+  static void ReleasePayload(Payload* payload, Tag tag);
+
+  union {
+    uintmax_t bits_;
+    Payload* payload_;
+  };
+  Tag tag_;
 };
 
-// Define a custom compare for monostate so we can use variant operator<
-inline bool operator<(std::monostate, std::monostate) {
-  return false;
-}
+static_assert(sizeof(Value) == 16, "Value should be a 16-byte cell");
 
 }  // namespace binary_reader
 
+template <>
+struct std::hash<binary_reader::Value> {
+  std::size_t operator()(const binary_reader::Value& value) const noexcept {
+    return value.hash();
+  }
+};
+
 #endif  // BINARY_READER_INCLUDE_VALUE_H_
@@ -36,6 +36,8 @@ bool CommandLine::Parse(const char** argv, int argc) {
     definition_path = definition.getValue();
     binary_path = input.getValue();
     type_name = type.getValue();
+    // The whole file is dumped, so read it in one pass.
+    parser_options.set_eager_decode(true);
     return true;
   } catch (TCLAP::ArgException& e) {
     std::cout << "FATAL ERROR: " << e.error() << " for arg " << e.argId()
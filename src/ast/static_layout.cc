@@ -0,0 +1,115 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ast/static_layout.h"
+
+#include "ast/field_info.h"
+#include "ast/type_info.h"
+#include "util/bits.h"
+#include "util/float_conversion.h"
+
+namespace binary_reader {
+
+std::unique_ptr<StaticLayout> StaticLayout::Create(
+    const std::vector<std::shared_ptr<Statement>>& statements) {
+  std::vector<Op> ops;
+  Size offset;
+  for (size_t i = 0; i < statements.size(); i++) {
+    auto field = std::dynamic_pointer_cast<FieldInfo>(statements[i]);
+    if (!field || !field->type() || !field->type()->static_size())
+      return nullptr;
+
+    const uint64_t bits = field->type()->static_size()->bit_count();
+    Op op{Kind::Unsigned, ByteOrder::Unset, static_cast<uint8_t>(bits), 1, i,
+          offset.bit_count()};
+    if (auto* integer =
+            dynamic_cast<const IntegerTypeInfo*>(field->type().get())) {
+      op.kind = integer->signedness() == Signedness::Signed ? Kind::Signed
+                                                            : Kind::Unsigned;
+      op.order = integer->byte_order();
+    } else if (auto* real =
+                   dynamic_cast<const FloatTypeInfo*>(field->type().get())) {
+      op.kind = Kind::Float;
+      op.order = real->byte_order();
+    } else {
+      return nullptr;
+    }
+    // Unaligned little endian values are an error, so let the normal read
+    // path report that.
+    if (op.order == ByteOrder::LittleEndian &&
+        (offset.bit_offset() != 0 || bits % 8 != 0)) {
+      return nullptr;
+    }
+
+    // Merge adjacent floats of the same format into one run.
+    if (op.kind == Kind::Float && offset.bit_offset() == 0 && !ops.empty()) {
+      Op& prev = ops.back();
+      if (prev.kind == Kind::Float && prev.order == op.order &&
+          prev.bit_size == op.bit_size && prev.bit_offset % 8 == 0 &&
+          prev.bit_offset + prev.count * prev.bit_size == op.bit_offset) {
+        prev.count++;
+        offset += Size::FromBits(bits);
+        continue;
+      }
+    }
+
+    ops.push_back(op);
+    offset += Size::FromBits(bits);
+  }
+
+  return std::unique_ptr<StaticLayout>(
+      new StaticLayout(std::move(ops), offset));
+}
+
+StaticLayout::StaticLayout(std::vector<Op> ops, Size size)
+    : ops_(std::move(ops)), size_(size) {}
+
+Number StaticLayout::DecodeInteger(const Op& op, const uint8_t* buffer) {
+  const uint8_t* start = buffer + op.bit_offset / 8;
+  const uint8_t bit_offset = static_cast<uint8_t>(op.bit_offset % 8);
+  uint64_t value = LoadBits(start, bit_offset, op.bit_size, op.order);
+  if (op.kind == Kind::Signed && (value & (1ull << (op.bit_size - 1)))) {
+    if (op.bit_size != 64)
+      value |= ~((1ull << op.bit_size) - 1);
+    return Number{static_cast<int64_t>(value)};
+  }
+  return Number{value};
+}
+
+void StaticLayout::DecodeFloats(const Op& op, const uint8_t* buffer,
+                                size_t first, size_t count, double* output) {
+  const uint64_t start_bit = op.bit_offset + first * op.bit_size;
+  if (start_bit % 8 == 0) {
+    const uint8_t* start = buffer + start_bit / 8;
+    switch (op.bit_size) {
+      case 16:
+        DecodeFloat16Array(start, count, op.order, output);
+        return;
+      case 32:
+        DecodeFloat32Array(start, count, op.order, output);
+        return;
+      default:
+        DecodeFloat64Array(start, count, op.order, output);
+        return;
+    }
+  }
+
+  // Unaligned (big endian) floats are only single fields.
+  const uint64_t bits = LoadBits(buffer + start_bit / 8,
+                                 static_cast<uint8_t>(start_bit % 8),
+                                 op.bit_size, op.order);
+  *output = FloatBitsToDouble(bits, op.bit_size);
+}
+
+}  // namespace binary_reader
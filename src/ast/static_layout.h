@@ -0,0 +1,110 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BINARY_READER_AST_STATIC_LAYOUT_H_
+#define BINARY_READER_AST_STATIC_LAYOUT_H_
+
+#include <memory>
+#include <vector>
+
+#include "ast/ast_base.h"
+#include "binary_reader/number.h"
+#include "binary_reader/options.h"
+#include "binary_reader/size.h"
+
+namespace binary_reader {
+
+/// <summary>
+/// A precomputed, flat decoding program for a type whose fields are all
+/// fixed-size numbers.  This allows decoding every field of an object from a
+/// single buffer without going through the per-field TypeInfoBase::ReadValue
+/// calls and the reader seeks between them.
+/// </summary>
+class StaticLayout final {
+ public:
+  /// <summary>
+  /// Creates the layout for the given type statements.  This returns nullptr
+  /// if any of the fields can't be decoded directly (e.g. nested types).
+  /// </summary>
+  static std::unique_ptr<StaticLayout> Create(
+      const std::vector<std::shared_ptr<Statement>>& statements);
+
+  /// <summary>
+  /// The total size of all the fields.
+  /// </summary>
+  Size size() const {
+    return size_;
+  }
+
+  /// <summary>
+  /// Decodes every field from the given buffer.  The buffer must start at
+  /// the (byte aligned) start of the object and contain size() bits.  The
+  /// |sink| is called with the field index and value for each field, in
+  /// field order.
+  /// </summary>
+  template <typename Sink>
+  void Decode(const uint8_t* buffer, Sink&& sink) const {
+    for (const auto& op : ops_) {
+      if (op.kind != Kind::Float) {
+        sink(op.field_index, DecodeInteger(op, buffer));
+        continue;
+      }
+
+      double temp[kFloatChunkSize];
+      for (size_t done = 0; done < op.count; done += kFloatChunkSize) {
+        const size_t count = op.count - done < kFloatChunkSize
+                                 ? op.count - done
+                                 : kFloatChunkSize;
+        DecodeFloats(op, buffer, done, count, temp);
+        for (size_t i = 0; i < count; i++)
+          sink(op.field_index + done + i, Number{temp[i]});
+      }
+    }
+  }
+
+ private:
+  enum class Kind : uint8_t {
+    Unsigned,
+    Signed,
+    Float,
+  };
+
+  /// <summary>
+  /// A single decode step.  Float ops can cover a run of adjacent fields with
+  /// the same format so they can use the SIMD array decoders.
+  /// </summary>
+  struct Op {
+    Kind kind;
+    ByteOrder order;
+    uint8_t bit_size;
+    size_t count;
+    size_t field_index;
+    uint64_t bit_offset;
+  };
+
+  static constexpr const size_t kFloatChunkSize = 16;
+
+  StaticLayout(std::vector<Op> ops, Size size);
+
+  static Number DecodeInteger(const Op& op, const uint8_t* buffer);
+  static void DecodeFloats(const Op& op, const uint8_t* buffer, size_t first,
+                           size_t count, double* output);
+
+  const std::vector<Op> ops_;
+  const Size size_;
+};
+
+}  // namespace binary_reader
+
+#endif  // BINARY_READER_AST_STATIC_LAYOUT_H_
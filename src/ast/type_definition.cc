@@ -46,20 +46,43 @@ TypeDefinition::TypeDefinition(
     std::vector<std::shared_ptr<Statement>> statements)
     : TypeInfoBase(debug, name, name, CalculateSize(statements)),
       Statement(debug),
-      statements_(std::move(statements)) {}
+      statements_(std::move(statements)),
+      static_layout_(StaticLayout::Create(statements_)),
+      program_(TypeProgram::Compile(statements_)) {}
 
-bool TypeDefinition::ReadValue(std::shared_ptr<BufferedFileReader> reader,
-                               Value* result, ErrorCollection* errors) const {
+TypeDefinition::TypeDefinition(
+    const DebugInfo& debug, const std::string& name,
+    std::vector<std::shared_ptr<Statement>> statements,
+    std::shared_ptr<const StaticLayout> static_layout,
+    std::shared_ptr<const TypeProgram> program)
+    : TypeInfoBase(debug, name, name, CalculateSize(statements)),
+      Statement(debug),
+      statements_(std::move(statements)),
+      static_layout_(std::move(static_layout)),
+      program_(std::move(program)) {}
+
+bool TypeDefinition::ReadValue(const ReadContext& ctx, Value* result) const {
   FileObjectInit init;
-  init.file = reader;
+  init.state = ctx.state()->shared_from_this();
   init.type = shared_from_this();
-  init.start_position = reader->position();
+  init.start_position = ctx.reader()->position();
+  if (const auto& parent = ctx.parent()) {
+    init.parent = parent;
+    init.parent_count = parent->count();
+  }
 
   auto ret = MakeFileObject(init);
-  if (!ret->ReparseObject(errors))
+  ctx.stats()->objects_created++;
+  if (!program_->reads_file() && !ctx.state()->eager_decode()) {
+    // Laying out the object doesn't read anything, so wait until the fields
+    // are used; this is often never for objects that are skipped over.
+    ret->DeferLayout(init.start_position + *static_size());
+  } else if (!ret->ReparseObject(ctx.errors())) {
     return false;
-  *result = ret;
-  return reader->Seek(init.start_position + *static_size(), errors);
+  }
+  const Size end = ret->end_position();
+  *result = Value{std::move(ret), ctx.arena()};
+  return ctx.reader()->Seek(end, ctx.errors());
 }
 
 std::unordered_set<OptionType> TypeDefinition::GetOptionTypes() const {
@@ -68,7 +91,10 @@ std::unordered_set<OptionType> TypeDefinition::GetOptionTypes() const {
 
 std::shared_ptr<TypeInfoBase> TypeDefinition::Instantiate(
     const DebugInfo& debug, Options) const  {
-  return std::make_shared<TypeDefinition>(debug, alias_name(), statements_);
+  // Share the compiled layout so field handles resolved from the top-level
+  // type work on every instance of it.
+  return std::shared_ptr<TypeDefinition>(new TypeDefinition(
+      debug, alias_name(), statements_, static_layout_, program_));
 }
 
 bool TypeDefinition::Equals(const TypeInfoBase& other) const {
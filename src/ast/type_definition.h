@@ -21,7 +21,9 @@
 #include <vector>
 
 #include "ast/ast_base.h"
+#include "ast/static_layout.h"
 #include "ast/type_info.h"
+#include "ast/type_program.h"
 #include "binary_reader/error.h"
 #include "util/macros.h"
 
@@ -47,19 +49,41 @@ class TypeDefinition final
     return statements_;
   }
 
-  bool ReadValue(std::shared_ptr<BufferedFileReader> reader, Value* result,
-                 ErrorCollection* errors) const override;
+  /// <summary>
+  /// Gets the precomputed layout used to decode all fields at once, or
+  /// nullptr if this type can't be decoded that way.
+  /// </summary>
+  const StaticLayout* static_layout() const {
+    return static_layout_.get();
+  }
+
+  /// <summary>
+  /// Gets the compiled program used to lay out the fields of objects of this
+  /// type.  Instantiations of the type share the same program.
+  /// </summary>
+  const TypeProgram& program() const {
+    return *program_;
+  }
+
+  bool ReadValue(const ReadContext& ctx, Value* result) const override;
 
   std::unordered_set<OptionType> GetOptionTypes() const override;
   std::shared_ptr<TypeInfoBase> Instantiate(
       const DebugInfo& debug, Options options) const override;
 
  private:
+  TypeDefinition(const DebugInfo& debug, const std::string& name,
+                 std::vector<std::shared_ptr<Statement>> statements,
+                 std::shared_ptr<const StaticLayout> static_layout,
+                 std::shared_ptr<const TypeProgram> program);
+
   bool Equals(const TypeInfoBase& other) const override;
   bool Equals(const AstBase& other) const override;
   bool Equals(const TypeDefinition& other) const;
 
   const std::vector<std::shared_ptr<Statement>> statements_;
+  const std::shared_ptr<const StaticLayout> static_layout_;
+  const std::shared_ptr<const TypeProgram> program_;
 };
 
 }  // namespace binary_reader
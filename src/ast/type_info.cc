@@ -15,9 +15,69 @@
 #include "ast/type_info.h"
 
 #include <algorithm>
+#include <cstring>
+
+#include "util/bits.h"
+#include "util/checksum.h"
+#include "util/float_conversion.h"
+#include "util/varint.h"
 
 namespace binary_reader {
 
+namespace {
+
+/// <summary>
+/// Reads the given number of bits as an unsigned integer and moves the reader
+/// forward past them.  Big endian values can start at any bit offset; little
+/// endian values must be byte aligned.
+/// </summary>
+bool ReadBits(BufferedFileReader* reader, size_t size, ByteOrder order,
+              const DebugInfo& debug, uint64_t* result,
+              ErrorCollection* errors) {
+  const uint8_t bit_offset = reader->position().bit_offset();
+  const size_t final_bits = (bit_offset + size) % 8;
+  const size_t byte_count = BitsToByteCount(bit_offset, size);
+  if (order == ByteOrder::LittleEndian &&
+      (bit_offset != 0 || final_bits != 0)) {
+    errors->Add({debug, ErrorKind::LittleEndianAlign, ErrorLevel::Error,
+                 reader->position().byte_count()});
+    return false;
+  }
+  if (!reader->EnsureBuffer(Size::FromBits(size), errors))
+    return false;
+
+  const uint8_t* buffer;
+  size_t buffer_size;
+  if (!reader->GetBuffer(&buffer, &buffer_size, errors))
+    return false;
+  if (buffer_size < byte_count) {
+    errors->Add({debug, ErrorKind::UnexpectedEndOfStream});
+    return false;
+  }
+
+  *result = LoadBits(buffer, bit_offset, size, order);
+  return reader->Skip(Size::FromBits(size), errors);
+}
+
+/// <summary>
+/// Finds the terminating zero code unit, starting at |start|.
+/// </summary>
+/// <returns>The terminator's offset, or |size| if there isn't one.</returns>
+size_t FindTerminator(const uint8_t* buffer, size_t size, size_t start,
+                      uint8_t unit_size) {
+  if (unit_size == 1) {
+    const void* found = memchr(buffer + start, 0, size - start);
+    return found ? static_cast<const uint8_t*>(found) - buffer : size;
+  }
+  for (size_t i = start; i + 1 < size; i += 2) {
+    if (buffer[i] == 0 && buffer[i + 1] == 0)
+      return i;
+  }
+  return size;
+}
+
+}  // namespace
+
 TypeInfoBase::TypeInfoBase(const DebugInfo& debug,
                            const std::string& alias_name,
                            const std::string& base_name,
@@ -46,6 +106,32 @@ std::vector<std::shared_ptr<TypeInfoBase>> TypeInfoBase::GetBuiltInTypes() {
   MAKE("int64", 64, Signedness::Signed);
   MAKE("uint64", 64, Signedness::Unsigned);
 #undef MAKE
+#define MAKE(id, size)                                     \
+  ret.emplace_back(std::make_shared<FloatTypeInfo>(        \
+      DebugInfo{"<builtin>"}, (id), Size::FromBits(size), \
+      ByteOrder::Unset))
+  MAKE("float16", 16);
+  MAKE("float32", 32);
+  MAKE("float64", 64);
+#undef MAKE
+#define MAKE(id, encoding)                                                 \
+  ret.emplace_back(std::make_shared<VarintTypeInfo>(DebugInfo{"<builtin>"}, \
+                                                    (id), (encoding)))
+  MAKE("uleb128", VarintEncoding::Leb128);
+  MAKE("sleb128", VarintEncoding::SignedLeb128);
+  MAKE("zigzag", VarintEncoding::ZigZag);
+  MAKE("prefix_varint", VarintEncoding::Prefix);
+#undef MAKE
+#define MAKE(id, algorithm)                                        \
+  ret.emplace_back(std::make_shared<ChecksumTypeInfo>(             \
+      DebugInfo{"<builtin>"}, (id), (algorithm), ByteOrder::Unset, \
+      ChecksumRange::Unset))
+  MAKE("crc32", ChecksumAlgorithm::Crc32);
+  MAKE("crc32c", ChecksumAlgorithm::Crc32c);
+  MAKE("adler32", ChecksumAlgorithm::Adler32);
+#undef MAKE
+  ret.emplace_back(std::make_shared<StringTypeInfo>(
+      DebugInfo{"<builtin>"}, "cstring", CodecId::Unknown));
   return ret;
 }
 
@@ -80,64 +166,263 @@ bool IntegerTypeInfo::Equals(const TypeInfoBase& other) const {
          TypeInfoBase::Equals(other);
 }
 
-bool IntegerTypeInfo::ReadValue(std::shared_ptr<BufferedFileReader> reader,
-                                Value* result, ErrorCollection* errors) const {
+bool IntegerTypeInfo::ReadValue(const ReadContext& ctx, Value* result) const {
   const size_t size = static_size()->bit_count();
-  const uint8_t bit_offset = reader->position().bit_offset();
-  const size_t final_bits = (reader->position().bit_offset() + size) % 8;
-  const size_t byte_count = (bit_offset + size) / 8 + (final_bits != 0 ? 1 : 0);
-  if (order_ == ByteOrder::LittleEndian &&
-      (bit_offset != 0 || final_bits != 0)) {
-    errors->Add({debug_info(), ErrorKind::LittleEndianAlign, ErrorLevel::Error,
-                 reader->position().byte_count()});
+  uint64_t value;
+  if (!ReadBits(ctx.reader(), size, order_, debug_info(), &value,
+                ctx.errors())) {
     return false;
   }
-  if (!reader->EnsureBuffer(*static_size(), errors))
+
+  if (sign_ == Signedness::Signed && (value & (1ull << (size - 1)))) {
+    // If the value is negative, then fill remaining high-level bits with 1
+    // so the value is still negative.
+    if (size != 64)
+      value |= ~((1ull << size) - 1);
+    *result = Number{static_cast<int64_t>(value)};
+  } else {
+    *result = Number{value};
+  }
+  return true;
+}
+
+
+FloatTypeInfo::FloatTypeInfo(const DebugInfo& debug,
+                             const std::string& alias_name, Size size,
+                             ByteOrder order)
+    : TypeInfoBase(debug, alias_name, "float", size), order_(order) {}
+
+std::unordered_set<OptionType> FloatTypeInfo::GetOptionTypes() const {
+  return {OptionType::ByteOrder};
+}
+
+std::shared_ptr<TypeInfoBase> FloatTypeInfo::Instantiate(
+    const DebugInfo& debug, Options options) const {
+  return std::make_shared<FloatTypeInfo>(
+      debug, alias_name(), static_size().value(),
+      options.GetOption<ByteOrder>(byte_order()));
+}
+
+bool FloatTypeInfo::Equals(const TypeInfoBase& other) const {
+  auto* o = static_cast<const FloatTypeInfo*>(&other);
+  return order_ == o->order_ && TypeInfoBase::Equals(other);
+}
+
+bool FloatTypeInfo::ReadValue(const ReadContext& ctx, Value* result) const {
+  const size_t size = static_size()->bit_count();
+  uint64_t bits;
+  if (!ReadBits(ctx.reader(), size, order_, debug_info(), &bits,
+                ctx.errors())) {
+    return false;
+  }
+
+  *result = Number{FloatBitsToDouble(bits, size)};
+  return true;
+}
+
+
+VarintTypeInfo::VarintTypeInfo(const DebugInfo& debug,
+                               const std::string& alias_name,
+                               VarintEncoding encoding)
+    : TypeInfoBase(debug, alias_name, "varint", std::nullopt),
+      encoding_(encoding) {}
+
+Number VarintTypeInfo::ToNumber(uint64_t raw, size_t length) const {
+  switch (encoding_) {
+    case VarintEncoding::SignedLeb128:
+      return Number{SignExtendLeb128(raw, length)};
+    case VarintEncoding::ZigZag:
+      return Number{ZigZagDecode(raw)};
+    default:
+      return Number{raw};
+  }
+}
+
+std::unordered_set<OptionType> VarintTypeInfo::GetOptionTypes() const {
+  return {};
+}
+
+std::shared_ptr<TypeInfoBase> VarintTypeInfo::Instantiate(
+    const DebugInfo& debug, Options) const {
+  return std::make_shared<VarintTypeInfo>(debug, alias_name(), encoding_);
+}
+
+bool VarintTypeInfo::Equals(const TypeInfoBase& other) const {
+  auto* o = static_cast<const VarintTypeInfo*>(&other);
+  return encoding_ == o->encoding_ && TypeInfoBase::Equals(other);
+}
+
+bool VarintTypeInfo::ReadValue(const ReadContext& ctx, Value* result) const {
+  BufferedFileReader* reader = ctx.reader();
+  if (reader->position().bit_offset() != 0) {
+    ctx.errors()->Add({debug_info(), ErrorKind::VarintAlign, ErrorLevel::Error,
+                       reader->position().byte_count()});
+    return false;
+  }
+  if (!reader->EnsureBuffer(Size::FromBytes(kMaxVarintSize), ctx.errors()))
     return false;
 
   const uint8_t* buffer;
   size_t buffer_size;
-  if (!reader->GetBuffer(&buffer, &buffer_size, errors))
+  if (!reader->GetBuffer(&buffer, &buffer_size, ctx.errors()))
     return false;
-  if (buffer_size < byte_count) {
-    errors->Add({debug_info(), ErrorKind::UnexpectedEndOfStream});
+
+  uint64_t raw;
+  const bool is_signed = encoding_ == VarintEncoding::SignedLeb128;
+  const size_t length =
+      encoding_ == VarintEncoding::Prefix
+          ? DecodePrefixVarint(buffer, buffer_size, &raw)
+          : DecodeLeb128(buffer, buffer_size, is_signed, &raw);
+  if (length == 0) {
+    // DecodeLeb128 fails either because the buffer ends or the value is too
+    // long; it can only be too long if all bytes were available.
+    const bool eof = buffer_size < kMaxVarintSize ||
+                     encoding_ == VarintEncoding::Prefix;
+    ctx.errors()->Add({debug_info(),
+                       eof ? ErrorKind::UnexpectedEndOfStream
+                           : ErrorKind::VarintTooLong,
+                       ErrorLevel::Error, reader->position().byte_count()});
     return false;
   }
 
-  uint64_t value = 0;
-  size_t index = 0;
-  if (bit_offset != 0) {
-    // Read most significant bits to least.
-    const size_t mask = (1ull << (8 - bit_offset)) - 1;
-    const size_t shift = 8 - std::min<size_t>(size + bit_offset, 8);
-    value = (buffer[0] & mask) >> shift;
-    index++;
+  *result = ToNumber(raw, length);
+  return reader->Skip(Size::FromBytes(length), ctx.errors());
+}
+
+
+ChecksumTypeInfo::ChecksumTypeInfo(const DebugInfo& debug,
+                                   const std::string& alias_name,
+                                   ChecksumAlgorithm algorithm,
+                                   ByteOrder order, ChecksumRange range)
+    : TypeInfoBase(debug, alias_name, "checksum", Size::FromBits(32)),
+      algorithm_(algorithm),
+      order_(order),
+      range_(range) {}
+
+uint32_t ChecksumTypeInfo::Update(const uint8_t* data, size_t size,
+                                  uint32_t state) const {
+  switch (algorithm_) {
+    case ChecksumAlgorithm::Crc32:
+      return Crc32(data, size, state);
+    case ChecksumAlgorithm::Crc32c:
+      return Crc32c(data, size, state);
+    default:
+      return Adler32(data, size, state);
   }
-  for (; index < byte_count - 1 || (index == byte_count - 1 && final_bits == 0);
-       index++) {
-    if (order_ == ByteOrder::LittleEndian) {
-      value |= static_cast<uint64_t>(buffer[index]) << (8u * index);
-    } else {
-      value <<= 8;
-      value |= buffer[index];
-    }
+}
+
+std::unordered_set<OptionType> ChecksumTypeInfo::GetOptionTypes() const {
+  return {OptionType::ByteOrder, OptionType::ChecksumRange};
+}
+
+std::shared_ptr<TypeInfoBase> ChecksumTypeInfo::Instantiate(
+    const DebugInfo& debug, Options options) const {
+  return std::make_shared<ChecksumTypeInfo>(
+      debug, alias_name(), algorithm_, options.GetOption<ByteOrder>(order_),
+      options.GetOption<ChecksumRange>(range_));
+}
+
+bool ChecksumTypeInfo::Equals(const TypeInfoBase& other) const {
+  auto* o = static_cast<const ChecksumTypeInfo*>(&other);
+  return algorithm_ == o->algorithm_ && order_ == o->order_ &&
+         range_ == o->range_ && TypeInfoBase::Equals(other);
+}
+
+bool ChecksumTypeInfo::ReadValue(const ReadContext& ctx, Value* result) const {
+  uint64_t value;
+  if (!ReadBits(ctx.reader(), 32, order_, debug_info(), &value,
+                ctx.errors())) {
+    return false;
   }
+  *result = Number{value};
+  return true;
+}
+
+
+StringTypeInfo::StringTypeInfo(const DebugInfo& debug,
+                               const std::string& alias_name,
+                               CodecId encoding)
+    : TypeInfoBase(debug, alias_name, "string", std::nullopt),
+      encoding_(encoding),
+      codec_(CodecCollection::GetBuiltinCodec(
+          encoding == CodecId::Unknown ? CodecId::Utf8 : encoding)),
+      unit_size_(encoding == CodecId::Utf16Le || encoding == CodecId::Utf16Be
+                     ? 2
+                     : 1) {}
 
-  if (final_bits != 0 && byte_count != 1) {
-    value <<= final_bits;
-    value |= (buffer[index] >> final_bits);
+std::unordered_set<OptionType> StringTypeInfo::GetOptionTypes() const {
+  return {OptionType::Encoding};
+}
+
+std::shared_ptr<TypeInfoBase> StringTypeInfo::Instantiate(
+    const DebugInfo& debug, Options options) const {
+  return std::make_shared<StringTypeInfo>(
+      debug, alias_name(), options.GetOption<CodecId>(encoding_));
+}
+
+bool StringTypeInfo::Equals(const TypeInfoBase& other) const {
+  auto* o = static_cast<const StringTypeInfo*>(&other);
+  return encoding_ == o->encoding_ && TypeInfoBase::Equals(other);
+}
+
+bool StringTypeInfo::ReadValue(const ReadContext& ctx, Value* result) const {
+  BufferedFileReader* reader = ctx.reader();
+  if (reader->position().bit_offset() != 0) {
+    ctx.errors()->Add({debug_info(), ErrorKind::StringAlign, ErrorLevel::Error,
+                       reader->position().byte_count()});
+    return false;
   }
 
-  if (sign_ == Signedness::Signed && (value & (1ull << (size - 1)))) {
-    // If the value is negative, then fill remaining high-level bits with 1
-    // so the value is still negative.
-    if (size != 64)
-      value |= ~((1ull << size) - 1);
-    *result = Number{static_cast<int64_t>(value)};
+  // Buffer more of the file until the terminator is found.
+  const uint8_t* buffer;
+  size_t buffer_size;
+  if (!reader->GetBuffer(&buffer, &buffer_size, ctx.errors()))
+    return false;
+  size_t length = 0;
+  while ((length = FindTerminator(buffer, buffer_size, length, unit_size_)) ==
+         buffer_size) {
+    if (buffer_size >= BufferedFileReader::kBufferSize) {
+      ctx.errors()->Add({debug_info(), ErrorKind::InvalidString,
+                         {"the string is too long"}, ErrorLevel::Error,
+                         reader->position().byte_count()});
+      return false;
+    }
+
+    // Resume the search at the last whole code unit.
+    const size_t searched = buffer_size;
+    length = searched - searched % unit_size_;
+    if (!reader->EnsureBuffer(Size::FromBytes(searched + 1), ctx.errors()) ||
+        !reader->GetBuffer(&buffer, &buffer_size, ctx.errors())) {
+      return false;
+    }
+    if (buffer_size == searched) {
+      ctx.errors()->Add({debug_info(), ErrorKind::UnexpectedEndOfStream,
+                         ErrorLevel::Error, reader->position().byte_count()});
+      return false;
+    }
+  }
+
+  auto decode = [&](UtfString* str) {
+    ErrorInfo error;
+    error.offset = reader->position().byte_count();
+    *str = UtfString::FromEncoding(buffer, length, codec_, &error);
+    if (!error.message.empty()) {
+      ctx.errors()->Add({debug_info(), ErrorKind::InvalidString,
+                         {error.message}, ErrorLevel::Error, error.offset});
+      return false;
+    }
+    return true;
+  };
+  if (ctx.interner() && length <= StringInterner::kMaxSize) {
+    if (!ctx.interner()->Intern(codec_.get(), buffer, length, decode, result))
+      return false;
   } else {
-    *result = Number{value};
+    UtfString str;
+    if (!decode(&str))
+      return false;
+    *result = Value{std::move(str), ctx.arena()};
   }
-  return reader->Skip(Size::FromBits(size), errors);
+  return reader->Skip(Size::FromBytes(length + unit_size_), ctx.errors());
 }
 
 }  // namespace binary_reader
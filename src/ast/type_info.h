@@ -22,12 +22,13 @@
 #include <unordered_set>
 #include <vector>
 
+#include "binary_reader/codecs.h"
 #include "binary_reader/error_collection.h"
 #include "binary_reader/options.h"
 #include "binary_reader/size.h"
 #include "binary_reader/value.h"
-#include "util/buffered_file_reader.h"
 #include "util/macros.h"
+#include "util/read_context.h"
 
 namespace binary_reader {
 
@@ -85,16 +86,13 @@ class TypeInfoBase {
   }
 
   /// <summary>
-  /// Reads a value from the given reader.  This moves the reader forward based
-  /// on how large this type is.
+  /// Reads a value from the context's reader.  This moves the reader forward
+  /// based on how large this type is.
   /// </summary>
-  /// <param name="reader">The object to read from</param>
-  /// <param name="bit_offset">The offset within the byte to start at.</param>
+  /// <param name="ctx">The context holding the reader and error sink.</param>
   /// <param name="result">Will be filled in with the result.</param>
-  /// <param name="errors">Will be filled in with any errors.</param>
   /// <returns>True on success, false on error.</returns>
-  virtual bool ReadValue(std::shared_ptr<BufferedFileReader> reader,
-                         Value* result, ErrorCollection* errors) const = 0;
+  virtual bool ReadValue(const ReadContext& ctx, Value* result) const = 0;
 
  protected:
   virtual bool Equals(const TypeInfoBase& other) const;
@@ -125,8 +123,7 @@ class IntegerTypeInfo final : public TypeInfoBase {
   std::shared_ptr<TypeInfoBase> Instantiate(const DebugInfo& debug,
                                             Options options) const override;
 
-  bool ReadValue(std::shared_ptr<BufferedFileReader> reader, Value* result,
-                 ErrorCollection* errors) const override;
+  bool ReadValue(const ReadContext& ctx, Value* result) const override;
 
  private:
   bool Equals(const TypeInfoBase& other) const override;
@@ -135,6 +132,166 @@ class IntegerTypeInfo final : public TypeInfoBase {
   const ByteOrder order_;
 };
 
+/// <summary>
+/// Defines a type info about a built-in IEEE 754 floating-point type.  This
+/// supports 16, 32, and 64 bit numbers.
+/// </summary>
+class FloatTypeInfo final : public TypeInfoBase {
+ public:
+  FloatTypeInfo(const DebugInfo& debug, const std::string& alias_name,
+                Size size, ByteOrder order);
+
+  ByteOrder byte_order() const {
+    return order_;
+  }
+
+  std::unordered_set<OptionType> GetOptionTypes() const override;
+  std::shared_ptr<TypeInfoBase> Instantiate(const DebugInfo& debug,
+                                            Options options) const override;
+
+  bool ReadValue(const ReadContext& ctx, Value* result) const override;
+
+ private:
+  bool Equals(const TypeInfoBase& other) const override;
+
+  const ByteOrder order_;
+};
+
+enum class VarintEncoding : uint8_t {
+  /// <summary>
+  /// Unsigned LEB128, as used by protobuf, WebAssembly, and DWARF.
+  /// </summary>
+  Leb128,
+  /// <summary>
+  /// Signed (two's complement) LEB128.
+  /// </summary>
+  SignedLeb128,
+  /// <summary>
+  /// Protobuf sint types; an unsigned LEB128 holding a zigzag value.
+  /// </summary>
+  ZigZag,
+  /// <summary>
+  /// The length is given by the leading one bits of the first byte, like
+  /// UTF-8.
+  /// </summary>
+  Prefix,
+};
+
+/// <summary>
+/// Defines a type info about a built-in variable-length integer type.  These
+/// don't have a static size; the size is determined by reading the value.
+/// </summary>
+class VarintTypeInfo final : public TypeInfoBase {
+ public:
+  VarintTypeInfo(const DebugInfo& debug, const std::string& alias_name,
+                 VarintEncoding encoding);
+
+  VarintEncoding encoding() const {
+    return encoding_;
+  }
+
+  /// <summary>
+  /// Converts a raw value that used |length| bytes into its number.
+  /// </summary>
+  Number ToNumber(uint64_t raw, size_t length) const;
+
+  std::unordered_set<OptionType> GetOptionTypes() const override;
+  std::shared_ptr<TypeInfoBase> Instantiate(const DebugInfo& debug,
+                                            Options options) const override;
+
+  bool ReadValue(const ReadContext& ctx, Value* result) const override;
+
+ private:
+  bool Equals(const TypeInfoBase& other) const override;
+
+  const VarintEncoding encoding_;
+};
+
+enum class ChecksumAlgorithm : uint8_t {
+  Crc32,
+  Crc32c,
+  Adler32,
+};
+
+/// <summary>
+/// Defines a type info about a built-in 32-bit checksum.  The value is the
+/// stored checksum; when the object is parsed, the checksum is computed over
+/// the covered bytes and compared against it.
+/// </summary>
+class ChecksumTypeInfo final : public TypeInfoBase {
+ public:
+  ChecksumTypeInfo(const DebugInfo& debug, const std::string& alias_name,
+                   ChecksumAlgorithm algorithm, ByteOrder order,
+                   ChecksumRange range);
+
+  ChecksumAlgorithm algorithm() const {
+    return algorithm_;
+  }
+  ByteOrder byte_order() const {
+    return order_;
+  }
+  ChecksumRange range() const {
+    return range_;
+  }
+
+  /// <summary>
+  /// Gets the initial state to pass to Update.
+  /// </summary>
+  uint32_t initial() const {
+    return algorithm_ == ChecksumAlgorithm::Adler32 ? 1 : 0;
+  }
+
+  /// <summary>
+  /// Adds the given bytes to the running checksum |state|.
+  /// </summary>
+  uint32_t Update(const uint8_t* data, size_t size, uint32_t state) const;
+
+  std::unordered_set<OptionType> GetOptionTypes() const override;
+  std::shared_ptr<TypeInfoBase> Instantiate(const DebugInfo& debug,
+                                            Options options) const override;
+
+  bool ReadValue(const ReadContext& ctx, Value* result) const override;
+
+ private:
+  bool Equals(const TypeInfoBase& other) const override;
+
+  const ChecksumAlgorithm algorithm_;
+  const ByteOrder order_;
+  const ChecksumRange range_;
+};
+
+/// <summary>
+/// Defines a type info about a built-in null-terminated string.  The
+/// encoding's codec is resolved when the type is instantiated, so reading a
+/// value doesn't need to look it up.
+/// </summary>
+class StringTypeInfo final : public TypeInfoBase {
+ public:
+  StringTypeInfo(const DebugInfo& debug, const std::string& alias_name,
+                 CodecId encoding);
+
+  CodecId encoding() const {
+    return encoding_;
+  }
+  const std::shared_ptr<Codec>& codec() const {
+    return codec_;
+  }
+
+  std::unordered_set<OptionType> GetOptionTypes() const override;
+  std::shared_ptr<TypeInfoBase> Instantiate(const DebugInfo& debug,
+                                            Options options) const override;
+
+  bool ReadValue(const ReadContext& ctx, Value* result) const override;
+
+ private:
+  bool Equals(const TypeInfoBase& other) const override;
+
+  const CodecId encoding_;
+  const std::shared_ptr<Codec> codec_;
+  // UTF-16 strings end with a zero code unit rather than a zero byte.
+  const uint8_t unit_size_;
+};
+
 }  // namespace binary_reader
 
 #endif  // BINARY_READER_AST_TYPE_INFO_H_
@@ -0,0 +1,93 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ast/type_program.h"
+
+#include "ast/field_info.h"
+#include "ast/literal.h"
+#include "ast/type_definition.h"
+
+namespace binary_reader {
+
+namespace {
+
+bool IsLeb128(const TypeInfoBase* type) {
+  auto* varint = dynamic_cast<const VarintTypeInfo*>(type);
+  return varint && varint->encoding() != VarintEncoding::Prefix;
+}
+
+}  // namespace
+
+std::unique_ptr<TypeProgram> TypeProgram::Compile(
+    const std::vector<std::shared_ptr<Statement>>& statements) {
+  std::unique_ptr<TypeProgram> ret(new TypeProgram);
+  std::optional<Size> offset = Size{};
+  for (const auto& stmt : statements) {
+    auto* field = dynamic_cast<const FieldInfo*>(stmt.get());
+    if (!field) {
+      // Nothing after this is laid out, since running it fails.
+      ret->code_.push_back({OpCode::Unsupported, 0, 0});
+      break;
+    }
+
+    const uint32_t index = static_cast<uint32_t>(ret->fields_.size());
+    const std::optional<Size> size = field->type()->static_size();
+    uint32_t offset_slot = 0;
+    if (!offset)
+      offset_slot = static_cast<uint32_t>(ret->dynamic_offset_count_++);
+    ret->fields_.push_back({field->name(), field->type().get(), size,
+                            field->type()->debug_info(), offset, offset_slot,
+                            kNotShadowed});
+    auto [it, added] = ret->field_index_.emplace(field->name(), index);
+    if (!added) {
+      ret->fields_[it->second].shadowed_by = index;
+      it->second = index;
+    }
+    if (offset && size)
+      *offset += *size;
+    else
+      offset.reset();
+    if (ret->fields_.back().size) {
+      ret->code_.push_back({OpCode::Field, index, 0});
+    } else if (!IsLeb128(field->type().get())) {
+      ret->code_.push_back({OpCode::DynamicField, index, 0});
+    } else {
+      // Merge consecutive LEB128 fields so they can be decoded together.
+      Instruction* prev = ret->code_.empty() ? nullptr : &ret->code_.back();
+      if (prev && prev->op == OpCode::VarintRun && prev->a + prev->b == index) {
+        prev->b++;
+      } else {
+        ret->code_.push_back({OpCode::VarintRun, index, 1});
+      }
+    }
+
+    if (dynamic_cast<const TypeDefinition*>(field->type().get()))
+      ret->has_child_objects_ = true;
+    if (dynamic_cast<const ChecksumTypeInfo*>(field->type().get()))
+      ret->code_.push_back({OpCode::VerifyChecksum, index, 0});
+    if (auto* literal = dynamic_cast<const Literal*>(field->expected().get())) {
+      const uint32_t constant = static_cast<uint32_t>(ret->constants_.size());
+      ret->constants_.push_back(literal->value());
+      ret->code_.push_back({OpCode::CheckExpected, index, constant});
+    }
+  }
+  ret->code_.push_back({OpCode::End, 0, 0});
+  for (const Instruction& inst : ret->code_) {
+    if (inst.op != OpCode::Field && inst.op != OpCode::End)
+      ret->reads_file_ = true;
+  }
+  return ret;
+}
+
+}  // namespace binary_reader
@@ -0,0 +1,247 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BINARY_READER_AST_TYPE_PROGRAM_H_
+#define BINARY_READER_AST_TYPE_PROGRAM_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast/ast_base.h"
+#include "ast/type_info.h"
+#include "binary_reader/error_collection.h"
+#include "binary_reader/size.h"
+#include "binary_reader/value.h"
+
+namespace binary_reader {
+
+/// <summary>
+/// A compiled form of the statements in a type definition.  The statements
+/// are flattened into a list of instructions that are run by a small
+/// interpreter to lay out the fields of an object.  This avoids walking the
+/// AST (and the casts and reference counting that needs) for every object.
+///
+/// The program is also the field table shared by every object of the type:
+/// objects only store their field values and the offsets that can't be
+/// computed ahead of time.
+/// </summary>
+class TypeProgram final {
+ public:
+  enum class OpCode : uint8_t {
+    /// <summary>
+    /// Declares the static field |a| at the current offset and moves past it.
+    /// The field isn't read until its value is needed.
+    /// </summary>
+    Field,
+    /// <summary>
+    /// Reads the dynamically-sized field |a| at the current offset to find
+    /// where it ends.
+    /// </summary>
+    DynamicField,
+    /// <summary>
+    /// Reads |b| consecutive LEB128 fields starting at field |a| in one pass.
+    /// </summary>
+    VarintRun,
+    /// <summary>
+    /// Reads the most recently declared field and checks it is equal to
+    /// constant |b|.  |a| is the field index, for errors.
+    /// </summary>
+    CheckExpected,
+    /// <summary>
+    /// Computes the checksum for the most recently declared field, |a|, and
+    /// checks it against the stored value.
+    /// </summary>
+    VerifyChecksum,
+    /// <summary>
+    /// Fails with an error.  This replaces a statement that isn't a field,
+    /// which type definitions don't support yet.
+    /// </summary>
+    Unsupported,
+    /// <summary>
+    /// Stops execution.  This is always the last instruction.
+    /// </summary>
+    End,
+  };
+
+  struct Instruction {
+    OpCode op;
+    uint32_t a;
+    uint32_t b;
+  };
+
+  struct Field {
+    std::string name;
+    /// <summary>
+    /// The type of the field.  This is owned by the type definition's
+    /// statements, which outlive the program.
+    /// </summary>
+    const TypeInfoBase* type;
+    std::optional<Size> size;
+    DebugInfo debug;
+    /// <summary>
+    /// The offset from the start of the object, if every field before this
+    /// one has a static size.
+    /// </summary>
+    std::optional<Size> offset;
+    /// <summary>
+    /// If |offset| is unset, the index of the field in the per-object list of
+    /// dynamic offsets.
+    /// </summary>
+    uint32_t offset_slot;
+    /// <summary>
+    /// The index of the next field with the same name, which hides this one
+    /// once it is declared, or kNotShadowed.
+    /// </summary>
+    uint32_t shadowed_by;
+  };
+
+  static constexpr const uint32_t kNotShadowed = UINT32_MAX;
+
+  /// <summary>
+  /// Compiles the given statements into a program.
+  /// </summary>
+  static std::unique_ptr<TypeProgram> Compile(
+      const std::vector<std::shared_ptr<Statement>>& statements);
+
+  const std::vector<Field>& fields() const {
+    return fields_;
+  }
+
+  const std::vector<Instruction>& code() const {
+    return code_;
+  }
+
+  /// <summary>
+  /// Gets the number of fields whose offset depends on the object's data.
+  /// </summary>
+  size_t dynamic_offset_count() const {
+    return dynamic_offset_count_;
+  }
+
+  /// <summary>
+  /// Returns whether any field is an object of a user-defined type.
+  /// </summary>
+  bool has_child_objects() const {
+    return has_child_objects_;
+  }
+
+  /// <summary>
+  /// Returns whether running the program reads the file, for dynamic fields
+  /// or checks.  If not, every field is at a static offset and objects can be
+  /// laid out at any time with the same result.
+  /// </summary>
+  bool reads_file() const {
+    return reads_file_;
+  }
+
+  /// <summary>
+  /// Finds the field with the given name.  If more than one field has the
+  /// name, this returns the last one.
+  /// </summary>
+  /// <returns>The field index, or std::nullopt if not found.</returns>
+  std::optional<size_t> FindField(const std::string& name) const {
+    auto it = field_index_.find(name);
+    if (it == field_index_.end())
+      return std::nullopt;
+    return it->second;
+  }
+
+  /// <summary>
+  /// Runs the program for an object starting at the given offset.  The
+  /// |host| receives the results and must have the methods:
+  ///
+  ///   bool DeclareField(size_t index, Size offset, ErrorCollection* errors);
+  ///   bool ReadField(size_t index, Size offset, Size* end,
+  ///                  ErrorCollection* errors);
+  ///   bool ReadVarintRun(size_t first, size_t count, Size offset, Size* end,
+  ///                      ErrorCollection* errors);
+  ///   bool ReadLastField(Value* value, Size* offset,
+  ///                      ErrorCollection* errors);
+  ///   bool VerifyLastChecksum(ErrorCollection* errors);
+  ///
+  /// ReadField and ReadVarintRun declare the fields they read.  DeclareField
+  /// is for fields at a known offset; the host can read them then or later.
+  /// </summary>
+  /// <param name="start">The offset of the object.</param>
+  /// <param name="host">The object receiving the fields.</param>
+  /// <param name="end">Will be filled in with the end of the object.</param>
+  /// <param name="errors">Will be filled in with any errors.</param>
+  /// <returns>True on success, false on error.</returns>
+  template <typename Host>
+  bool Execute(Size start, Host* host, Size* end,
+               ErrorCollection* errors) const {
+    Size offset = start;
+    for (const Instruction* pc = code_.data();; pc++) {
+      switch (pc->op) {
+        case OpCode::Field:
+          if (!host->DeclareField(pc->a, offset, errors))
+            return false;
+          offset += *fields_[pc->a].size;
+          break;
+        case OpCode::DynamicField:
+          if (!host->ReadField(pc->a, offset, &offset, errors))
+            return false;
+          break;
+        case OpCode::VarintRun:
+          if (!host->ReadVarintRun(pc->a, pc->b, offset, &offset, errors))
+            return false;
+          break;
+        case OpCode::CheckExpected: {
+          Value value;
+          Size field_offset;
+          if (!host->ReadLastField(&value, &field_offset, errors))
+            return false;
+          if (value != constants_[pc->b]) {
+            errors->Add({fields_[pc->a].debug,
+                         ErrorKind::UnexpectedFieldValue,
+                         {fields_[pc->a].name},
+                         ErrorLevel::Error,
+                         field_offset.byte_count()});
+            return false;
+          }
+          break;
+        }
+        case OpCode::VerifyChecksum:
+          if (!host->VerifyLastChecksum(errors))
+            return false;
+          break;
+        case OpCode::Unsupported:
+          errors->Add({{}, ErrorKind::Unknown});
+          return false;
+        case OpCode::End:
+          *end = offset;
+          return true;
+      }
+    }
+  }
+
+ private:
+  TypeProgram() = default;
+
+  std::vector<Field> fields_;
+  std::unordered_map<std::string, size_t> field_index_;
+  size_t dynamic_offset_count_ = 0;
+  bool has_child_objects_ = false;
+  bool reads_file_ = false;
+  std::vector<Value> constants_;
+  std::vector<Instruction> code_;
+};
+
+}  // namespace binary_reader
+
+#endif  // BINARY_READER_AST_TYPE_PROGRAM_H_
@@ -14,24 +14,76 @@
 
 #include "binary_reader/codecs.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstring>
+#include <iterator>
+
+#include "util/code_units.h"
+#include "util/codec_tables.h"
+#include "util/utf8.h"
 
 namespace binary_reader {
 
 namespace {
 
+// Returns the length of |buffer| without a multi-byte sequence that is cut
+// off at the end.
+size_t CompleteUtf8Length(const uint8_t* buffer, size_t size) {
+  for (size_t i = 1; i <= 3 && i <= size; i++) {
+    const uint8_t cur = buffer[size - i];
+    if ((cur & 0xc0) == 0x80)
+      continue;
+    size_t needed = 1;
+    if (cur >= 0xf0)
+      needed = 4;
+    else if (cur >= 0xe0)
+      needed = 3;
+    else if (cur >= 0xc0)
+      needed = 2;
+    return needed > i ? size - i : size;
+  }
+  return size;
+}
+
 class Utf8Converter final : public TextConverter {
  public:
   Status Decode(const uint8_t* buffer, size_t size, std::u16string* output,
                 ErrorInfo* error) {
+    // Each byte produces at most one code unit, plus one more for a sequence
+    // that was split across calls.
+    const size_t start = output->size();
+    output->resize(start + size + 1);
+    char16_t* out = output->data() + start;
+
+    // Well-formed input can be converted in bulk; otherwise (or for the rest
+    // of a partial sequence) fall back to converting each sequence.
     size_t offset = 0;
+    if (temp_used_ == 0) {
+      const size_t complete = CompleteUtf8Length(buffer, size);
+      if (IsValidUtf8(buffer, complete)) {
+        out += ConvertUtf8ToUtf16(buffer, complete, out);
+        offset = complete;
+      }
+    }
+
+    Status status = Status::Success;
     while (temp_used_ > 0 || offset < size) {
+      if (temp_used_ == 0 && buffer[offset] < 0x80) {
+        const size_t ascii = WidenAscii(buffer + offset, size - offset, out);
+        out += ascii;
+        offset += ascii;
+        continue;
+      }
+
       const uint8_t head = temp_used_ > 0 ? temp_[0] : buffer[offset];
       const size_t num_bytes = GetNumBytes(head);
       if (num_bytes == 0) {
         error->message = "Invalid UTF-8 byte sequence";
         error->offset += offset;
-        return Status::Error;
+        status = Status::Error;
+        break;
       }
 
       // Check we have enough input bytes to read the whole sequence.  If not,
@@ -51,19 +103,22 @@ class Utf8Converter final : public TextConverter {
         if ((cur & 0xc0) != 0x80) {
           error->message = "Invalid UTF-8 byte sequence";
           error->offset += offset + i;
-          return Status::Error;
+          status = Status::Error;
+          break;
         }
         code_point = (code_point << 6) | (cur & 0x3f);
       }
+      if (status == Status::Error)
+        break;
 
       // Convert to UTF-16
-      if (code_point < 0xffff) {
+      if (code_point < 0x10000) {
         // Assume that an encoded surrogate pair should be passed as-is.
-        output->push_back(static_cast<char16_t>(code_point));
+        *out++ = static_cast<char16_t>(code_point);
       } else {
         code_point -= 0x10000;
-        output->push_back(static_cast<char16_t>(0xd800 | (code_point >> 10)));
-        output->push_back(static_cast<char16_t>(0xdc00 | (code_point & 0x3ff)));
+        *out++ = static_cast<char16_t>(0xd800 | (code_point >> 10));
+        *out++ = static_cast<char16_t>(0xdc00 | (code_point & 0x3ff));
       }
 
       // Temp only stores a partial sequence, so is reset after reading a
@@ -71,39 +126,19 @@ class Utf8Converter final : public TextConverter {
       offset += num_bytes - temp_used_;
       temp_used_ = 0;
     }
-    return Status::Success;
+
+    output->resize(out - output->data());
+    return status;
   }
 
   Status Encode(const char16_t* buffer, size_t size,
                 std::vector<uint8_t>* output, ErrorInfo*) {
-    for (size_t i = 0; i < size; i++) {
-      // Encode unpaired surrogate pairs directly.
-      uint32_t code_point;
-      if (i + 1 < size && buffer[i] >= 0xd800 && buffer[i] <= 0xdbff &&
-          buffer[i + 1] >= 0xdc00 && buffer[i + 1] <= 0xdfff) {
-        code_point =
-            ((buffer[i] & 0x3ff) << 10) | ((buffer[i + 1] & 0x3ff)) + 0x10000;
-        i++;
-      } else {
-        code_point = buffer[i];
-      }
-
-      if (code_point < 0x80) {
-        output->emplace_back(code_point);
-      } else if (code_point < 0x800) {
-        output->emplace_back(0xc0 | (code_point >> 6));
-        output->emplace_back(0x80 | (code_point & 0x3f));
-      } else if (code_point < 0x10000) {
-        output->emplace_back(0xe0 | (code_point >> 12));
-        output->emplace_back(0x80 | ((code_point >> 6) & 0x3f));
-        output->emplace_back(0x80 | (code_point & 0x3f));
-      } else {
-        output->emplace_back(0xf0 | (code_point >> 18));
-        output->emplace_back(0x80 | ((code_point >> 12) & 0x3f));
-        output->emplace_back(0x80 | ((code_point >> 6) & 0x3f));
-        output->emplace_back(0x80 | (code_point & 0x3f));
-      }
-    }
+    // Each code unit is at most 3 bytes; a surrogate pair is 4 bytes.
+    const size_t start = output->size();
+    output->resize(start + size * 3);
+    const size_t used =
+        ConvertUtf16ToUtf8(buffer, size, output->data() + start);
+    output->resize(start + used);
     return Status::Success;
   }
 
@@ -111,6 +146,10 @@ class Utf8Converter final : public TextConverter {
     temp_used_ = 0;
   }
 
+  size_t pending() const {
+    return temp_used_;
+  }
+
  private:
   uint8_t GetNumBytes(uint8_t head) {
     if ((head & 0x80) == 0) {
@@ -130,16 +169,695 @@ class Utf8Converter final : public TextConverter {
   uint8_t temp_used_ = 0;
 };
 
-template <typename T>
+// ASCII runs shorter than this are copied directly; they are common between
+// multi-byte characters and don't gain from SIMD.
+constexpr const size_t kShortAsciiRun = 8;
+
+// Copies the leading ASCII bytes, using SIMD for longer runs.
+size_t CopyAscii(const uint8_t* buffer, size_t size, char16_t* output) {
+  const size_t short_end = std::min(size, kShortAsciiRun);
+  size_t i = 0;
+  for (; i < short_end && buffer[i] < 0x80; i++)
+    output[i] = buffer[i];
+  if (i == short_end && i < size)
+    i += WidenAscii(buffer + i, size - i, output + i);
+  return i;
+}
+
+// Copies the leading ASCII code units, using SIMD for longer runs.
+size_t CopyAscii(const char16_t* buffer, size_t size, uint8_t* output) {
+  const size_t short_end = std::min(size, kShortAsciiRun);
+  size_t i = 0;
+  for (; i < short_end && buffer[i] < 0x80; i++)
+    output[i] = static_cast<uint8_t>(buffer[i]);
+  if (i == short_end && i < size)
+    i += NarrowAscii(buffer + i, size - i, output + i);
+  return i;
+}
+
+TextConverter::Status UnencodableError(size_t offset, ErrorInfo* error) {
+  error->message = "Character can't be represented in the encoding";
+  error->offset += offset;
+  return TextConverter::Status::Error;
+}
+
+/// <summary>
+/// Maps a code unit back to a byte for a single-byte code page.
+/// </summary>
+struct ReverseEntry {
+  char16_t code_unit;
+  uint8_t byte;
+};
+
+template <size_t Page>
+constexpr std::array<ReverseEntry, 128> MakeReverseTable() {
+  std::array<ReverseEntry, 128> ret{};
+  for (size_t i = 0; i < 128; i++) {
+    ret[i] = {kWindowsCodePages[Page][i], static_cast<uint8_t>(0x80 + i)};
+  }
+  // Insertion sort so lookups can use a binary search.
+  for (size_t i = 1; i < ret.size(); i++) {
+    const ReverseEntry cur = ret[i];
+    size_t j = i;
+    for (; j > 0 && ret[j - 1].code_unit > cur.code_unit; j--)
+      ret[j] = ret[j - 1];
+    ret[j] = cur;
+  }
+  return ret;
+}
+
+template <size_t Page>
+inline constexpr std::array<ReverseEntry, 128> kReverseCodePages =
+    MakeReverseTable<Page>();
+
+/// <summary>
+/// Converts Latin-1 (Page is 0) or Windows-125x (Page is the code page minus
+/// 1249).  Every byte is a whole character, so there is no state.
+/// </summary>
+template <size_t Page>
+class SingleByteConverter final : public TextConverter {
+ public:
+  Status Decode(const uint8_t* buffer, size_t size, std::u16string* output,
+                ErrorInfo*) {
+    const size_t start = output->size();
+    output->resize(start + size);
+    char16_t* out = output->data() + start;
+    // Convert as Latin-1, then fix up the bytes that differ.
+    WidenLatin1(buffer, size, out);
+    if constexpr (Page != 0) {
+      const char16_t* table = kWindowsCodePages[Page - 1];
+      for (size_t i = 0; i < size; i++) {
+        if (buffer[i] >= 0x80)
+          out[i] = table[buffer[i] - 0x80];
+      }
+    }
+    return Status::Success;
+  }
+
+  Status Encode(const char16_t* buffer, size_t size,
+                std::vector<uint8_t>* output, ErrorInfo* error) {
+    const size_t start = output->size();
+    output->resize(start + size);
+    uint8_t* out = output->data() + start;
+
+    Status status = Status::Success;
+    size_t i = 0;
+    if constexpr (Page == 0) {
+      i = NarrowLatin1(buffer, size, out);
+      if (i < size)
+        status = UnencodableError(i, error);
+    } else {
+      const auto& table = kReverseCodePages<Page - 1>;
+      while (i < size) {
+        if (buffer[i] < 0x80) {
+          i += CopyAscii(buffer + i, size - i, out + i);
+          continue;
+        }
+        auto it = std::lower_bound(
+            table.begin(), table.end(), buffer[i],
+            [](const ReverseEntry& entry, char16_t code_unit) {
+              return entry.code_unit < code_unit;
+            });
+        if (it == table.end() || it->code_unit != buffer[i]) {
+          status = UnencodableError(i, error);
+          break;
+        }
+        out[i++] = it->byte;
+      }
+    }
+    output->resize(start + i);
+    return status;
+  }
+
+  void Reset() {}
+
+  size_t pending() const {
+    return 0;
+  }
+};
+
+/// <summary>
+/// Converts UTF-16 stored in either byte order.  This doesn't check for
+/// unpaired surrogates, since UTF-16 strings are stored as-is.
+/// </summary>
+template <bool BigEndian>
+class Utf16Converter final : public TextConverter {
+ public:
+  Status Decode(const uint8_t* buffer, size_t size, std::u16string* output,
+                ErrorInfo*) {
+    if (has_temp_ && size > 0) {
+      const uint8_t pair[2] = {temp_, buffer[0]};
+      char16_t unit;
+      LoadUtf16(pair, 1, BigEndian, &unit);
+      output->push_back(unit);
+      has_temp_ = false;
+      buffer++;
+      size--;
+    }
+
+    const size_t count = size / 2;
+    const size_t start = output->size();
+    output->resize(start + count);
+    LoadUtf16(buffer, count, BigEndian, output->data() + start);
+    if (size % 2 != 0) {
+      temp_ = buffer[size - 1];
+      has_temp_ = true;
+    }
+    return Status::Success;
+  }
+
+  Status Encode(const char16_t* buffer, size_t size,
+                std::vector<uint8_t>* output, ErrorInfo*) {
+    const size_t start = output->size();
+    output->resize(start + size * 2);
+    StoreUtf16(buffer, size, BigEndian, output->data() + start);
+    return Status::Success;
+  }
+
+  void Reset() {
+    has_temp_ = false;
+  }
+
+  size_t pending() const {
+    return has_temp_ ? 1 : 0;
+  }
+
+ private:
+  uint8_t temp_ = 0;
+  bool has_temp_ = false;
+};
+
+/// <summary>
+/// The result of decoding one multi-byte character.
+/// </summary>
+enum class SequenceResult {
+  Success,
+  Truncated,
+  Invalid,
+};
+
+/// <summary>
+/// Converts a variable-width encoding one character at a time, with ASCII
+/// runs copied in bulk.  Traits defines the encoding:
+///
+///   // The largest number of bytes in a character.
+///   static constexpr size_t kMaxBytes;
+///   // The name used in error messages.
+///   static constexpr const char* kName;
+///   // Decodes one non-ASCII character from |buffer|, storing the number of
+///   // bytes used in |used| and returning the number of code units written.
+///   static SequenceResult DecodeOne(const uint8_t* buffer, size_t size,
+///                                   size_t* used, char16_t* output,
+///                                   size_t* written);
+///   // Encodes one non-ASCII character, returning the bytes written or 0.
+///   static size_t EncodeOne(const char16_t* buffer, size_t size,
+///                           size_t* used, uint8_t* output);
+/// </summary>
+template <typename Traits>
+class MultiByteConverter final : public TextConverter {
+ public:
+  Status Decode(const uint8_t* buffer, size_t size, std::u16string* output,
+                ErrorInfo* error) {
+    // Each byte produces at most one code unit, plus one more for a character
+    // that was split across calls.
+    const size_t start = output->size();
+    output->resize(start + size + 1);
+    char16_t* out = output->data() + start;
+
+    Status status = Status::Success;
+    size_t offset = 0;
+    if (temp_used_ > 0) {
+      // Finish the partial character using the start of this buffer.
+      uint8_t seq[Traits::kMaxBytes];
+      const size_t take = std::min(Traits::kMaxBytes - temp_used_, size);
+      std::memcpy(seq, temp_, temp_used_);
+      std::memcpy(seq + temp_used_, buffer, take);
+
+      size_t used, written;
+      switch (Traits::DecodeOne(seq, temp_used_ + take, &used, out,
+                                &written)) {
+        case SequenceResult::Success:
+          out += written;
+          offset = used - temp_used_;
+          temp_used_ = 0;
+          break;
+        case SequenceResult::Truncated:
+          // |take| must be all of |size| here.
+          std::memcpy(temp_, seq, temp_used_ + take);
+          temp_used_ += static_cast<uint8_t>(take);
+          offset = size;
+          break;
+        case SequenceResult::Invalid:
+          status = InvalidError(0, error);
+          break;
+      }
+    }
+
+    while (status == Status::Success && offset < size) {
+      if (buffer[offset] < 0x80) {
+        const size_t ascii = CopyAscii(buffer + offset, size - offset, out);
+        out += ascii;
+        offset += ascii;
+        continue;
+      }
+
+      size_t used, written;
+      const SequenceResult result = Traits::DecodeOne(
+          buffer + offset, size - offset, &used, out, &written);
+      if (result == SequenceResult::Truncated) {
+        std::memcpy(temp_, buffer + offset, size - offset);
+        temp_used_ = static_cast<uint8_t>(size - offset);
+        break;
+      } else if (result == SequenceResult::Invalid) {
+        status = InvalidError(offset, error);
+        break;
+      }
+      out += written;
+      offset += used;
+    }
+
+    output->resize(out - output->data());
+    return status;
+  }
+
+  Status Encode(const char16_t* buffer, size_t size,
+                std::vector<uint8_t>* output, ErrorInfo* error) {
+    const size_t start = output->size();
+    output->resize(start + size * Traits::kMaxBytes);
+    uint8_t* out = output->data() + start;
+
+    Status status = Status::Success;
+    size_t i = 0;
+    while (i < size) {
+      if (buffer[i] < 0x80) {
+        const size_t ascii = CopyAscii(buffer + i, size - i, out);
+        out += ascii;
+        i += ascii;
+        continue;
+      }
+
+      size_t used;
+      const size_t written = Traits::EncodeOne(buffer + i, size - i, &used,
+                                               out);
+      if (written == 0) {
+        status = UnencodableError(i, error);
+        break;
+      }
+      out += written;
+      i += used;
+    }
+
+    output->resize(out - output->data());
+    return status;
+  }
+
+  void Reset() {
+    temp_used_ = 0;
+  }
+
+  size_t pending() const {
+    return temp_used_;
+  }
+
+ private:
+  static Status InvalidError(size_t offset, ErrorInfo* error) {
+    error->message = std::string("Invalid ") + Traits::kName + " byte sequence";
+    error->offset += offset;
+    return Status::Error;
+  }
+
+  uint8_t temp_[Traits::kMaxBytes]{};
+  uint8_t temp_used_ = 0;
+};
+
+/// <summary>
+/// Maps a code point back to a double-byte code.  These are built from the
+/// decode tables on first use.
+/// </summary>
+struct DoubleByteEntry {
+  char16_t code_unit;
+  uint16_t code;
+};
+
+template <size_t N>
+std::vector<DoubleByteEntry> MakeDoubleByteIndex(
+    const char16_t (&table)[N], uint8_t first_lead,
+    size_t (*get_index)(uint8_t, uint8_t)) {
+  std::vector<DoubleByteEntry> ret;
+  ret.reserve(N);
+  for (unsigned lead = first_lead; lead <= 0xff; lead++) {
+    for (unsigned trail = 0x40; trail <= 0xfe; trail++) {
+      if (trail == 0x7f)
+        continue;
+      const size_t index = get_index(static_cast<uint8_t>(lead),
+                                     static_cast<uint8_t>(trail));
+      if (index < N && table[index] != 0)
+        ret.push_back({table[index], static_cast<uint16_t>(lead << 8 | trail)});
+    }
+  }
+  // Keep the first code for characters with more than one.
+  std::stable_sort(ret.begin(), ret.end(),
+                   [](const DoubleByteEntry& a, const DoubleByteEntry& b) {
+                     return a.code_unit < b.code_unit;
+                   });
+  return ret;
+}
+
+// Returns the double-byte code for the code unit, or 0 if there isn't one.
+uint16_t FindDoubleByte(const std::vector<DoubleByteEntry>& index,
+                        char16_t code_unit) {
+  auto it = std::lower_bound(
+      index.begin(), index.end(), code_unit,
+      [](const DoubleByteEntry& entry, char16_t value) {
+        return entry.code_unit < value;
+      });
+  return it != index.end() && it->code_unit == code_unit ? it->code : 0;
+}
+
+size_t StoreDoubleByte(uint16_t code, uint8_t* output) {
+  output[0] = static_cast<uint8_t>(code >> 8);
+  output[1] = static_cast<uint8_t>(code & 0xff);
+  return 2;
+}
+
+/// <summary>
+/// Shift_JIS: JIS X 0201 (ASCII and half-width katakana) in one byte and
+/// JIS X 0208 in two bytes.
+/// </summary>
+struct ShiftJisTraits {
+  static constexpr size_t kMaxBytes = 2;
+  static constexpr const char* kName = "Shift_JIS";
+
+  static bool IsLead(uint8_t b) {
+    return (b >= 0x81 && b <= 0x9f) || (b >= 0xe0 && b <= 0xfc);
+  }
+
+  static size_t GetIndex(uint8_t lead, uint8_t trail) {
+    if (!IsLead(lead) || trail < 0x40 || trail > 0xfc || trail == 0x7f)
+      return static_cast<size_t>(-1);
+    return ShiftJisTableIndex(lead, trail);
+  }
+
+  static SequenceResult DecodeOne(const uint8_t* buffer, size_t size,
+                                  size_t* used, char16_t* output,
+                                  size_t* written) {
+    const uint8_t lead = buffer[0];
+    if (lead >= 0xa1 && lead <= 0xdf) {
+      *output = static_cast<char16_t>(0xff61 + (lead - 0xa1));
+      *used = *written = 1;
+      return SequenceResult::Success;
+    }
+    if (!IsLead(lead))
+      return SequenceResult::Invalid;
+    if (size < 2)
+      return SequenceResult::Truncated;
+
+    const size_t index = GetIndex(lead, buffer[1]);
+    if (index == static_cast<size_t>(-1) || kShiftJisTable[index] == 0)
+      return SequenceResult::Invalid;
+    *output = kShiftJisTable[index];
+    *used = 2;
+    *written = 1;
+    return SequenceResult::Success;
+  }
+
+  static size_t EncodeOne(const char16_t* buffer, size_t, size_t* used,
+                          uint8_t* output) {
+    static const auto* index = new std::vector<DoubleByteEntry>(
+        MakeDoubleByteIndex(kShiftJisTable, 0x81, &GetIndex));
+
+    const char16_t c = buffer[0];
+    *used = 1;
+    if (c >= 0xff61 && c <= 0xff9f) {
+      output[0] = static_cast<uint8_t>(0xa1 + (c - 0xff61));
+      return 1;
+    }
+    const uint16_t code = FindDoubleByte(*index, c);
+    return code == 0 ? 0 : StoreDoubleByte(code, output);
+  }
+};
+
+/// <summary>
+/// GB18030: ASCII in one byte, GBK and its extensions in two bytes, and the
+/// rest of Unicode in four bytes.
+/// </summary>
+struct Gb18030Traits {
+  static constexpr size_t kMaxBytes = 4;
+  static constexpr const char* kName = "GB18030";
+  // The linear index of 0x90308130, the first four-byte code outside the BMP.
+  static constexpr uint32_t kSupplementaryStart = 189000;
+
+  static size_t GetIndex(uint8_t lead, uint8_t trail) {
+    if (lead < 0x81 || lead > 0xfe || trail < 0x40 || trail > 0xfe ||
+        trail == 0x7f) {
+      return static_cast<size_t>(-1);
+    }
+    return GbkTableIndex(lead, trail);
+  }
+
+  static uint32_t LinearIndex(const uint8_t* b) {
+    return (((b[0] - 0x81) * 10 + (b[1] - 0x30)) * 126 + (b[2] - 0x81)) * 10 +
+           (b[3] - 0x30);
+  }
+
+  static void StoreLinearIndex(uint32_t index, uint8_t* output) {
+    output[3] = static_cast<uint8_t>(0x30 + index % 10);
+    index /= 10;
+    output[2] = static_cast<uint8_t>(0x81 + index % 126);
+    index /= 126;
+    output[1] = static_cast<uint8_t>(0x30 + index % 10);
+    output[0] = static_cast<uint8_t>(0x81 + index / 10);
+  }
+
+  static SequenceResult DecodeOne(const uint8_t* buffer, size_t size,
+                                  size_t* used, char16_t* output,
+                                  size_t* written) {
+    const uint8_t lead = buffer[0];
+    if (lead < 0x81 || lead > 0xfe)
+      return SequenceResult::Invalid;
+    if (size < 2)
+      return SequenceResult::Truncated;
+
+    if (buffer[1] < 0x30 || buffer[1] > 0x39) {
+      const size_t index = GetIndex(lead, buffer[1]);
+      if (index == static_cast<size_t>(-1) || kGbkTable[index] == 0)
+        return SequenceResult::Invalid;
+      *output = kGbkTable[index];
+      *used = 2;
+      *written = 1;
+      return SequenceResult::Success;
+    }
+
+    // Four-byte sequence.
+    if (size >= 3 && (buffer[2] < 0x81 || buffer[2] > 0xfe))
+      return SequenceResult::Invalid;
+    if (size < 4)
+      return SequenceResult::Truncated;
+    if (buffer[3] < 0x30 || buffer[3] > 0x39)
+      return SequenceResult::Invalid;
+
+    const uint32_t index = LinearIndex(buffer);
+    *used = 4;
+    if (index < kGb18030BmpCodeCount) {
+      const Gb18030Range* range = std::upper_bound(
+          std::begin(kGb18030Ranges), std::end(kGb18030Ranges), index,
+          [](uint32_t value, const Gb18030Range& entry) {
+            return value < entry.index;
+          }) - 1;
+      *output = static_cast<char16_t>(range->code_point +
+                                      (index - range->index));
+      *written = 1;
+      return SequenceResult::Success;
+    }
+    if (index < kSupplementaryStart ||
+        index - kSupplementaryStart > 0x10ffff - 0x10000) {
+      return SequenceResult::Invalid;
+    }
+    const uint32_t code_point = index - kSupplementaryStart;
+    output[0] = static_cast<char16_t>(0xd800 | (code_point >> 10));
+    output[1] = static_cast<char16_t>(0xdc00 | (code_point & 0x3ff));
+    *written = 2;
+    return SequenceResult::Success;
+  }
+
+  static size_t EncodeOne(const char16_t* buffer, size_t size, size_t* used,
+                          uint8_t* output) {
+    static const auto* index = new std::vector<DoubleByteEntry>(
+        MakeDoubleByteIndex(kGbkTable, 0x81, &GetIndex));
+
+    const char16_t c = buffer[0];
+    *used = 1;
+    if (c >= 0xd800 && c <= 0xdfff) {
+      // Only a complete surrogate pair can be encoded.
+      if (c > 0xdbff || size < 2 || buffer[1] < 0xdc00 || buffer[1] > 0xdfff)
+        return 0;
+      const uint32_t code_point = ((c & 0x3ff) << 10) | (buffer[1] & 0x3ff);
+      StoreLinearIndex(kSupplementaryStart + code_point, output);
+      *used = 2;
+      return 4;
+    }
+
+    const uint16_t code = FindDoubleByte(*index, c);
+    if (code != 0)
+      return StoreDoubleByte(code, output);
+
+    // Everything else in the BMP has a four-byte code; the ranges are sorted
+    // by code point too.
+    const Gb18030Range* range = std::upper_bound(
+        std::begin(kGb18030Ranges), std::end(kGb18030Ranges), c,
+        [](char16_t value, const Gb18030Range& entry) {
+          return value < entry.code_point;
+        }) - 1;
+    const size_t next = range + 1 - std::begin(kGb18030Ranges);
+    const uint32_t end = next < std::size(kGb18030Ranges)
+                             ? kGb18030Ranges[next].index
+                             : kGb18030BmpCodeCount;
+    const uint32_t linear = range->index + (c - range->code_point);
+    if (linear >= end)
+      return 0;
+    StoreLinearIndex(linear, output);
+    return 4;
+  }
+};
+
+template <typename T, CodecId Id>
 class DefaultCodec final : public Codec {
  public:
+  CodecId id() const override {
+    return Id;
+  }
+
   std::shared_ptr<TextConverter> CreateCoder() override {
     return std::make_shared<T>();
   }
+
+  // A converter on the stack is used since the type is known.  Converters
+  // keep a character cut off at the end for the next call; here the buffer
+  // is complete, so that is an error.
+  TextConverter::Status DecodeBuffer(const uint8_t* buffer, size_t size,
+                                     std::u16string* output,
+                                     ErrorInfo* error) override {
+    T coder;
+    const TextConverter::Status status =
+        coder.Decode(buffer, size, output, error);
+    if (status != TextConverter::Status::Error && coder.pending() > 0) {
+      error->message = "Incomplete byte sequence at the end of the string";
+      error->offset += size - coder.pending();
+      return TextConverter::Status::Error;
+    }
+    return status;
+  }
+
+  TextConverter::Status EncodeBuffer(const char16_t* buffer, size_t size,
+                                     std::vector<uint8_t>* output,
+                                     ErrorInfo* error) override {
+    T coder;
+    return coder.Encode(buffer, size, output, error);
+  }
+};
+
+template <typename T, CodecId Id>
+std::shared_ptr<Codec> MakeBuiltin() {
+  return std::make_shared<DefaultCodec<T, Id>>();
+}
+
+// The number of converters each thread keeps for GetThreadCoder.
+constexpr const size_t kThreadCoderCacheSize = 4;
+
+struct CachedCoder {
+  uint64_t codec_serial = 0;
+  std::shared_ptr<TextConverter> coder;
+};
+
+std::atomic<uint64_t> next_codec_serial{1};
+
+struct CodecName {
+  const char* name;
+  CodecId id;
+};
+
+const CodecName kCodecNames[] = {
+    {"utf8", CodecId::Utf8},
+    {"utf-8", CodecId::Utf8},
+    {"UTF8", CodecId::Utf8},
+    {"UTF-8", CodecId::Utf8},
+    {"latin1", CodecId::Latin1},
+    {"iso-8859-1", CodecId::Latin1},
+    {"ISO-8859-1", CodecId::Latin1},
+    {"windows-1250", CodecId::Windows1250},
+    {"cp1250", CodecId::Windows1250},
+    {"windows-1251", CodecId::Windows1251},
+    {"cp1251", CodecId::Windows1251},
+    {"windows-1252", CodecId::Windows1252},
+    {"cp1252", CodecId::Windows1252},
+    {"windows-1253", CodecId::Windows1253},
+    {"cp1253", CodecId::Windows1253},
+    {"windows-1254", CodecId::Windows1254},
+    {"cp1254", CodecId::Windows1254},
+    {"windows-1255", CodecId::Windows1255},
+    {"cp1255", CodecId::Windows1255},
+    {"windows-1256", CodecId::Windows1256},
+    {"cp1256", CodecId::Windows1256},
+    {"windows-1257", CodecId::Windows1257},
+    {"cp1257", CodecId::Windows1257},
+    {"windows-1258", CodecId::Windows1258},
+    {"cp1258", CodecId::Windows1258},
+    {"utf-16le", CodecId::Utf16Le},
+    {"UTF-16LE", CodecId::Utf16Le},
+    {"utf16le", CodecId::Utf16Le},
+    {"utf-16be", CodecId::Utf16Be},
+    {"UTF-16BE", CodecId::Utf16Be},
+    {"utf16be", CodecId::Utf16Be},
+    {"shift_jis", CodecId::ShiftJis},
+    {"Shift_JIS", CodecId::ShiftJis},
+    {"sjis", CodecId::ShiftJis},
+    {"gb18030", CodecId::Gb18030},
+    {"GB18030", CodecId::Gb18030},
 };
 
 }  // namespace
 
+Codec::Codec() : serial_(next_codec_serial.fetch_add(1)) {}
+
+TextConverter::Status Codec::DecodeBuffer(const uint8_t* buffer, size_t size,
+                                          std::u16string* output,
+                                          ErrorInfo* error) {
+  return GetThreadCoder()->Decode(buffer, size, output, error);
+}
+
+TextConverter::Status Codec::EncodeBuffer(const char16_t* buffer, size_t size,
+                                          std::vector<uint8_t>* output,
+                                          ErrorInfo* error) {
+  return GetThreadCoder()->Encode(buffer, size, output, error);
+}
+
+std::shared_ptr<TextConverter> Codec::GetThreadCoder() {
+  thread_local CachedCoder cache[kThreadCoderCacheSize];
+  thread_local size_t next_slot = 0;
+
+  // A use count of 1 means only the cache holds the converter.
+  for (auto& entry : cache) {
+    if (entry.codec_serial == serial_ && entry.coder.use_count() == 1) {
+      entry.coder->Reset();
+      return entry.coder;
+    }
+  }
+
+  auto coder = CreateCoder();
+  auto& slot = cache[next_slot];
+  next_slot = (next_slot + 1) % kThreadCoderCacheSize;
+  slot.codec_serial = serial_;
+  slot.coder = coder;
+  return coder;
+}
+
+CodecId GetCodecId(const std::string& name) {
+  for (auto& entry : kCodecNames) {
+    if (name == entry.name)
+      return entry.id;
+  }
+  return CodecId::Unknown;
+}
 
 std::shared_ptr<Codec> CodecCollection::GetCodec(const std::string& codec) {
   auto it = codecs_.find(codec);
@@ -156,13 +874,35 @@ void CodecCollection::AddCodec(const std::string& name,
 }
 
 std::shared_ptr<CodecCollection> CodecCollection::CreateDefaultCollection() {
-  auto c = std::make_shared<DefaultCodec<Utf8Converter>>();
   auto ret = std::make_shared<CodecCollection>();
-  ret->AddCodec("utf8", c);
-  ret->AddCodec("utf-8", c);
-  ret->AddCodec("UTF8", c);
-  ret->AddCodec("UTF-8", c);
+  for (auto& entry : kCodecNames) {
+    ret->AddCodec(entry.name, GetBuiltinCodec(entry.id));
+  }
   return ret;
 }
 
+const std::shared_ptr<Codec>& CodecCollection::GetBuiltinCodec(CodecId id) {
+  // Function-local statics are initialized once in a thread-safe way.  These
+  // are never destroyed so they can be used during static destruction.
+  static const auto* codecs = new std::array<std::shared_ptr<Codec>, 16>{{
+      nullptr,
+      MakeBuiltin<Utf8Converter, CodecId::Utf8>(),
+      MakeBuiltin<SingleByteConverter<0>, CodecId::Latin1>(),
+      MakeBuiltin<SingleByteConverter<1>, CodecId::Windows1250>(),
+      MakeBuiltin<SingleByteConverter<2>, CodecId::Windows1251>(),
+      MakeBuiltin<SingleByteConverter<3>, CodecId::Windows1252>(),
+      MakeBuiltin<SingleByteConverter<4>, CodecId::Windows1253>(),
+      MakeBuiltin<SingleByteConverter<5>, CodecId::Windows1254>(),
+      MakeBuiltin<SingleByteConverter<6>, CodecId::Windows1255>(),
+      MakeBuiltin<SingleByteConverter<7>, CodecId::Windows1256>(),
+      MakeBuiltin<SingleByteConverter<8>, CodecId::Windows1257>(),
+      MakeBuiltin<SingleByteConverter<9>, CodecId::Windows1258>(),
+      MakeBuiltin<Utf16Converter<false>, CodecId::Utf16Le>(),
+      MakeBuiltin<Utf16Converter<true>, CodecId::Utf16Be>(),
+      MakeBuiltin<MultiByteConverter<ShiftJisTraits>, CodecId::ShiftJis>(),
+      MakeBuiltin<MultiByteConverter<Gb18030Traits>, CodecId::Gb18030>(),
+  }};
+  return (*codecs)[static_cast<size_t>(id)];
+}
+
 }  // namespace binary_reader
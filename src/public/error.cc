@@ -45,6 +45,8 @@ constexpr const MessageInfo kDefaultMessages[] = {
     {ErrorKind::Unknown, "Unknown error"},
     {ErrorKind::CannotOpen, "Cannot open file '%s'"},
     {ErrorKind::IoError, "Unknown IO error: errno=%s"},
+    {ErrorKind::ConcurrentReadUnsupported,
+     "The file can't be read from more than one thread"},
 
     {ErrorKind::ShadowingType, "Shadowing existing type '%s'"},
     {ErrorKind::ShadowingMember, "Shadowing existing member '%s'"},
@@ -65,6 +67,20 @@ constexpr const MessageInfo kDefaultMessages[] = {
     {ErrorKind::UnexpectedEndOfStream, "Unexpected end of stream"},
     {ErrorKind::LittleEndianAlign,
      "Little endian numbers must be byte aligned"},
+    {ErrorKind::UnexpectedFieldValue,
+     "Field '%s' doesn't have the expected value"},
+    {ErrorKind::VarintAlign, "Variable-length integers must be byte aligned"},
+    {ErrorKind::VarintTooLong,
+     "Variable-length integer is too large for 64 bits"},
+    {ErrorKind::ChecksumAlign, "Checksums must cover whole bytes"},
+    {ErrorKind::ChecksumMismatch,
+     "Checksum '%s' doesn't match the data; stored %s, computed %s"},
+    {ErrorKind::ChecksumNoPreviousField,
+     "Checksum '%s' covers the previous field, but there isn't one"},
+    {ErrorKind::StringAlign, "Strings must be byte aligned"},
+    {ErrorKind::InvalidString, "String isn't valid for its encoding: %s"},
+    {ErrorKind::StaleObject,
+     "Object is no longer valid since a parent object was reparsed"},
 
     {ErrorKind::FieldsMustBeStatic, "Fields must have a static size"},
 };
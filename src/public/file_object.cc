@@ -14,44 +14,378 @@
 
 #include "binary_reader/file_object.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cinttypes>
+#include <cstdio>
 #include <limits>
+#include <memory_resource>
 #include <optional>
-#include <unordered_map>
+#include <thread>
+#include <vector>
 
-#include "ast/field_info.h"
+#include "ast/type_program.h"
 #include "public/file_object_init.h"
+#include "util/bits.h"
+#include "util/string_interner.h"
+#include "util/value_cache.h"
+#include "util/varint.h"
 
 namespace binary_reader {
 
 namespace {
 
-struct ParsedFieldInfo {
-  std::string name;
-  std::shared_ptr<TypeInfoBase> type;
-  Size offset;
-  std::optional<Value> value;
+// The most bytes to buffer at once when computing a checksum.
+constexpr const size_t kChecksumChunkSize = 1024 * 1024;
+// The most bytes to read at once to cover the fields in a batch; fields that
+// are further apart are read separately, though still in file order.
+constexpr const size_t kBatchReadSize = 1024 * 1024;
+
+std::string FormatHex(Number value) {
+  char buffer[24];
+  snprintf(buffer, sizeof(buffer), "0x%08" PRIx64,
+           static_cast<uint64_t>(value.as_unsigned()));
+  return buffer;
+}
+
+/// <summary>
+/// Holds the cached value of one field.  Objects can be read from several
+/// threads at once, so the value is published through |state_|; a slot is
+/// only busy while a value is copied into or out of it.
+/// </summary>
+class ValueSlot final {
+ public:
+  ValueSlot() {}
+  explicit ValueSlot(const Value& value) : state_(kReady), value_(value) {}
+  // Only used while the object is laid out, before it is shared.
+  ValueSlot(ValueSlot&& other) noexcept
+      : state_(other.state_.load(std::memory_order_relaxed)),
+        value_(std::move(other.value_)) {
+    assert(!other.cache_entry.linked());
+  }
+
+  /// <summary>
+  /// Copies out the value, if there is one.
+  /// </summary>
+  bool Get(Value* value) const {
+    if (!Acquire(kReady))
+      return false;
+    Value copy = value_;
+    state_.store(kReady, std::memory_order_release);
+    // Replacing the old value can release an object, so do it after the slot
+    // is released.
+    *value = std::move(copy);
+    return true;
+  }
+
+  /// <summary>
+  /// Stores the value, unless another thread already stored one.
+  /// </summary>
+  bool Set(Value value) {
+    uint8_t expected = kEmpty;
+    if (!state_.compare_exchange_strong(expected, kBusy,
+                                        std::memory_order_acquire)) {
+      return false;
+    }
+    value_ = std::move(value);
+    state_.store(kReady, std::memory_order_release);
+    return true;
+  }
+
+  /// <summary>
+  /// Moves out the value, leaving the slot empty.
+  /// </summary>
+  Value Take() {
+    if (!Acquire(kReady))
+      return Value{};
+    Value ret = std::move(value_);
+    state_.store(kEmpty, std::memory_order_release);
+    return ret;
+  }
+
+  /// <summary>
+  /// The value cache's record of the value, if the parse has a memory budget.
+  /// </summary>
+  ValueCache::Entry cache_entry;
+
+ private:
+  enum : uint8_t { kEmpty, kReady, kBusy };
+
+  /// <summary>
+  /// Marks the slot as busy if it is in the given state, waiting for other
+  /// threads to finish with it.
+  /// </summary>
+  bool Acquire(uint8_t from) const {
+    uint8_t expected = from;
+    while (!state_.compare_exchange_weak(expected, kBusy,
+                                         std::memory_order_acquire)) {
+      if (expected != kBusy)
+        return false;
+      expected = from;
+      std::this_thread::yield();
+    }
+    return true;
+  }
+
+  mutable std::atomic<uint8_t> state_{kEmpty};
+  Value value_;
 };
 
 }  // namespace
 
-struct FileObject::Impl {
+struct FileObject::Impl final : ValueCache::Owner {
+  explicit Impl(std::pmr::memory_resource* memory)
+      : memory(memory), values(memory), dynamic_offsets(memory) {}
+  ~Impl() {
+    ForgetCachedValues();
+  }
+
+  /// <summary>
+  /// Where this and the vectors below are allocated from.
+  /// </summary>
+  std::pmr::memory_resource* const memory;
   FileObjectInit init;
-  std::vector<ParsedFieldInfo> parsed_fields;
-  std::unordered_map<std::string, size_t> field_name_map;
+  /// <summary>
+  /// The field table for the object's type, or nullptr for test objects.
+  /// </summary>
+  const TypeProgram* program = nullptr;
+  /// <summary>
+  /// The values of the fields that have been declared so far, which is all
+  /// of them once the object is laid out.  Values are read as needed.  The
+  /// cache entries are linked by address, so this is allocated up front.
+  /// </summary>
+  std::pmr::vector<ValueSlot> values;
+  /// <summary>
+  /// The offsets of the declared fields that aren't at a static offset.
+  /// </summary>
+  std::pmr::vector<Size> dynamic_offsets;
+  /// <summary>
+  /// Tracks reparses of this object so its children can tell they are
+  /// stale.  This is only created for types that have child objects.
+  /// </summary>
+  std::shared_ptr<Generation> generation;
+  Size end_position;
+
+  enum : uint8_t { kLaidOut, kDeferred, kLayingOut };
+  /// <summary>
+  /// Whether the fields have been laid out.  The first thread to use a
+  /// deferred object lays it out while any others wait.
+  /// </summary>
+  std::atomic<uint8_t> layout{kLaidOut};
+
+  ValueCache* value_cache() const {
+    return init.state ? init.state->value_cache() : nullptr;
+  }
+
+  bool valid() const {
+    return Generation::IsValid(init.parent.get(), init.parent_count);
+  }
+
+  /// <summary>
+  /// Checks the object is still valid, adding an error if not.
+  /// </summary>
+  bool CheckValid(ErrorCollection* errors) const {
+    if (valid())
+      return true;
+    if (errors)
+      errors->Add({{}, ErrorKind::StaleObject});
+    return false;
+  }
+
+  /// <summary>
+  /// Stores a value read from the file and tracks it in the value cache.
+  /// This does nothing if another thread already stored the value.
+  /// </summary>
+  bool SetValue(size_t index, Value value) {
+    ValueCache* cache = value_cache();
+    const size_t size = cache ? ValueSize(value) : 0;
+    if (!values[index].Set(std::move(value)))
+      return false;
+    if (cache)
+      cache->Add(&values[index].cache_entry, this, index, size);
+    return true;
+  }
+
+  /// <summary>
+  /// Gets the cached value of a field and marks it as recently used.
+  /// </summary>
+  bool GetCachedValue(size_t index, Value* value) {
+    if (!values[index].Get(value))
+      return false;
+    if (ValueCache* cache = value_cache())
+      cache->Touch(&values[index].cache_entry);
+    return true;
+  }
+
+  /// <summary>
+  /// Removes this object's values from the value cache, before they are
+  /// dropped.
+  /// </summary>
+  void ForgetCachedValues() {
+    if (ValueCache* cache = value_cache()) {
+      for (auto& slot : values) {
+        cache->Remove(&slot.cache_entry, this);
+      }
+    }
+  }
+
+  Value EvictCachedValue(size_t index) override {
+    return values[index].Take();
+  }
+
+  /// <summary>
+  /// Estimates the memory used by a cached value, including the object
+  /// itself if it is one (but not the values in the object).  A deferred
+  /// object is charged for the field table it allocates when laid out, since
+  /// its cache entry isn't updated then.
+  /// </summary>
+  static size_t ValueSize(const Value& value) {
+    size_t ret = sizeof(ValueSlot) + value.memory_size();
+    if (value.value_type() == ValueType::Object) {
+      const Impl& child = *value.as_object()->impl_;
+      ret += sizeof(FileObject) + sizeof(Impl);
+      if (child.init.type) {
+        const TypeProgram& program = child.init.type->program();
+        ret += program.fields().size() * sizeof(ValueSlot) +
+               program.dynamic_offset_count() * sizeof(Size);
+      } else {
+        ret += child.values.capacity() * sizeof(ValueSlot);
+      }
+    }
+    return ret;
+  }
+
+  /// <summary>
+  /// Finds the index of the declared field with the given name.
+  /// </summary>
+  std::optional<size_t> FindField(const std::string& name) const {
+    if (!program) {
+      for (size_t i = init.test_fields.size(); i > 0; i--) {
+        if (init.test_fields[i - 1].first == name)
+          return i - 1;
+      }
+      return std::nullopt;
+    }
+
+    const std::optional<size_t> ret = program->FindField(name);
+    if (!ret || *ret < values.size())
+      return ret;
+    // The layout stopped early, so an earlier field may have the name.
+    for (size_t i = values.size(); i > 0; i--) {
+      if (program->fields()[i - 1].name == name)
+        return i - 1;
+    }
+    return std::nullopt;
+  }
+
+  /// <summary>
+  /// Gets the index of the field the handle refers to, if it is for this
+  /// object's type and the field was declared.
+  /// </summary>
+  std::optional<size_t> FindField(FieldHandle field) const {
+    if (!program || field.program_ != program ||
+        field.index_ >= values.size()) {
+      return std::nullopt;
+    }
+    return field.index_;
+  }
+
+  /// <summary>
+  /// Returns whether the field is the one found by its name, which is the
+  /// last declared field with the name.
+  /// </summary>
+  bool is_visible(size_t index) const {
+    if (!program)
+      return FindField(init.test_fields[index].first) == index;
+    return program->fields()[index].shadowed_by >= values.size();
+  }
+
+  const std::string& field_name(size_t index) const {
+    return program ? program->fields()[index].name
+                   : init.test_fields[index].first;
+  }
+
+  Size field_offset(size_t index) const {
+    const TypeProgram::Field& field = program->fields()[index];
+    return field.offset ? init.start_position + *field.offset
+                        : dynamic_offsets[field.offset_slot];
+  }
+
+  /// <summary>
+  /// Gets the position just past the field, which is where the next field
+  /// starts.  This is only valid once the object is laid out.
+  /// </summary>
+  Size field_end(size_t index) const {
+    return index + 1 < values.size() ? field_offset(index + 1) : end_position;
+  }
 };
 
+bool FileObject::valid() const {
+  return impl_->valid();
+}
+
 std::vector<std::string> FileObject::GetFieldNames() const {
   std::vector<std::string> ret;
-  ret.reserve(impl_->field_name_map.size());
-  for (auto& pair : impl_->field_name_map) {
-    ret.emplace_back(pair.first);
+  ErrorCollection errors;
+  if (!impl_->valid() || !EnsureLaidOut(&errors))
+    return ret;
+  ret.reserve(impl_->values.size());
+  for (size_t i = 0; i < impl_->values.size(); i++) {
+    // Only list the last field with a given name, since that's the one that
+    // GetFieldValue returns.
+    if (impl_->is_visible(i))
+      ret.emplace_back(impl_->field_name(i));
   }
   return ret;
 }
 
+bool FileObject::ForEachFieldImpl(FieldVisitor callback, void* visitor,
+                                  ErrorCollection* errors) const {
+  ErrorCollection ignored;
+  if (!impl_->CheckValid(errors) || !EnsureLaidOut(errors ? errors : &ignored))
+    return false;
+  ValueCache* cache = impl_->value_cache();
+  for (size_t i = 0; i < impl_->values.size(); i++) {
+    if (!impl_->is_visible(i))
+      continue;
+    const std::string& name = impl_->field_name(i);
+
+    Value value;
+    if (!EnsureField(i, &value, errors ? errors : &ignored)) {
+      if (errors)
+        return false;
+      value = Value{};
+    }
+    callback(visitor, name, value);
+    // Only shrink the cache once the visitor is done with the value.
+    if (cache)
+      cache->Trim();
+  }
+  return true;
+}
+
 bool FileObject::HasField(const std::string& name) const {
-  return impl_->field_name_map.count(name) != 0;
+  ErrorCollection errors;
+  return impl_->valid() && EnsureLaidOut(&errors) &&
+         impl_->FindField(name).has_value();
+}
+
+bool FileObject::HasField(FieldHandle field) const {
+  ErrorCollection errors;
+  return impl_->valid() && EnsureLaidOut(&errors) &&
+         impl_->FindField(field).has_value();
+}
+
+FieldHandle FileObject::ResolveField(const std::string& name) const {
+  // Use the type's program rather than |impl_->program|, which isn't set
+  // until the object is laid out.  The program is shared and never changes,
+  // so this doesn't need to lay out the object.
+  if (!impl_->init.type)
+    return {};
+  const TypeProgram* program = &impl_->init.type->program();
+  const std::optional<size_t> index = program->FindField(name);
+  return index ? FieldHandle{program, *index} : FieldHandle{};
 }
 
 Value FileObject::GetFieldValue(const std::string& name) const {
@@ -61,80 +395,453 @@ Value FileObject::GetFieldValue(const std::string& name) const {
   return ret;
 }
 
+Value FileObject::GetFieldValue(FieldHandle field) const {
+  Value ret;
+  ErrorCollection errors;
+  (void)GetFieldValue(field, &ret, &errors);
+  return ret;
+}
+
 bool FileObject::GetFieldValue(const std::string& name, Value* value,
                                ErrorCollection* errors) const {
-  if (impl_->field_name_map.count(name) == 0) {
+  if (!EnsureLaidOut(errors)) {
+    *value = Value{};
+    return false;
+  }
+  return GetFieldValueAt(impl_->FindField(name), value, errors);
+}
+
+bool FileObject::GetFieldValue(FieldHandle field, Value* value,
+                               ErrorCollection* errors) const {
+  if (!EnsureLaidOut(errors)) {
+    *value = Value{};
+    return false;
+  }
+  return GetFieldValueAt(impl_->FindField(field), value, errors);
+}
+
+std::vector<Value> FileObject::GetFieldValues(
+    const std::vector<std::string>& names) const {
+  std::vector<Value> ret;
+  ErrorCollection errors;
+  (void)GetFieldValues(names, &ret, &errors);
+  return ret;
+}
+
+std::vector<Value> FileObject::GetFieldValues(
+    const std::vector<FieldHandle>& fields) const {
+  std::vector<Value> ret;
+  ErrorCollection errors;
+  (void)GetFieldValues(fields, &ret, &errors);
+  return ret;
+}
+
+bool FileObject::GetFieldValues(const std::vector<std::string>& names,
+                                std::vector<Value>* values,
+                                ErrorCollection* errors) const {
+  if (!EnsureLaidOut(errors)) {
+    values->assign(names.size(), Value{});
+    return false;
+  }
+  std::vector<std::optional<size_t>> indices;
+  indices.reserve(names.size());
+  for (const auto& name : names) {
+    indices.emplace_back(impl_->FindField(name));
+  }
+  return GetFieldValuesAt(indices, values, errors);
+}
+
+bool FileObject::GetFieldValues(const std::vector<FieldHandle>& fields,
+                                std::vector<Value>* values,
+                                ErrorCollection* errors) const {
+  if (!EnsureLaidOut(errors)) {
+    values->assign(fields.size(), Value{});
+    return false;
+  }
+  std::vector<std::optional<size_t>> indices;
+  indices.reserve(fields.size());
+  for (FieldHandle field : fields) {
+    indices.emplace_back(impl_->FindField(field));
+  }
+  return GetFieldValuesAt(indices, values, errors);
+}
+
+bool FileObject::GetFieldValueAt(std::optional<size_t> index, Value* value,
+                                 ErrorCollection* errors) const {
+  if (!impl_->CheckValid(errors)) {
+    *value = Value{};
+    return false;
+  }
+  if (!index) {
     *value = Value{};
     return true;
   }
 
-  if (!EnsureField(impl_->field_name_map[name], errors))
+  if (!EnsureField(*index, value, errors))
     return false;
-  *value = *impl_->parsed_fields[impl_->field_name_map[name]].value;
+  // Only shrink the cache once the value is copied out of it.
+  if (ValueCache* cache = impl_->value_cache())
+    cache->Trim();
+  return true;
+}
+
+bool FileObject::GetFieldValuesAt(
+    const std::vector<std::optional<size_t>>& indices,
+    std::vector<Value>* values, ErrorCollection* errors) const {
+  values->assign(indices.size(), Value{});
+  if (!impl_->CheckValid(errors))
+    return false;
+  std::vector<size_t> pending;
+  for (size_t i = 0; i < indices.size(); i++) {
+    if (indices[i] && !impl_->GetCachedValue(*indices[i], &(*values)[i]))
+      pending.emplace_back(i);
+  }
+
+  if (!pending.empty()) {
+    // Read the fields in file order, so the reader only moves forward.
+    std::sort(pending.begin(), pending.end(), [&](size_t a, size_t b) {
+      return impl_->field_offset(*indices[a]) <
+             impl_->field_offset(*indices[b]);
+    });
+
+    // If the fields are close together, buffer them all with one read so
+    // reading each field doesn't need to go to the file.
+    const Size first = impl_->field_offset(*indices[pending.front()]);
+    const Size end = impl_->field_end(*indices[pending.back()]);
+    if (end - first <= Size::FromBytes(kBatchReadSize)) {
+      BufferedFileReader* reader = impl_->init.state->reader();
+      if (!reader->Seek(first, errors) ||
+          !reader->EnsureBuffer(end - first, errors)) {
+        values->assign(indices.size(), Value{});
+        return false;
+      }
+    }
+
+    for (size_t i : pending) {
+      if (!EnsureField(*indices[i], &(*values)[i], errors)) {
+        values->assign(indices.size(), Value{});
+        return false;
+      }
+    }
+  }
+
+  // Only shrink the cache once the values are copied out of it.
+  if (ValueCache* cache = impl_->value_cache())
+    cache->Trim();
   return true;
 }
 
 void FileObject::ClearCache() {
-  for (auto& info : impl_->parsed_fields) {
-    info.value.reset();
+  if (!impl_->program)
+    return;
+  impl_->ForgetCachedValues();
+  for (auto& slot : impl_->values) {
+    (void)slot.Take();
   }
 }
 
 bool FileObject::ReparseObject(ErrorCollection* errors) {
   if (!impl_->init.type)
     return true;
+  if (!impl_->CheckValid(errors))
+    return false;
+
+  impl_->init.state->stats()->objects_laid_out++;
+  const TypeProgram& program = impl_->init.type->program();
+  impl_->program = &program;
+  impl_->ForgetCachedValues();
+  impl_->values.clear();
+  impl_->values.reserve(program.fields().size());
+  impl_->dynamic_offsets.resize(program.dynamic_offset_count());
+  // Children from the last parse are now stale.  They check this when used,
+  // so they don't need to be visited here.
+  if (impl_->generation) {
+    impl_->generation->Advance();
+  } else if (program.has_child_objects()) {
+    impl_->generation = impl_->init.state->NewGeneration(
+        impl_->init.parent, impl_->init.parent_count);
+  }
+
+  // When reading eagerly, each field is read as it is declared so the file
+  // is read in order.  Fixed-size types are decoded all at once afterwards.
+  const bool eager = impl_->init.state->eager_decode();
+  const bool eager_fields = eager && !impl_->init.type->static_layout();
+
+  struct Host {
+    bool DeclareField(size_t index, Size offset, ErrorCollection* errors) {
+      AddField(index, offset);
+      if (!eager)
+        return true;
+      Value value;
+      return object->EnsureField(index, &value, errors);
+    }
+
+    void AddField(size_t index, Size offset) {
+      const TypeProgram::Field& field = program->fields()[index];
+      assert(index == object->impl_->values.size());
+      if (field.offset)
+        assert(object->impl_->field_offset(index) == offset);
+      else
+        object->impl_->dynamic_offsets[field.offset_slot] = offset;
+      object->impl_->values.emplace_back();
+    }
 
-  // TODO: This object should be invalid if the parent is reparsed.
-  impl_->parsed_fields.clear();
-  impl_->field_name_map.clear();
-  impl_->parsed_fields.reserve(impl_->init.type->statements().size());
-  impl_->field_name_map.reserve(impl_->init.type->statements().size());
-
-  Size offset = impl_->init.start_position;
-  for (auto stmt : impl_->init.type->statements()) {
-    if (auto field = std::dynamic_pointer_cast<FieldInfo>(stmt)) {
-      impl_->parsed_fields.push_back(
-          {field->name(), field->type(), offset, {}});
-      impl_->field_name_map[field->name()] = impl_->parsed_fields.size() - 1;
-
-      if (!field->type()->static_size().has_value()) {
-        errors->Add({field->type()->debug_info(),
-                    ErrorKind::FieldsMustBeStatic});
+    bool ReadField(size_t index, Size offset, Size* end,
+                   ErrorCollection* errors) {
+      AddField(index, offset);
+      Value value;
+      if (!object->EnsureField(index, &value, errors))
         return false;
+      *end = object->impl_->init.state->reader()->position();
+      return true;
+    }
+
+    bool ReadVarintRun(size_t first, size_t count, Size offset, Size* end,
+                       ErrorCollection* errors) {
+      ParseState* state = object->impl_->init.state.get();
+      size_t decoded = 0;
+      if (offset.bit_offset() == 0) {
+        const uint8_t* buffer;
+        size_t buffer_size;
+        if (!state->reader()->Seek(offset, errors) ||
+            !state->reader()->EnsureBuffer(
+                Size::FromBytes(count * kMaxVarintSize), errors) ||
+            !state->reader()->GetBuffer(&buffer, &buffer_size, errors)) {
+          return false;
+        }
+
+        std::pmr::vector<uint64_t> values(count, state->memory_resource());
+        std::pmr::vector<uint8_t> lengths(count, state->memory_resource());
+        decoded = DecodeLeb128Array(buffer, buffer_size, count, values.data(),
+                                    lengths.data());
+        for (size_t i = 0; i < decoded; i++) {
+          auto* type = static_cast<const VarintTypeInfo*>(
+              program->fields()[first + i].type);
+          // The values were checked as unsigned; a full-length signed value
+          // is read below so it is checked properly.
+          if (lengths[i] == kMaxVarintSize &&
+              type->encoding() == VarintEncoding::SignedLeb128) {
+            decoded = i;
+            break;
+          }
+          AddField(first + i, offset);
+          if (object->impl_->SetValue(
+                  first + i, Value{type->ToNumber(values[i], lengths[i])})) {
+            state->stats()->fields_decoded++;
+          }
+          offset += Size::FromBytes(lengths[i]);
+        }
       }
-      offset += *field->type()->static_size();
-    } else {
-      errors->Add({{}, ErrorKind::Unknown});
-      return false;
+
+      // Read anything left one at a time so the errors are reported.
+      for (size_t i = decoded; i < count; i++) {
+        if (!ReadField(first + i, offset, &offset, errors))
+          return false;
+      }
+      *end = offset;
+      return true;
+    }
+
+    bool ReadLastField(Value* value, Size* offset, ErrorCollection* errors) {
+      const size_t index = object->impl_->values.size() - 1;
+      if (!object->EnsureField(index, value, errors))
+        return false;
+      *offset = object->impl_->field_offset(index);
+      return true;
+    }
+
+    bool VerifyLastChecksum(ErrorCollection* errors) {
+      Impl* impl = object->impl_.get();
+      const size_t index = impl->values.size() - 1;
+      const TypeProgram::Field& field = program->fields()[index];
+      const Size field_offset = impl->field_offset(index);
+      auto* type = static_cast<const ChecksumTypeInfo*>(field.type);
+      const bool previous = type->range() == ChecksumRange::PreviousField;
+      if (previous && index == 0) {
+        errors->Add({type->debug_info(), ErrorKind::ChecksumNoPreviousField,
+                     {field.name}, ErrorLevel::Error,
+                     field_offset.byte_count()});
+        return false;
+      }
+      const Size start = previous ? impl->field_offset(index - 1)
+                                  : impl->init.start_position;
+      if (start.bit_offset() != 0 || field_offset.bit_offset() != 0) {
+        errors->Add({type->debug_info(), ErrorKind::ChecksumAlign,
+                     ErrorLevel::Error, field_offset.byte_count()});
+        return false;
+      }
+
+      // The covered bytes were usually just read, so they are still in the
+      // reader's buffer.
+      BufferedFileReader* reader = impl->init.state->reader();
+      uint32_t checksum = type->initial();
+      for (Size pos = start; pos < field_offset;) {
+        const uint64_t remaining = (field_offset - pos).byte_count();
+        const size_t chunk = static_cast<size_t>(
+            std::min<uint64_t>(remaining, kChecksumChunkSize));
+        const uint8_t* buffer;
+        size_t buffer_size;
+        if (!reader->Seek(pos, errors) ||
+            !reader->EnsureBuffer(Size::FromBytes(chunk), errors) ||
+            !reader->GetBuffer(&buffer, &buffer_size, errors)) {
+          return false;
+        }
+        if (buffer_size == 0) {
+          errors->Add({type->debug_info(), ErrorKind::UnexpectedEndOfStream});
+          return false;
+        }
+        const size_t used = std::min(buffer_size, chunk);
+        checksum = type->Update(buffer, used, checksum);
+        pos += Size::FromBytes(used);
+      }
+
+      Value stored;
+      if (!object->EnsureField(index, &stored, errors))
+        return false;
+      const Value computed{static_cast<uint64_t>(checksum)};
+      if (stored != computed) {
+        errors->Add({type->debug_info(),
+                     ErrorKind::ChecksumMismatch,
+                     {field.name, FormatHex(stored.as_number()),
+                      FormatHex(computed.as_number())},
+                     ErrorLevel::Error,
+                     field_offset.byte_count()});
+        return false;
+      }
+      return true;
+    }
+
+    const TypeProgram* program;
+    FileObject* object;
+    bool eager;
+  };
+  Host host{&program, this, eager_fields};
+  bool ret = program.Execute(impl_->init.start_position, &host,
+                             &impl_->end_position, errors);
+  if (ret && eager && !eager_fields) {
+    // Reading the first field decodes the rest, unless the object isn't
+    // byte-aligned.
+    for (size_t i = 0; ret && i < impl_->values.size(); i++) {
+      Value value;
+      ret = EnsureField(i, &value, errors);
     }
   }
-  return true;
+  // Only publish the layout once it is complete, so threads waiting in
+  // EnsureLaidOut don't use a partial one.
+  if (ret)
+    impl_->layout.store(Impl::kLaidOut, std::memory_order_release);
+  if (ValueCache* cache = impl_->value_cache())
+    cache->Trim();
+  return ret;
+}
+
+void FileObject::DeferLayout(Size end_position) {
+  impl_->end_position = end_position;
+  impl_->layout.store(Impl::kDeferred, std::memory_order_relaxed);
+}
+
+bool FileObject::EnsureLaidOut(ErrorCollection* errors) const {
+  if (impl_->layout.load(std::memory_order_acquire) == Impl::kLaidOut)
+    return true;
+
+  uint8_t expected = Impl::kDeferred;
+  while (!impl_->layout.compare_exchange_weak(expected, Impl::kLayingOut,
+                                              std::memory_order_acquire)) {
+    if (expected == Impl::kLaidOut)
+      return true;
+    expected = Impl::kDeferred;
+    std::this_thread::yield();
+  }
+
+  // Other threads wait above, so this is the only thread changing the
+  // object, as ReparseObject requires.  They only see it once it is fully
+  // laid out; if that fails, the next use tries again.
+  const bool ret = const_cast<FileObject*>(this)->ReparseObject(errors);
+  impl_->layout.store(ret ? Impl::kLaidOut : Impl::kDeferred,
+                      std::memory_order_release);
+  return ret;
+}
+
+bool FileObject::ParseAt(Size start, ErrorCollection* errors) {
+  impl_->init.start_position = start;
+  return ReparseObject(errors);
 }
 
-bool FileObject::EnsureField(size_t index, ErrorCollection* errors) const {
-  auto& info = impl_->parsed_fields[index];
-  if (info.value.has_value())
+StringInternStats FileObject::GetStringInternStats() const {
+  if (!impl_->init.state || !impl_->init.state->interner())
+    return {};
+  return impl_->init.state->interner()->stats();
+}
+
+Size FileObject::end_position() const {
+  return impl_->end_position;
+}
+
+bool FileObject::EnsureField(size_t index, Value* value,
+                             ErrorCollection* errors) const {
+  if (impl_->GetCachedValue(index, value))
     return true;
 
-  if (!impl_->init.file->Seek(info.offset, errors))
+  // Fixed-size records are decoded all at once from the buffer, which avoids
+  // a Seek and ReadValue call for every field.  If the buffer is short (e.g.
+  // the file is truncated), fall back to reading fields one at a time so the
+  // fields that do exist can still be read.
+  const ReadContext ctx(impl_->init.state.get(), errors, impl_->generation);
+  const StaticLayout* layout = impl_->init.type->static_layout();
+  const Size start = impl_->init.start_position;
+  if (layout && start.bit_offset() == 0) {
+    const uint8_t* buffer;
+    size_t buffer_size;
+    if (!ctx.reader()->Seek(start, errors) ||
+        !ctx.reader()->EnsureBuffer(layout->size(), errors) ||
+        !ctx.reader()->GetBuffer(&buffer, &buffer_size, errors)) {
+      return false;
+    }
+    if (buffer_size >= BitsToByteCount(0, layout->size().bit_count())) {
+      // While the object is being laid out, only the fields declared so far
+      // exist.  Fields that are already cached are kept.
+      layout->Decode(buffer, [&](size_t i, Number number) {
+        if (i == index)
+          *value = Value{number};
+        if (i < impl_->values.size() && impl_->SetValue(i, Value{number}))
+          ctx.stats()->fields_decoded++;
+      });
+      return true;
+    }
+  }
+
+  if (!ctx.reader()->Seek(impl_->field_offset(index), errors))
     return false;
   Value temp;
-  if (!info.type->ReadValue(impl_->init.file, &temp, errors))
+  if (!impl_->program->fields()[index].type->ReadValue(ctx, &temp))
     return false;
-  info.value = temp;
+  *value = temp;
+  impl_->SetValue(index, std::move(temp));
+  ctx.stats()->fields_decoded++;
   return true;
 }
 
-FileObject::FileObject(const FileObjectInit& init_data) : impl_(new Impl) {
-  assert(init_data.test_fields.empty() || !init_data.file);
+void FileObject::ImplDeleter::operator()(Impl* impl) const {
+  std::pmr::memory_resource* memory = impl->memory;
+  impl->~Impl();
+  memory->deallocate(impl, sizeof(Impl), alignof(Impl));
+}
+
+FileObject::FileObject(const FileObjectInit& init_data) {
+  std::pmr::memory_resource* memory =
+      init_data.state && init_data.state->arena()
+          ? init_data.state->arena().get()
+          : std::pmr::new_delete_resource();
+  impl_.reset(new (memory->allocate(sizeof(Impl), alignof(Impl)))
+                  Impl(memory));
+
+  assert(init_data.test_fields.empty() || !init_data.state);
 
   impl_->init = init_data;
 
-  impl_->parsed_fields.resize(impl_->init.test_fields.size());
-  for (size_t i = 0; i < impl_->init.test_fields.size(); i++) {
-    impl_->parsed_fields[i].name = impl_->init.test_fields[i].first;
-    impl_->parsed_fields[i].value = impl_->init.test_fields[i].second;
-    impl_->field_name_map[impl_->init.test_fields[i].first] = i;
+  impl_->values.reserve(impl_->init.test_fields.size());
+  for (const auto& field : impl_->init.test_fields) {
+    impl_->values.emplace_back(field.second);
   }
 }
 
@@ -23,16 +23,22 @@
 #include "ast/type_definition.h"
 #include "binary_reader/file_object.h"
 #include "binary_reader/file_system.h"
+#include "binary_reader/record_cursor.h"
 #include "binary_reader/size.h"
 #include "binary_reader/value.h"
+#include "util/arena.h"
+#include "util/read_context.h"
 
 namespace binary_reader {
 
 struct FileObjectInit final {
   // Normal mode
-  std::shared_ptr<BufferedFileReader> file;
+  std::shared_ptr<ParseState> state;
   std::shared_ptr<const TypeDefinition> type;
   Size start_position;
+  // The Generation of the object this was read from, and its count then.
+  std::shared_ptr<const Generation> parent;
+  uint64_t parent_count = 0;
 
   // Test only mode
   std::vector<std::pair<std::string, Value>> test_fields;
@@ -40,14 +46,42 @@ struct FileObjectInit final {
 
 struct FileObjectDeleter final {
   void operator()(FileObject* o) {
-    delete o;
+    if (arena) {
+      o->~FileObject();
+      arena->deallocate(o, sizeof(FileObject), alignof(FileObject));
+    } else {
+      delete o;
+    }
   }
+
+  /// <summary>
+  /// The arena the object was allocated from, or nullptr.  The shared_ptr
+  /// control block holds a reference to it, so this can be a raw pointer.
+  /// </summary>
+  Arena* arena = nullptr;
 };
 
 inline std::shared_ptr<FileObject> MakeFileObject(const FileObjectInit& init) {
+  if (init.state && init.state->arena()) {
+    // Allocate the object and the shared_ptr control block from the arena.
+    ArenaAllocator<FileObject> alloc{init.state->arena()};
+    FileObject* obj = new (alloc.allocate(1)) FileObject(init);
+    return std::shared_ptr<FileObject>(
+        obj, FileObjectDeleter{init.state->arena().get()}, alloc);
+  }
   return std::shared_ptr<FileObject>(new FileObject(init), FileObjectDeleter{});
 }
 
+struct RecordCursorInit final {
+  std::shared_ptr<ParseState> state;
+  std::shared_ptr<const TypeDefinition> type;
+};
+
+inline std::unique_ptr<RecordCursor> MakeRecordCursor(
+    const RecordCursorInit& init) {
+  return std::unique_ptr<RecordCursor>(new RecordCursor(init));
+}
+
 }  // namespace binary_reader
 
 #endif  // BINARY_READER_PUBLIC_FILE_OBJECT_INIT_H_
@@ -16,11 +16,18 @@
 
 #include "ast/type_definition.h"
 #include "parser/definition_parser.h"
+#include "public/file_object_init.h"
 #include "util/buffered_file_reader.h"
+#include "util/read_context.h"
 
 namespace binary_reader {
 
-struct FileParserOptions::Impl {};
+struct FileParserOptions::Impl {
+  bool intern_strings = false;
+  bool use_arena = false;
+  uint64_t cache_budget = 0;
+  bool eager_decode = false;
+};
 
 FileParserOptions::FileParserOptions() : impl_(new Impl) {}
 
@@ -40,6 +47,38 @@ FileParserOptions::FileParserOptions(FileParserOptions&&) = default;
 FileParserOptions& FileParserOptions::operator=(FileParserOptions&&) = default;
 FileParserOptions::~FileParserOptions() = default;
 
+bool FileParserOptions::intern_strings() const {
+  return impl_->intern_strings;
+}
+
+void FileParserOptions::set_intern_strings(bool intern) {
+  impl_->intern_strings = intern;
+}
+
+bool FileParserOptions::use_arena() const {
+  return impl_->use_arena;
+}
+
+void FileParserOptions::set_use_arena(bool use_arena) {
+  impl_->use_arena = use_arena;
+}
+
+uint64_t FileParserOptions::cache_budget() const {
+  return impl_->cache_budget;
+}
+
+void FileParserOptions::set_cache_budget(uint64_t bytes) {
+  impl_->cache_budget = bytes;
+}
+
+bool FileParserOptions::eager_decode() const {
+  return impl_->eager_decode;
+}
+
+void FileParserOptions::set_eager_decode(bool eager) {
+  impl_->eager_decode = eager;
+}
+
 
 struct FileParser::Impl {
   struct FileParserDeleter {
@@ -50,6 +89,42 @@ struct FileParser::Impl {
 
   FileParserOptions options;
   std::vector<std::shared_ptr<TypeDefinition>> definitions;
+
+  /// <summary>
+  /// Finds the top-level type with the given name, or the last one if the
+  /// name is empty.
+  /// </summary>
+  std::shared_ptr<TypeDefinition> FindType(const std::string& type,
+                                           const std::string& path,
+                                           ErrorCollection* errors) const {
+    if (type.empty())
+      return definitions.back();
+    for (auto d : definitions) {
+      if (d->alias_name() == type)
+        return d;
+    }
+    if (errors)
+      errors->Add({{path}, ErrorKind::UnknownType, {type}});
+    return nullptr;
+  }
+
+  /// <summary>
+  /// Creates the state for parsing the given file with these options.
+  /// </summary>
+  std::shared_ptr<ParseState> CreateState(
+      std::shared_ptr<FileReader> file) const {
+    auto state = std::make_shared<ParseState>(
+        std::make_shared<BufferedFileReader>(file));
+    if (options.intern_strings())
+      state->EnableStringInterning();
+    if (options.use_arena())
+      state->EnableArena();
+    if (options.cache_budget() != 0)
+      state->EnableValueCache(options.cache_budget());
+    if (options.eager_decode())
+      state->EnableEagerDecode();
+    return state;
+  }
 };
 
 std::shared_ptr<FileParser> FileParser::CreateFromFile(
@@ -163,6 +238,17 @@ std::vector<std::string> FileParser::GetTypeNames() const {
   return ret;
 }
 
+FieldHandle FileParser::ResolveField(const std::string& type,
+                                     const std::string& field) const {
+  for (auto& def : impl_->definitions) {
+    if (def->alias_name() == type) {
+      const std::optional<size_t> index = def->program().FindField(field);
+      return index ? FieldHandle{&def->program(), *index} : FieldHandle{};
+    }
+  }
+  return {};
+}
+
 std::shared_ptr<FileObject> FileParser::ParseFile(const std::string& path) {
   return ParseFile(path, "", nullptr);
 }
@@ -220,33 +306,55 @@ std::shared_ptr<FileObject> FileParser::ParseFile(std::shared_ptr<FileReader> fi
                                                   const std::string& path,
                                                   const std::string& type,
                                                   ErrorCollection* errors) {
-  std::shared_ptr<TypeDefinition> def;
-  if (type.empty()) {
-    def = impl_->definitions.back();
-  } else {
-    for (auto d : impl_->definitions) {
-      if (d->alias_name() == type) {
-        def = d;
-        break;
-      }
-    }
-  }
-  if (!def) {
-    if (errors)
-      errors->Add({{path}, ErrorKind::UnknownType, {type}});
+  std::shared_ptr<TypeDefinition> def = impl_->FindType(type, path, errors);
+  if (!def)
     return nullptr;
-  }
 
   ErrorCollection temp_errors;
   if (!errors)
     errors = &temp_errors;
 
   Value val;
-  auto reader = std::make_shared<BufferedFileReader>(file);
-  const bool success = def->ReadValue(reader, &val, errors);
+  auto state = impl_->CreateState(file);
+  const bool success = def->ReadValue(ReadContext(state.get(), errors), &val);
   return success ? val.as_object() : nullptr;
 }
 
+std::unique_ptr<RecordCursor> FileParser::ParseRecords(
+    const std::string& path, const std::string& type) {
+  return ParseRecords(path, type, nullptr);
+}
+
+std::unique_ptr<RecordCursor> FileParser::ParseRecords(
+    const std::string& path, const std::string& type,
+    ErrorCollection* errors) {
+  auto file = options().file_system->Open(path);
+  if (!file) {
+    if (errors)
+      errors->Add({{path}, ErrorKind::CannotOpen, {path}});
+    return nullptr;
+  }
+  return ParseRecords(file, type, errors);
+}
+
+std::unique_ptr<RecordCursor> FileParser::ParseRecords(
+    std::shared_ptr<FileReader> reader, const std::string& type) {
+  return ParseRecords(reader, type, nullptr);
+}
+
+std::unique_ptr<RecordCursor> FileParser::ParseRecords(
+    std::shared_ptr<FileReader> reader, const std::string& type,
+    ErrorCollection* errors) {
+  std::shared_ptr<TypeDefinition> def = impl_->FindType(type, "", errors);
+  if (!def)
+    return nullptr;
+
+  RecordCursorInit init;
+  init.state = impl_->CreateState(reader);
+  init.type = def;
+  return MakeRecordCursor(init);
+}
+
 FileParser::FileParser(std::unique_ptr<Impl> impl) : impl_(std::move(impl)) {}
 FileParser::~FileParser() = default;
 
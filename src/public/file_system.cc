@@ -22,6 +22,10 @@
 
 #include <cstdio>
 
+#ifndef WIN32
+#  include <unistd.h>
+#endif
+
 #ifdef WIN32
 #  define fseeko _fseeki64
 #  define ftello _ftelli64
@@ -60,6 +64,31 @@ class FileFileReader final : public FileReader {
     return true;
   }
 
+  bool can_read_at() const override {
+#ifdef WIN32
+    // ReadFile moves the file pointer even when given an offset, which would
+    // break the FILE stream.
+    return false;
+#else
+    return true;
+#endif
+  }
+
+#ifndef WIN32
+  bool ReadAt(uint64_t position, uint8_t* buffer, size_t* size,
+              ErrorCollection* errors) override {
+    // pread doesn't use or change the file offset, so it is safe alongside
+    // the stream functions.
+    const ssize_t read = pread(fileno(fs_), buffer, *size, position);
+    if (read < 0) {
+      errors->Add({{path_}, ErrorKind::IoError, {std::to_string(errno)}});
+      return false;
+    }
+    *size = static_cast<size_t>(read);
+    return true;
+  }
+#endif
+
   bool Seek(uint64_t* position, ErrorCollection* errors) override {
     // We can seek past the end of the file; since we want to only read to the
     // end of the file, clamp it to the size.
@@ -99,6 +128,11 @@ class FStreamFileSystem final : public FileSystem {
 
 }  // namespace
 
+bool FileReader::ReadAt(uint64_t, uint8_t*, size_t*, ErrorCollection* errors) {
+  errors->Add({{}, ErrorKind::ConcurrentReadUnsupported});
+  return false;
+}
+
 bool FileReader::ReadFully(std::vector<uint8_t>* buffer,
                            ErrorCollection* errors) {
   std::vector<uint8_t> ret;
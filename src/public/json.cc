@@ -50,7 +50,7 @@ void DumpJsonObject(std::ostream& os, const JsonOptions& opts,
                     std::shared_ptr<FileObject> obj, size_t indent) {
   bool first = true;
   os << "{";
-  for (auto& name : obj->GetFieldNames()) {
+  obj->ForEachField([&](const std::string& name, const Value& value) {
     if (!first)
       os << ",";
     if (opts.pretty)
@@ -58,9 +58,9 @@ void DumpJsonObject(std::ostream& os, const JsonOptions& opts,
     os << '"' << name << "\":";
     if (opts.pretty)
       os << " ";
-    DumpJsonValue(os, opts, obj->GetFieldValue(name), indent + opts.indent);
+    DumpJsonValue(os, opts, value, indent + opts.indent);
     first = false;
-  }
+  });
   if (!first && opts.pretty)
     os << "\n" << std::string(indent, ' ');
   os << "}";
@@ -18,30 +18,6 @@
 
 namespace binary_reader {
 
-namespace {
-
-template <typename T, typename Variant>
-T cast_variant_number(const Variant& value) {
-  switch (value.index()) {
-    case 0:
-      return clamp_cast<T>(std::get<uintmax_t>(value));
-    case 1:
-      return clamp_cast<T>(std::get<intmax_t>(value));
-    default:
-    case 2:
-      return clamp_cast<T>(std::get<double>(value));
-  }
-}
-
-}  // namespace
-
-Number::~Number() = default;
-
-Number::Number(const Number& other) = default;
-Number::Number(Number&& other) noexcept = default;
-Number& Number::operator=(const Number& other) = default;
-Number& Number::operator=(Number&& other) noexcept = default;
-
 bool Number::is_negative() const {
   return number_type() == NumberType::SignedInt;
 }
@@ -51,26 +27,50 @@ bool Number::is_double() const {
 }
 
 uintmax_t Number::as_unsigned() const {
-  return cast_variant_number<uintmax_t>(value_);
+  switch (number_type()) {
+    case NumberType::UnsignedInt:
+      return unsigned_;
+    case NumberType::SignedInt:
+      return clamp_cast<uintmax_t>(signed_);
+    default:
+    case NumberType::Double:
+      return clamp_cast<uintmax_t>(double_);
+  }
 }
 
 intmax_t Number::as_signed() const {
-  return cast_variant_number<intmax_t>(value_);
+  switch (number_type()) {
+    case NumberType::UnsignedInt:
+      return clamp_cast<intmax_t>(unsigned_);
+    case NumberType::SignedInt:
+      return signed_;
+    default:
+    case NumberType::Double:
+      return clamp_cast<intmax_t>(double_);
+  }
 }
 
 double Number::as_double() const {
-  return cast_variant_number<double>(value_);
+  switch (number_type()) {
+    case NumberType::UnsignedInt:
+      return clamp_cast<double>(unsigned_);
+    case NumberType::SignedInt:
+      return clamp_cast<double>(signed_);
+    default:
+    case NumberType::Double:
+      return double_;
+  }
 }
 
 Number::operator bool() const {
   switch (number_type()) {
     case NumberType::UnsignedInt:
-      return std::get<uintmax_t>(value_) != 0;
+      return unsigned_ != 0;
     case NumberType::SignedInt:
-      return std::get<intmax_t>(value_) != 0;
+      return signed_ != 0;
     default:
     case NumberType::Double:
-      return std::get<double>(value_) != 0;
+      return double_ != 0;
   }
 }
 
@@ -79,27 +79,27 @@ bool Number::operator==(const Number& other) const {
   const auto other_type = other.number_type();
   if (this_type == NumberType::UnsignedInt) {
     if (other_type == NumberType::UnsignedInt) {
-      return std::get<uintmax_t>(value_) == std::get<uintmax_t>(other.value_);
+      return unsigned_ == other.unsigned_;
     } else if (other_type == NumberType::SignedInt) {
       return false;  // Signed version is only used for negative values
     } else {
-      return std::get<uintmax_t>(value_) == std::get<double>(other.value_);
+      return unsigned_ == other.double_;
     }
   } else if (this_type == NumberType::SignedInt) {
     if (other_type == NumberType::UnsignedInt) {
       return false;  // Signed version is only used for negative values
     } else if (other_type == NumberType::SignedInt) {
-      return std::get<intmax_t>(value_) == std::get<intmax_t>(other.value_);
+      return signed_ == other.signed_;
     } else {
-      return std::get<intmax_t>(value_) == std::get<double>(other.value_);
+      return signed_ == other.double_;
     }
   } else {
     if (other_type == NumberType::UnsignedInt) {
-      return std::get<double>(value_) == std::get<uintmax_t>(other.value_);
+      return double_ == other.unsigned_;
     } else if (other_type == NumberType::SignedInt) {
-      return std::get<double>(value_) == std::get<intmax_t>(other.value_);
+      return double_ == other.signed_;
     } else {
-      return std::get<double>(value_) == std::get<double>(other.value_);
+      return double_ == other.double_;
     }
   }
 }
@@ -109,40 +109,32 @@ bool Number::operator<(const Number& other) const {
   switch (number_type()) {
     case NumberType::UnsignedInt:
       if (other_type == NumberType::UnsignedInt) {
-        return std::get<uintmax_t>(value_) < std::get<uintmax_t>(other.value_);
+        return unsigned_ < other.unsigned_;
       } else if (other_type == NumberType::SignedInt) {
         return false;  // Signed version is only used for negative values
       } else {
-        return static_cast<double>(std::get<uintmax_t>(value_)) <
-               std::get<double>(other.value_);
+        return static_cast<double>(unsigned_) < other.double_;
       }
     case NumberType::SignedInt:
       if (other_type == NumberType::UnsignedInt) {
         return true;  // Signed version is only used for negative values
       } else if (other_type == NumberType::SignedInt) {
-        return std::get<intmax_t>(value_) < std::get<intmax_t>(other.value_);
+        return signed_ < other.signed_;
       } else {
-        return static_cast<double>(std::get<intmax_t>(value_)) <
-               std::get<double>(other.value_);
+        return static_cast<double>(signed_) < other.double_;
       }
     default:
     case NumberType::Double:
       if (other_type == NumberType::UnsignedInt) {
-        return std::get<double>(value_) <
-               static_cast<double>(std::get<uintmax_t>(other.value_));
+        return double_ < static_cast<double>(other.unsigned_);
       } else if (other_type == NumberType::SignedInt) {
-        return std::get<double>(value_) <
-               static_cast<double>(std::get<intmax_t>(other.value_));
+        return double_ < static_cast<double>(other.signed_);
       } else {
-        return std::get<double>(value_) < std::get<double>(other.value_);
+        return double_ < other.double_;
       }
   }
 }
 
-Number::NumberType Number::number_type() const {
-  return static_cast<NumberType>(value_.index());
-}
-
 std::ostream& operator<<(std::ostream& os, const Number& value) {
   if (value.is_double())
     return os << value.as_double();
@@ -54,6 +54,12 @@ const OptionTypeInfo kOptionData[] = {
          {u"network", C(ByteOrder::BigEndian)},
          {u"little", C(ByteOrder::LittleEndian)},
      }},
+    {OptionType::ChecksumRange,
+     &Cast<ChecksumRange>,
+     {
+         {u"object", C(ChecksumRange::Object)},
+         {u"previous", C(ChecksumRange::PreviousField)},
+     }},
 };
 #undef C
 
@@ -61,6 +67,8 @@ Options MakeDefault() {
   Options opt;
   opt.byte_order = ByteOrder::BigEndian;
   opt.signedness = Signedness::Unsigned;
+  opt.SetOption(OptionType::ChecksumRange, ChecksumRange::Object);
+  opt.SetOption(OptionType::Encoding, CodecId::Utf8);
   return opt;
 }
 
@@ -74,6 +82,10 @@ std::string to_string(OptionType type) {
       return "signedness";
     case OptionType::ByteOrder:
       return "byte_order";
+    case OptionType::ChecksumRange:
+      return "range";
+    case OptionType::Encoding:
+      return "encoding";
     default:
       return "<Unknown OptionType>";
   }
@@ -101,17 +113,35 @@ std::string to_string(ByteOrder byte_order) {
   }
 }
 
+std::string to_string(ChecksumRange range) {
+  switch (range) {
+    case ChecksumRange::Object:
+      return "object";
+    case ChecksumRange::PreviousField:
+      return "previous";
+    default:
+      return "<Unknown ChecksumRange>";
+  }
+}
+
 OptionType GetOptionType(const UtfString& type) {
   if (type.AsUtf16() == u"signedness") {
     return OptionType::Signedness;
   } else if (type.AsUtf16() == u"byte_order" || type.AsUtf16() == u"order") {
     return OptionType::ByteOrder;
+  } else if (type.AsUtf16() == u"range") {
+    return OptionType::ChecksumRange;
+  } else if (type.AsUtf16() == u"encoding") {
+    return OptionType::Encoding;
   } else {
     return OptionType::Unknown;
   }
 }
 
-struct Options::Impl {};
+struct Options::Impl {
+  ChecksumRange checksum_range = ChecksumRange::Unset;
+  CodecId encoding = CodecId::Unknown;
+};
 
 Options::Options()
     : signedness(Signedness::Unset),
@@ -152,6 +182,18 @@ Options::ParseResult Options::ParseOption(
     }
   }
 
+  // Encodings are named by the codec names, so they aren't in the table.
+  if (types.empty() || types.count(OptionType::Encoding) != 0) {
+    const CodecId id = GetCodecId(value.as_string().AsUtf8());
+    if (id != CodecId::Unknown) {
+      if (found)
+        return ParseResult::Ambiguous;
+      *result_type = OptionType::Encoding;
+      *result = id;
+      found = true;
+    }
+  }
+
   if (found)
     return ParseResult::Success;
   return ParseResult::UnknownString;
@@ -169,6 +211,16 @@ std::any Options::GetOption(OptionType type, const Options& defaults) const {
         return defaults.byte_order;
       else
         return byte_order;
+    case OptionType::ChecksumRange:
+      if (impl_->checksum_range == ChecksumRange::Unset)
+        return defaults.impl_->checksum_range;
+      else
+        return impl_->checksum_range;
+    case OptionType::Encoding:
+      if (impl_->encoding == CodecId::Unknown)
+        return defaults.impl_->encoding;
+      else
+        return impl_->encoding;
     default:
       return {};
   }
@@ -190,6 +242,20 @@ bool Options::SetOption(OptionType type, std::any value) {
       } else {
         return false;
       }
+    case OptionType::ChecksumRange:
+      if (auto* ptr = std::any_cast<ChecksumRange>(&value)) {
+        impl_->checksum_range = *ptr;
+        return true;
+      } else {
+        return false;
+      }
+    case OptionType::Encoding:
+      if (auto* ptr = std::any_cast<CodecId>(&value)) {
+        impl_->encoding = *ptr;
+        return true;
+      } else {
+        return false;
+      }
     default:
       return false;
   }
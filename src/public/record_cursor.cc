@@ -0,0 +1,86 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "binary_reader/record_cursor.h"
+
+#include "public/file_object_init.h"
+
+namespace binary_reader {
+
+struct RecordCursor::Impl {
+  RecordCursorInit init;
+  std::shared_ptr<FileObject> record;
+  Size position;
+  bool done = false;
+};
+
+RecordCursor::RecordCursor(const RecordCursorInit& init)
+    : impl_(new Impl{init, nullptr, Size{}}) {}
+
+RecordCursor::~RecordCursor() = default;
+
+bool RecordCursor::Next() {
+  ErrorCollection errors;
+  return Next(&errors);
+}
+
+bool RecordCursor::Next(ErrorCollection* errors) {
+  if (impl_->done)
+    return false;
+
+  if (impl_->record) {
+    const Size end = impl_->record->end_position();
+    // An empty record would never reach the end of the file.
+    if (end <= impl_->position) {
+      impl_->record.reset();
+      impl_->done = true;
+      return false;
+    }
+    impl_->position = end;
+  }
+
+  ParseState* state = impl_->init.state.get();
+  BufferedFileReader* reader = state->reader();
+  const uint8_t* buffer;
+  size_t buffer_size;
+  bool ok = reader->Seek(impl_->position, errors) &&
+            reader->GetBuffer(&buffer, &buffer_size, errors) &&
+            buffer_size > 0;
+  if (ok) {
+    // Reuse the object unless the app kept a reference to it.
+    if (impl_->record && impl_->record.use_count() == 1) {
+      ok = impl_->record->ParseAt(impl_->position, errors);
+    } else {
+      FileObjectInit init;
+      init.state = impl_->init.state;
+      init.type = impl_->init.type;
+      init.start_position = impl_->position;
+      impl_->record = MakeFileObject(init);
+      state->stats()->objects_created++;
+      ok = impl_->record->ReparseObject(errors);
+    }
+  }
+
+  if (!ok) {
+    impl_->record.reset();
+    impl_->done = true;
+  }
+  return ok;
+}
+
+const std::shared_ptr<FileObject>& RecordCursor::record() const {
+  return impl_->record;
+}
+
+}  // namespace binary_reader
@@ -14,61 +14,147 @@
 
 #include "binary_reader/utf_string.h"
 
+#include <algorithm>
+
 #include "binary_reader/codecs.h"
+#include "util/utf8.h"
 
 namespace binary_reader {
 
+namespace {
+
+// Maps a UTF-16 code unit so that comparing code units compares code points;
+// surrogates sort after the rest of the BMP.
+uint32_t CodePointOrder(char16_t c) {
+  if (c < 0xd800)
+    return c;
+  return c >= 0xe000 ? c - 0x800 : c + 0x2000;
+}
+
+bool LessUtf16(const std::u16string& a, const std::u16string& b) {
+  return std::lexicographical_compare(
+      a.begin(), a.end(), b.begin(), b.end(), [](char16_t x, char16_t y) {
+        return CodePointOrder(x) < CodePointOrder(y);
+      });
+}
+
+std::u16string Utf8ToUtf16(const std::string& str) {
+  std::u16string ret;
+  AppendUtf8AsUtf16(reinterpret_cast<const uint8_t*>(str.data()), str.size(),
+                    &ret);
+  return ret;
+}
+
+std::string Utf16ToUtf8(const std::u16string& str) {
+  std::string ret;
+  AppendUtf16AsUtf8(str.data(), str.size(), &ret);
+  return ret;
+}
+
+}  // namespace
+
 UtfString::UtfString() = default;
-UtfString::UtfString(const std::u16string& str) : utf16_buffer_(str) {}
+UtfString::UtfString(const std::u16string& str)
+    : buffer_(std::in_place_index<1>, str) {}
+UtfString::UtfString(std::u16string&& str)
+    : buffer_(std::in_place_index<1>, std::move(str)) {}
 UtfString::~UtfString() = default;
 UtfString::UtfString(const UtfString&) = default;
 UtfString::UtfString(UtfString&&) = default;
 UtfString& UtfString::operator=(const UtfString&) = default;
 UtfString& UtfString::operator=(UtfString&&) = default;
 
+bool UtfString::operator==(const UtfString& other) const {
+  if (is_utf8() && other.is_utf8())
+    return utf8() == other.utf8();
+  if (!is_utf8() && !other.is_utf8())
+    return utf16() == other.utf16();
+  // UTF-8 buffers are well-formed, so they can't equal a UTF-16 string with
+  // an unpaired surrogate; encoding the UTF-16 side is exact.
+  const std::string& a = is_utf8() ? utf8() : other.utf8();
+  const std::u16string& b = is_utf8() ? other.utf16() : utf16();
+  return a.size() >= b.size() && a == Utf16ToUtf8(b);
+}
+
+bool UtfString::operator<(const UtfString& other) const {
+  // Well-formed UTF-8 sorts by code point when compared bytewise.
+  if (is_utf8() && other.is_utf8())
+    return utf8() < other.utf8();
+  return LessUtf16(AsUtf16(), other.AsUtf16());
+}
+
 UtfString UtfString::FromEncoding(const uint8_t* bytes, size_t size,
-                                  std::shared_ptr<Codec> codec,
+                                  const std::shared_ptr<Codec>& codec,
                                   ErrorInfo* error) {
-  UtfString ret;
-  auto coder = codec->CreateCoder();
-  if (coder->Decode(bytes, size, &ret.utf16_buffer_, error) ==
+  if (codec->id() == CodecId::Utf8 && IsValidUtf8(bytes, size)) {
+    UtfString ret;
+    ret.buffer_.emplace<0>(reinterpret_cast<const char*>(bytes), size);
+    return ret;
+  }
+
+  std::u16string buffer;
+  if (codec->DecodeBuffer(bytes, size, &buffer, error) ==
       TextConverter::Status::Error) {
     return {};
   }
-  return ret;
+  return UtfString{std::move(buffer)};
 }
 
 UtfString UtfString::FromEncoding(const char* bytes, size_t size,
-                                  std::shared_ptr<Codec> codec,
+                                  const std::shared_ptr<Codec>& codec,
                                   ErrorInfo* error) {
   return FromEncoding(reinterpret_cast<const uint8_t*>(bytes), size, codec,
                       error);
 }
 
-UtfString UtfString::FromUtf8(const std::string& str) {
+UtfString UtfString::FromUtf8(std::string str) {
+  if (IsValidUtf8(reinterpret_cast<const uint8_t*>(str.data()), str.size())) {
+    UtfString ret;
+    ret.buffer_.emplace<0>(std::move(str));
+    return ret;
+  }
+
   ErrorInfo error;
-  return FromEncoding(
-      str.data(), str.size(),
-      CodecCollection::CreateDefaultCollection()->GetCodec("utf8"), &error);
+  return FromEncoding(str.data(), str.size(),
+                      CodecCollection::GetBuiltinCodec(CodecId::Utf8), &error);
 }
 
-std::vector<uint8_t> UtfString::AsBytes(std::shared_ptr<Codec> codec,
+std::vector<uint8_t> UtfString::AsBytes(const std::shared_ptr<Codec>& codec,
                                         ErrorInfo* error) const {
+  if (codec->id() == CodecId::Utf8) {
+    const std::string temp = AsUtf8();
+    return std::vector<uint8_t>{temp.begin(), temp.end()};
+  }
+
   std::vector<uint8_t> ret;
-  auto coder = codec->CreateCoder();
-  (void)coder->Encode(utf16_buffer_.data(), utf16_buffer_.size(), &ret, error);
+  if (is_utf8()) {
+    const std::u16string temp = AsUtf16();
+    (void)codec->EncodeBuffer(temp.data(), temp.size(), &ret, error);
+  } else {
+    (void)codec->EncodeBuffer(utf16().data(), utf16().size(), &ret, error);
+  }
   return ret;
 }
 
 std::string UtfString::AsUtf8() const {
-  ErrorInfo error;
-  auto vec = AsBytes(
-      CodecCollection::CreateDefaultCollection()->GetCodec("utf8"), &error);
-  return std::string{vec.begin(), vec.end()};
+  return is_utf8() ? utf8() : Utf16ToUtf8(utf16());
+}
+
+std::u16string UtfString::AsUtf16() const {
+  return is_utf8() ? Utf8ToUtf16(utf8()) : utf16();
+}
+
+size_t UtfString::hash() const {
+  // Hash the UTF-8 form so equal strings hash the same in either form.
+  if (is_utf8())
+    return std::hash<std::string>()(utf8());
+  return std::hash<std::string>()(Utf16ToUtf8(utf16()));
 }
 
 std::ostream& operator<<(std::ostream& os, const UtfString& str) {
   // TODO: Investigate Unicode support on Windows.
+  if (str.is_utf8())
+    return os << str.utf8();
   return os << str.AsUtf8();
 }
 
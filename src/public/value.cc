@@ -14,8 +14,30 @@
 
 #include "binary_reader/value.h"
 
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+#include "util/arena.h"
+
 namespace binary_reader {
 
+namespace {
+
+template <typename T, typename... Args>
+T* NewInArena(Arena* arena, Args&&... args) {
+  return new (arena->allocate(sizeof(T), alignof(T)))
+      T(std::forward<Args>(args)...);
+}
+
+template <typename T>
+void DeleteFromArena(Arena* arena, T* ptr) {
+  ptr->~T();
+  arena->deallocate(ptr, sizeof(T), alignof(T));
+}
+
+}  // namespace
+
 std::ostream& operator<<(std::ostream& os, ValueType value) {
   switch (value) {
     case ValueType::Null:
@@ -31,12 +53,183 @@ std::ostream& operator<<(std::ostream& os, ValueType value) {
   }
 }
 
-Value::Value() {}
-Value::Value(const Value&) = default;
-Value::Value(Value&&) = default;
-Value::~Value() = default;
+struct Value::Payload {
+  std::atomic<uint32_t> ref_count{1};
+  /// <summary>
+  /// The arena the payload was allocated from, or nullptr if it was
+  /// allocated with new.
+  /// </summary>
+  std::shared_ptr<Arena> arena;
+};
+
+struct Value::StringPayload final : Value::Payload {
+  explicit StringPayload(UtfString value) : value(std::move(value)) {}
+
+  size_t GetHash() const {
+    size_t ret = hash.load(std::memory_order_relaxed);
+    if (ret == 0) {
+      // Zero means it hasn't been computed yet.  Threads that race here
+      // store the same value.
+      ret = std::max<size_t>(value.hash(), 1);
+      hash.store(ret, std::memory_order_relaxed);
+    }
+    return ret;
+  }
+
+  const UtfString value;
+  mutable std::atomic<size_t> hash{0};
+};
+
+struct Value::ObjectPayload final : Value::Payload {
+  explicit ObjectPayload(std::shared_ptr<FileObject> value)
+      : value(std::move(value)) {}
+
+  const std::shared_ptr<FileObject> value;
+};
+
+Value::Value(const UtfString& value)
+    : payload_(new StringPayload(value)), tag_(Tag::String) {}
+
+Value::Value(UtfString&& value)
+    : payload_(new StringPayload(std::move(value))), tag_(Tag::String) {}
+
+Value::Value(std::shared_ptr<FileObject> value)
+    : payload_(new ObjectPayload(std::move(value))), tag_(Tag::Object) {}
+
+Value::Value(UtfString&& value, const std::shared_ptr<Arena>& arena)
+    : tag_(Tag::String) {
+  if (arena) {
+    payload_ = NewInArena<StringPayload>(arena.get(), std::move(value));
+    payload_->arena = arena;
+  } else {
+    payload_ = new StringPayload(std::move(value));
+  }
+}
+
+Value::Value(std::shared_ptr<FileObject> value,
+             const std::shared_ptr<Arena>& arena)
+    : tag_(Tag::Object) {
+  if (arena) {
+    payload_ = NewInArena<ObjectPayload>(arena.get(), std::move(value));
+    payload_->arena = arena;
+  } else {
+    payload_ = new ObjectPayload(std::move(value));
+  }
+}
+
+bool Value::operator==(const Value& other) const {
+  // TODO: Consider adding comparing objects.
+  const ValueType type = value_type();
+  if (type != other.value_type())
+    return false;
+  switch (type) {
+    case ValueType::Null:
+      return true;
+    case ValueType::Number:
+      return as_number() == other.as_number();
+    case ValueType::String: {
+      if (payload_ == other.payload_)
+        return true;
+      // Interned strings already have their hash, which makes most unequal
+      // strings cheap to compare.
+      auto* a = static_cast<const StringPayload*>(payload_);
+      auto* b = static_cast<const StringPayload*>(other.payload_);
+      const size_t a_hash = a->hash.load(std::memory_order_relaxed);
+      const size_t b_hash = b->hash.load(std::memory_order_relaxed);
+      if (a_hash != 0 && b_hash != 0 && a_hash != b_hash)
+        return false;
+      return a->value == b->value;
+    }
+    default:
+    case ValueType::Object:
+      return as_object() == other.as_object();
+  }
+}
+
+bool Value::operator<(const Value& other) const {
+  // Order by the value type first, then by the value itself.
+  const ValueType type = value_type();
+  const ValueType other_type = other.value_type();
+  if (type != other_type)
+    return type < other_type;
+  switch (type) {
+    case ValueType::Null:
+      return false;
+    case ValueType::Number:
+      return as_number() < other.as_number();
+    case ValueType::String:
+      return as_string() < other.as_string();
+    default:
+    case ValueType::Object:
+      return as_object() < other.as_object();
+  }
+}
+
+const UtfString& Value::as_string() const& {
+  if (tag_ != Tag::String)
+    throw std::bad_variant_access();
+  return static_cast<const StringPayload*>(payload_)->value;
+}
+
+UtfString Value::as_string() && {
+  // The payload may be shared with other values, so it can't be moved from.
+  const Value& self = *this;
+  return self.as_string();
+}
+
+std::shared_ptr<FileObject> Value::as_object() const {
+  if (tag_ != Tag::Object)
+    throw std::bad_variant_access();
+  return static_cast<const ObjectPayload*>(payload_)->value;
+}
+
+size_t Value::hash() const {
+  switch (tag_) {
+    case Tag::Null:
+      return 0;
+    case Tag::String:
+      return static_cast<const StringPayload*>(payload_)->GetHash();
+    case Tag::Object:
+      return std::hash<FileObject*>()(as_object().get());
+    default:
+      // Equal numbers can have different types, so hash them as doubles.
+      return std::hash<double>()(as_number().as_double());
+  }
+}
+
+size_t Value::memory_size() const {
+  switch (tag_) {
+    case Tag::String:
+      return sizeof(StringPayload) + as_string().memory_size();
+    case Tag::Object:
+      return sizeof(ObjectPayload);
+    default:
+      return 0;
+  }
+}
 
-Value& Value::operator=(const Value&) = default;
-Value& Value::operator=(Value&&) = default;
+void Value::AddRefPayload(Payload* payload) {
+  payload->ref_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Value::ReleasePayload(Payload* payload, Tag tag) {
+  if (payload->ref_count.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    return;
+  // Hold the arena until the payload's memory has been returned to it.
+  const std::shared_ptr<Arena> arena = std::move(payload->arena);
+  if (tag == Tag::String) {
+    auto* str = static_cast<StringPayload*>(payload);
+    if (arena)
+      DeleteFromArena(arena.get(), str);
+    else
+      delete str;
+  } else {
+    auto* obj = static_cast<ObjectPayload*>(payload);
+    if (arena)
+      DeleteFromArena(arena.get(), obj);
+    else
+      delete obj;
+  }
+}
 
 }  // namespace binary_reader
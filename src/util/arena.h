@@ -0,0 +1,126 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BINARY_READER_UTIL_ARENA_H_
+#define BINARY_READER_UTIL_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+#include "util/macros.h"
+#include "util/per_thread.h"
+
+namespace binary_reader {
+
+/// <summary>
+/// A bump allocator for the objects and values created while parsing a
+/// single file.  Allocating just advances a pointer within a chunk, and
+/// freeing does nothing; all the chunks are released at once when the arena
+/// is destroyed.  Everything allocated from the arena must keep a reference
+/// to it (see ArenaAllocator) so it outlives them.
+///
+/// This is thread-safe.  Each thread allocates from its own chunks, so
+/// threads don't contend with each other.
+/// </summary>
+class Arena final : public std::pmr::memory_resource {
+  NON_COPYABLE_OR_MOVABLE_TYPE(Arena);
+
+ public:
+  /// <summary>
+  /// The size of each thread's first chunk; later chunks grow geometrically.
+  /// </summary>
+  static constexpr const size_t kInitialChunkSize = 64 * 1024;
+
+  Arena() = default;
+
+  /// <summary>
+  /// Gets the total number of bytes allocated, including those that were
+  /// later freed.  This must not be called while other threads are
+  /// allocating.
+  /// </summary>
+  uint64_t bytes_allocated() const {
+    uint64_t ret = 0;
+    chunks_.ForEach([&](const ThreadChunks& chunks) { ret += chunks.bytes; });
+    return ret;
+  }
+
+ private:
+  struct ThreadChunks {
+    ThreadChunks() : resource(kInitialChunkSize) {}
+
+    std::pmr::monotonic_buffer_resource resource;
+    uint64_t bytes = 0;
+  };
+
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    ThreadChunks* chunks =
+        chunks_.Get([]() { return std::make_unique<ThreadChunks>(); });
+    chunks->bytes += bytes;
+    return chunks->resource.allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void*, size_t, size_t) override {}
+
+  bool do_is_equal(const memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+  PerThread<ThreadChunks> chunks_;
+};
+
+/// <summary>
+/// A standard allocator that allocates from an Arena and keeps it alive.
+/// std::shared_ptr copies its allocator before freeing its control block, so
+/// the arena is still valid while the last object in it is released.
+/// </summary>
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  explicit ArenaAllocator(std::shared_ptr<Arena> arena)
+      : arena_(std::move(arena)) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+  const std::shared_ptr<Arena>& arena() const {
+    return arena_;
+  }
+
+  T* allocate(size_t count) {
+    return static_cast<T*>(arena_->allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* ptr, size_t count) {
+    arena_->deallocate(ptr, count * sizeof(T), alignof(T));
+  }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const {
+    return arena_ == other.arena();
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& other) const {
+    return arena_ != other.arena();
+  }
+
+ private:
+  std::shared_ptr<Arena> arena_;
+};
+
+}  // namespace binary_reader
+
+#endif  // BINARY_READER_UTIL_ARENA_H_
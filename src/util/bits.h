@@ -0,0 +1,67 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BINARY_READER_UTIL_BITS_H_
+#define BINARY_READER_UTIL_BITS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "binary_reader/options.h"
+
+namespace binary_reader {
+
+/// <summary>
+/// Returns the number of bytes touched by a value of |size| bits starting at
+/// |bit_offset| within the first byte.
+/// </summary>
+inline size_t BitsToByteCount(uint8_t bit_offset, uint64_t size) {
+  return static_cast<size_t>((bit_offset + size + 7) / 8);
+}
+
+/// <summary>
+/// Loads an unsigned integer of up to 64 bits from the given buffer.  Big
+/// endian values are read most significant bit first and can start at any
+/// bit offset.  Little endian values must be byte aligned and a whole number
+/// of bytes; the caller is expected to check this.  The buffer must contain
+/// at least BitsToByteCount(bit_offset, size) bytes.
+/// </summary>
+inline uint64_t LoadBits(const uint8_t* buffer, uint8_t bit_offset,
+                         size_t size, ByteOrder order) {
+  uint64_t value = 0;
+  if (order == ByteOrder::LittleEndian) {
+    for (size_t i = 0; i < size / 8; i++)
+      value |= static_cast<uint64_t>(buffer[i]) << (8u * i);
+    return value;
+  }
+
+  size_t remaining = size;
+  if (bit_offset != 0) {
+    // Take the low bits of the partial first byte.
+    const size_t available = 8u - bit_offset;
+    const size_t used = remaining < available ? remaining : available;
+    value = (*buffer >> (available - used)) & ((1u << used) - 1);
+    remaining -= used;
+    buffer++;
+  }
+  for (; remaining >= 8; remaining -= 8)
+    value = (value << 8) | *buffer++;
+  if (remaining != 0)
+    value = (value << remaining) | (*buffer >> (8 - remaining));
+  return value;
+}
+
+}  // namespace binary_reader
+
+#endif  // BINARY_READER_UTIL_BITS_H_
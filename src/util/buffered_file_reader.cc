@@ -17,24 +17,39 @@
 #include <assert.h>
 #include <string.h>
 
-namespace binary_reader {
-
-namespace {
-
-constexpr const size_t kBufferSize = 64 * 1024 * 1024;
+#include <algorithm>
 
-}  // namespace
+namespace binary_reader {
 
 BufferedFileReader::BufferedFileReader(std::shared_ptr<FileReader> reader)
-    : reader_(reader), buffer_(new uint8_t[kBufferSize]), used_(0) {}
+    : BufferedFileReader(std::move(reader), false) {}
+
+BufferedFileReader::BufferedFileReader(std::shared_ptr<FileReader> reader,
+                                       bool positional)
+    : reader_(reader),
+      buffer_(new uint8_t[positional ? kPositionalReadSize : kBufferSize]),
+      capacity_(positional ? kPositionalReadSize : kBufferSize),
+      used_(0),
+      positioned_(false),
+      positional_(positional) {}
+
+std::unique_ptr<BufferedFileReader> BufferedFileReader::CreatePositional(
+    std::shared_ptr<FileReader> reader) {
+  return std::unique_ptr<BufferedFileReader>(
+      new BufferedFileReader(std::move(reader), true));
+}
 
 Size BufferedFileReader::position() const {
   return start_position_ + buffer_offset_;
 }
 
 bool BufferedFileReader::Seek(Size position, ErrorCollection* errors) {
+  // Once positioned, the underlying reader is always just past the buffered
+  // data, so seeking within that byte doesn't need to move it.
+  const Size buffer_end = start_position_ + Size::FromBytes(used_);
   if (position >= start_position_ &&
-      position < start_position_ + Size::FromBytes(used_)) {
+      (position < buffer_end ||
+       (positioned_ && position.ClipToByte() == buffer_end))) {
     buffer_offset_ = position - start_position_;
     return true;
   }
@@ -42,9 +57,15 @@ bool BufferedFileReader::Seek(Size position, ErrorCollection* errors) {
   start_position_ = position.ClipToByte();
   buffer_offset_ = Size::FromBits(position.bit_offset());
   used_ = 0;
+  positioned_ = false;
+  if (positional_) {
+    positioned_ = true;
+    return true;
+  }
   uint64_t byte_pos = position.byte_count();
   if (!reader_->Seek(&byte_pos, errors))
     return false;
+  positioned_ = true;
   return true;
 }
 
@@ -67,21 +88,33 @@ bool BufferedFileReader::EnsureBuffer(Size size, ErrorCollection* errors) {
   assert(buffer_offset_ <= Size::FromBytesAndOffset(kBufferSize, 7));
   assert(buffer_offset_ <= Size::FromBytesAndOffset(used_, 7));
 
-  if (buffer_offset_ + size > Size::FromBytes(kBufferSize)) {
+  if (buffer_offset_ + size > Size::FromBytes(capacity_)) {
     // If we don't have enough space, move the existing buffer back to the
     // start of the buffer.
     const uint64_t count = buffer_offset_.byte_count();
-    memmove(buffer_.get(), buffer_.get() + count, kBufferSize - count);
+    memmove(buffer_.get(), buffer_.get() + count, used_ - count);
     used_ -= count;
     start_position_ += Size::FromBytes(count);
     buffer_offset_ = Size::FromBits(buffer_offset_.bit_offset());
   }
+  if (buffer_offset_ + size > Size::FromBytes(capacity_) &&
+      capacity_ < kBufferSize) {
+    Grow((buffer_offset_ + size).byte_count() + 1);
+  }
 
   while (buffer_offset_ + size > Size::FromBytes(used_)) {
     uint8_t* output = buffer_.get() + used_;
-    size_t to_read = kBufferSize - used_;
-    if (!reader_->Read(output, &to_read, errors))
+    size_t to_read = capacity_ - used_;
+    if (positional_) {
+      const uint64_t needed = (buffer_offset_ + size).byte_count() + 1 - used_;
+      to_read = std::min<uint64_t>(
+          to_read, std::max<uint64_t>(needed, kPositionalReadSize));
+      const uint64_t file_pos = start_position_.byte_count() + used_;
+      if (!reader_->ReadAt(file_pos, output, &to_read, errors))
+        return false;
+    } else if (!reader_->Read(output, &to_read, errors)) {
       return false;
+    }
     if (!to_read)  // EOF
       break;
     used_ += to_read;
@@ -90,4 +123,16 @@ bool BufferedFileReader::EnsureBuffer(Size size, ErrorCollection* errors) {
   return true;
 }
 
+void BufferedFileReader::Grow(size_t size) {
+  size_t capacity = capacity_;
+  while (capacity < size)
+    capacity *= 2;
+  capacity = std::min(capacity, kBufferSize);
+
+  std::unique_ptr<uint8_t[]> buffer(new uint8_t[capacity]);
+  memcpy(buffer.get(), buffer_.get(), used_);
+  buffer_ = std::move(buffer);
+  capacity_ = capacity;
+}
+
 }  // namespace binary_reader
@@ -33,10 +33,42 @@ class BufferedFileReader final {
   NON_COPYABLE_OR_MOVABLE_TYPE(BufferedFileReader);
 
  public:
+  /// <summary>
+  /// The most bytes that can be buffered at once.
+  /// </summary>
+  static constexpr const size_t kBufferSize = 64 * 1024 * 1024;
+
+  /// <summary>
+  /// How much a positional reader reads at once, which is also the size its
+  /// buffer starts at.  These only read a few fields at a time, so filling
+  /// (or allocating) the whole buffer would be wasteful.
+  /// </summary>
+  static constexpr const size_t kPositionalReadSize = 64 * 1024;
+
   explicit BufferedFileReader(std::shared_ptr<FileReader> reader);
 
+  /// <summary>
+  /// Creates a reader that reads using FileReader::ReadAt, so it doesn't use
+  /// or change the file's position.  This allows other threads to read the
+  /// same file at the same time with their own readers.  The buffer only
+  /// grows past kPositionalReadSize when a larger read needs it.
+  /// </summary>
+  static std::unique_ptr<BufferedFileReader> CreatePositional(
+      std::shared_ptr<FileReader> reader);
+
+  const std::shared_ptr<FileReader>& file() const {
+    return reader_;
+  }
+
   Size position() const;
 
+  /// <summary>
+  /// Gets the number of bytes the buffer can hold right now.
+  /// </summary>
+  size_t capacity() const {
+    return capacity_;
+  }
+
   /// <summary>
   /// Seeks the current position of the reader to the given absolute file
   /// position.
@@ -77,11 +109,21 @@ class BufferedFileReader final {
   bool EnsureBuffer(Size size, ErrorCollection* errors);
 
  private:
+  BufferedFileReader(std::shared_ptr<FileReader> reader, bool positional);
+
+  /// <summary>
+  /// Grows the buffer so it can hold at least |size| bytes.
+  /// </summary>
+  void Grow(size_t size);
+
   const std::shared_ptr<FileReader> reader_;
-  const std::unique_ptr<uint8_t[]> buffer_;
+  std::unique_ptr<uint8_t[]> buffer_;
+  size_t capacity_;
   Size start_position_;
   Size buffer_offset_;
   size_t used_;
+  bool positioned_;
+  const bool positional_;
 };
 
 }  // namespace binary_reader
@@ -0,0 +1,223 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/checksum.h"
+
+#include "util/cpu_features.h"
+
+#if defined(__ARM_FEATURE_CRC32)
+#  include <arm_acle.h>
+#endif
+
+namespace binary_reader {
+
+namespace {
+
+struct CrcTables {
+  uint32_t table[8][256];
+};
+
+/// <summary>
+/// Builds the tables for a bit-reflected CRC using slicing-by-8, where
+/// table[k][i] is the CRC of byte i followed by k zero bytes.
+/// </summary>
+constexpr CrcTables MakeCrcTables(uint32_t polynomial) {
+  CrcTables ret{};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int j = 0; j < 8; j++)
+      crc = (crc >> 1) ^ ((crc & 1) ? polynomial : 0);
+    ret.table[0][i] = crc;
+  }
+  for (size_t k = 1; k < 8; k++) {
+    for (uint32_t i = 0; i < 256; i++) {
+      const uint32_t prev = ret.table[k - 1][i];
+      ret.table[k][i] = (prev >> 8) ^ ret.table[0][prev & 0xff];
+    }
+  }
+  return ret;
+}
+
+constexpr const CrcTables kCrc32Tables = MakeCrcTables(0xedb88320);
+constexpr const CrcTables kCrc32cTables = MakeCrcTables(0x82f63b78);
+
+uint32_t Load32(const uint8_t* data) {
+  return static_cast<uint32_t>(data[0]) |
+         (static_cast<uint32_t>(data[1]) << 8) |
+         (static_cast<uint32_t>(data[2]) << 16) |
+         (static_cast<uint32_t>(data[3]) << 24);
+}
+
+/// <summary>
+/// Updates the (inverted) CRC state 8 bytes at a time using the tables.
+/// </summary>
+uint32_t CrcTable(const CrcTables& tables, const uint8_t* data, size_t size,
+                  uint32_t state) {
+  const auto& t = tables.table;
+  for (; size >= 8; size -= 8, data += 8) {
+    const uint32_t low = Load32(data) ^ state;
+    const uint32_t high = Load32(data + 4);
+    state = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^
+            t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^ t[3][high & 0xff] ^
+            t[2][(high >> 8) & 0xff] ^ t[1][(high >> 16) & 0xff] ^
+            t[0][high >> 24];
+  }
+  for (; size > 0; size--, data++)
+    state = (state >> 8) ^ t[0][(state ^ *data) & 0xff];
+  return state;
+}
+
+#ifdef BINARY_READER_X86
+/// <summary>
+/// Multiplies both halves of |x| by the constants in |k| and adds |next|.
+/// </summary>
+TARGET_ATTRIBUTE("pclmul")
+inline __m128i Fold(__m128i x, __m128i k, __m128i next) {
+  const __m128i low = _mm_clmulepi64_si128(x, k, 0x00);
+  const __m128i high = _mm_clmulepi64_si128(x, k, 0x11);
+  return _mm_xor_si128(_mm_xor_si128(high, low), next);
+}
+
+/// <summary>
+/// Folds the data with carry-less multiplication, following "Fast CRC
+/// Computation for Generic Polynomials Using PCLMULQDQ Instruction" (Intel).
+/// The size must be at least 64 and a multiple of 16.
+/// </summary>
+TARGET_ATTRIBUTE("sse4.1,pclmul")
+uint32_t Crc32Pclmul(const uint8_t* data, size_t size, uint32_t state) {
+  // The constants for the bit-reflected CRC-32 polynomial.
+  const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+  const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+  const __m128i k5k0 = _mm_set_epi64x(0, 0x0163cd6124);
+  const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+  const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+  auto load = [](const uint8_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  };
+
+  // Fold four blocks in parallel.
+  __m128i x1 = _mm_xor_si128(load(data), _mm_cvtsi32_si128(state));
+  __m128i x2 = load(data + 16);
+  __m128i x3 = load(data + 32);
+  __m128i x4 = load(data + 48);
+  data += 64;
+  size -= 64;
+  for (; size >= 64; size -= 64, data += 64) {
+    x1 = Fold(x1, k1k2, load(data));
+    x2 = Fold(x2, k1k2, load(data + 16));
+    x3 = Fold(x3, k1k2, load(data + 32));
+    x4 = Fold(x4, k1k2, load(data + 48));
+  }
+
+  // Fold into a single block, then fold any remaining blocks.
+  x1 = Fold(x1, k3k4, x2);
+  x1 = Fold(x1, k3k4, x3);
+  x1 = Fold(x1, k3k4, x4);
+  for (; size >= 16; size -= 16, data += 16)
+    x1 = Fold(x1, k3k4, load(data));
+
+  // Fold 128 bits to 64 bits.
+  __m128i x2b = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2b);
+  x2b = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, mask32);
+  x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+  x1 = _mm_xor_si128(x1, x2b);
+
+  // Barrett reduction to 32 bits.
+  x2b = _mm_and_si128(x1, mask32);
+  x2b = _mm_clmulepi64_si128(x2b, poly, 0x10);
+  x2b = _mm_and_si128(x2b, mask32);
+  x2b = _mm_clmulepi64_si128(x2b, poly, 0x00);
+  x1 = _mm_xor_si128(x1, x2b);
+  return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+TARGET_ATTRIBUTE("sse4.2")
+uint32_t Crc32cSse42(const uint8_t* data, size_t size, uint32_t state) {
+#  if defined(__x86_64__) || defined(_M_X64)
+  uint64_t state64 = state;
+  for (; size >= 8; size -= 8, data += 8) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < 8; i++)
+      value |= static_cast<uint64_t>(data[i]) << (8 * i);
+    state64 = _mm_crc32_u64(state64, value);
+  }
+  state = static_cast<uint32_t>(state64);
+#  endif
+  for (; size >= 4; size -= 4, data += 4)
+    state = _mm_crc32_u32(state, Load32(data));
+  for (; size > 0; size--, data++)
+    state = _mm_crc32_u8(state, *data);
+  return state;
+}
+#endif
+
+}  // namespace
+
+uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc) {
+  uint32_t state = ~crc;
+#if defined(BINARY_READER_X86)
+  if (size >= 64 && GetCpuFeatures().pclmul && GetCpuFeatures().sse42) {
+    const size_t chunk = size & ~static_cast<size_t>(15);
+    state = Crc32Pclmul(data, chunk, state);
+    data += chunk;
+    size -= chunk;
+  }
+#elif defined(__ARM_FEATURE_CRC32)
+  for (; size >= 8; size -= 8, data += 8) {
+    state = __crc32w(state, Load32(data));
+    state = __crc32w(state, Load32(data + 4));
+  }
+#endif
+  return ~CrcTable(kCrc32Tables, data, size, state);
+}
+
+uint32_t Crc32c(const uint8_t* data, size_t size, uint32_t crc) {
+  uint32_t state = ~crc;
+#if defined(BINARY_READER_X86)
+  if (GetCpuFeatures().sse42)
+    return ~Crc32cSse42(data, size, state);
+#elif defined(__ARM_FEATURE_CRC32)
+  for (; size >= 8; size -= 8, data += 8) {
+    state = __crc32cw(state, Load32(data));
+    state = __crc32cw(state, Load32(data + 4));
+  }
+#endif
+  return ~CrcTable(kCrc32cTables, data, size, state);
+}
+
+uint32_t Adler32(const uint8_t* data, size_t size, uint32_t adler) {
+  // The largest number of bytes that can be summed before |b| could overflow
+  // 32 bits, so the modulo is only needed once per block.
+  constexpr const uint32_t kModulus = 65521;
+  constexpr const size_t kMaxBlock = 5552;
+
+  uint32_t a = adler & 0xffff;
+  uint32_t b = adler >> 16;
+  while (size > 0) {
+    const size_t block = size < kMaxBlock ? size : kMaxBlock;
+    for (size_t i = 0; i < block; i++) {
+      a += data[i];
+      b += a;
+    }
+    a %= kModulus;
+    b %= kModulus;
+    data += block;
+    size -= block;
+  }
+  return (b << 16) | a;
+}
+
+}  // namespace binary_reader
@@ -0,0 +1,44 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BINARY_READER_UTIL_CHECKSUM_H_
+#define BINARY_READER_UTIL_CHECKSUM_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace binary_reader {
+
+/// <summary>
+/// Computes the CRC-32 (as used by zlib, PNG, and Ethernet) of the given
+/// data.  To checksum data in pieces, pass the result of the previous piece
+/// as |crc|.
+/// </summary>
+uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+
+/// <summary>
+/// Computes the CRC-32C (Castagnoli, as used by iSCSI, ext4, and many record
+/// formats) of the given data.  This continues from |crc| like Crc32.
+/// </summary>
+uint32_t Crc32c(const uint8_t* data, size_t size, uint32_t crc = 0);
+
+/// <summary>
+/// Computes the Adler-32 (as used by zlib streams) of the given data.  This
+/// continues from |adler|, which starts at 1.
+/// </summary>
+uint32_t Adler32(const uint8_t* data, size_t size, uint32_t adler = 1);
+
+}  // namespace binary_reader
+
+#endif  // BINARY_READER_UTIL_CHECKSUM_H_
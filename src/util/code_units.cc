@@ -0,0 +1,114 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/code_units.h"
+
+#include <cstring>
+
+#include "util/cpu_features.h"
+
+namespace binary_reader {
+
+namespace {
+
+#if defined(__SSE2__) || defined(_M_X64)
+// x86 is little endian, so "native" below means little endian.
+
+__m128i Load(const void* buffer) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer));
+}
+
+void Store(void* buffer, __m128i value) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(buffer), value);
+}
+
+__m128i SwapBytes(__m128i value) {
+  return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+}
+#endif
+
+}  // namespace
+
+void WidenLatin1(const uint8_t* buffer, size_t size, char16_t* output) {
+  size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= size; i += 16) {
+    const __m128i input = Load(buffer + i);
+    Store(output + i, _mm_unpacklo_epi8(input, zero));
+    Store(output + i + 8, _mm_unpackhi_epi8(input, zero));
+  }
+#endif
+  for (; i < size; i++)
+    output[i] = buffer[i];
+}
+
+size_t NarrowLatin1(const char16_t* buffer, size_t size, uint8_t* output) {
+  size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+  const __m128i high_bits = _mm_set1_epi16(static_cast<int16_t>(0xff00));
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= size; i += 16) {
+    const __m128i a = Load(buffer + i);
+    const __m128i b = Load(buffer + i + 8);
+    const __m128i high = _mm_and_si128(_mm_or_si128(a, b), high_bits);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) != 0xffff)
+      break;
+    Store(output + i, _mm_packus_epi16(a, b));
+  }
+#endif
+  for (; i < size && buffer[i] <= 0xff; i++)
+    output[i] = static_cast<uint8_t>(buffer[i]);
+  return i;
+}
+
+void LoadUtf16(const uint8_t* buffer, size_t count, bool big_endian,
+               char16_t* output) {
+  size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+  if (!big_endian) {
+    std::memcpy(output, buffer, count * 2);
+    return;
+  }
+  for (; i + 8 <= count; i += 8)
+    Store(output + i, SwapBytes(Load(buffer + i * 2)));
+#endif
+  for (; i < count; i++) {
+    const uint8_t* cur = buffer + i * 2;
+    output[i] = big_endian ? static_cast<char16_t>((cur[0] << 8) | cur[1])
+                           : static_cast<char16_t>((cur[1] << 8) | cur[0]);
+  }
+}
+
+void StoreUtf16(const char16_t* buffer, size_t count, bool big_endian,
+                uint8_t* output) {
+  size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+  if (!big_endian) {
+    std::memcpy(output, buffer, count * 2);
+    return;
+  }
+  for (; i + 8 <= count; i += 8)
+    Store(output + i * 2, SwapBytes(Load(buffer + i)));
+#endif
+  for (; i < count; i++) {
+    uint8_t* cur = output + i * 2;
+    const uint8_t high = static_cast<uint8_t>(buffer[i] >> 8);
+    const uint8_t low = static_cast<uint8_t>(buffer[i] & 0xff);
+    cur[0] = big_endian ? high : low;
+    cur[1] = big_endian ? low : high;
+  }
+}
+
+}  // namespace binary_reader
@@ -0,0 +1,52 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BINARY_READER_UTIL_CODE_UNITS_H_
+#define BINARY_READER_UTIL_CODE_UNITS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace binary_reader {
+
+/// <summary>
+/// Converts Latin-1 (ISO-8859-1) bytes to UTF-16.  Every byte maps to the
+/// code point with the same value.
+/// </summary>
+/// <param name="output">Must have room for |size| code units.</param>
+void WidenLatin1(const uint8_t* buffer, size_t size, char16_t* output);
+
+/// <summary>
+/// Converts the leading UTF-16 code units that are at most U+00FF to Latin-1.
+/// This stops at the first code unit that doesn't fit.
+/// </summary>
+/// <param name="output">Must have room for |size| bytes.</param>
+/// <returns>The number of code units converted.</returns>
+size_t NarrowLatin1(const char16_t* buffer, size_t size, uint8_t* output);
+
+/// <summary>
+/// Reads |count| UTF-16 code units stored in the given byte order.
+/// </summary>
+void LoadUtf16(const uint8_t* buffer, size_t count, bool big_endian,
+               char16_t* output);
+
+/// <summary>
+/// Writes |count| UTF-16 code units in the given byte order.
+/// </summary>
+void StoreUtf16(const char16_t* buffer, size_t count, bool big_endian,
+                uint8_t* output);
+
+}  // namespace binary_reader
+
+#endif  // BINARY_READER_UTIL_CODE_UNITS_H_
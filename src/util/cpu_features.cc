@@ -0,0 +1,97 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/cpu_features.h"
+
+#ifdef BINARY_READER_X86
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  else
+#    include <cpuid.h>
+#  endif
+#endif
+
+#include <cstdint>
+
+namespace binary_reader {
+
+namespace {
+
+#ifdef BINARY_READER_X86
+struct CpuIdResult {
+  uint32_t eax = 0;
+  uint32_t ebx = 0;
+  uint32_t ecx = 0;
+  uint32_t edx = 0;
+};
+
+CpuIdResult CpuId(uint32_t leaf) {
+  CpuIdResult ret;
+#  ifdef _MSC_VER
+  int regs[4];
+  __cpuidex(regs, static_cast<int>(leaf), 0);
+  ret.eax = static_cast<uint32_t>(regs[0]);
+  ret.ebx = static_cast<uint32_t>(regs[1]);
+  ret.ecx = static_cast<uint32_t>(regs[2]);
+  ret.edx = static_cast<uint32_t>(regs[3]);
+#  else
+  if (leaf > __get_cpuid_max(0, nullptr))
+    return ret;
+  __cpuid_count(leaf, 0, ret.eax, ret.ebx, ret.ecx, ret.edx);
+#  endif
+  return ret;
+}
+
+// Returns whether the OS saves the AVX (YMM) register state.  VEX-encoded
+// instructions fault without this, even for 128-bit registers.
+bool OsSupportsAvx(const CpuIdResult& leaf1) {
+  constexpr const uint32_t kOsXsave = 1u << 27;
+  constexpr const uint32_t kAvx = 1u << 28;
+  if ((leaf1.ecx & (kOsXsave | kAvx)) != (kOsXsave | kAvx))
+    return false;
+#  ifdef _MSC_VER
+  const uint64_t xcr0 = _xgetbv(0);
+#  else
+  uint32_t xcr0_low, xcr0_high;
+  __asm__("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+  const uint64_t xcr0 = (static_cast<uint64_t>(xcr0_high) << 32) | xcr0_low;
+#  endif
+  // XMM and YMM state must both be enabled.
+  return (xcr0 & 0x6) == 0x6;
+}
+#endif
+
+CpuFeatures DetectCpuFeatures() {
+  CpuFeatures ret;
+#ifdef BINARY_READER_X86
+  const CpuIdResult leaf1 = CpuId(1);
+  const bool avx = OsSupportsAvx(leaf1);
+  ret.f16c = avx && (leaf1.ecx & (1u << 29)) != 0;
+  // SSE4.2 implies SSE4.1 on every real CPU, but check both since the
+  // kernels use instructions from each.
+  ret.sse42 = (leaf1.ecx & (1u << 19)) != 0 && (leaf1.ecx & (1u << 20)) != 0;
+  ret.pclmul = (leaf1.ecx & (1u << 1)) != 0;
+  ret.avx2 = avx && (CpuId(7).ebx & (1u << 5)) != 0;
+#endif
+  return ret;
+}
+
+}  // namespace
+
+const CpuFeatures& GetCpuFeatures() {
+  static const CpuFeatures features = DetectCpuFeatures();
+  return features;
+}
+
+}  // namespace binary_reader
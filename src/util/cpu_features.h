@@ -0,0 +1,66 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BINARY_READER_UTIL_CPU_FEATURES_H_
+#define BINARY_READER_UTIL_CPU_FEATURES_H_
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#  define BINARY_READER_X86 1
+#  include <immintrin.h>
+#endif
+
+// Compiles a single function for the given instruction set extensions so it
+// can use their intrinsics without changing the flags for the whole build.
+// The function must only be called after checking GetCpuFeatures().  MSVC
+// allows any intrinsic without this, so it expands to nothing there.
+#if defined(BINARY_READER_X86) && defined(__GNUC__)
+#  define TARGET_ATTRIBUTE(features) __attribute__((target(features)))
+#else
+#  define TARGET_ATTRIBUTE(features)
+#endif
+
+namespace binary_reader {
+
+/// <summary>
+/// Describes the optional instruction set extensions supported by the current
+/// CPU (and OS).  These are detected once on first use.
+/// </summary>
+struct CpuFeatures final {
+  /// <summary>
+  /// Half-precision float conversions (VCVTPH2PS).
+  /// </summary>
+  bool f16c = false;
+  /// <summary>
+  /// SSE4.1 and SSE4.2, which includes the CRC32 (Castagnoli) instruction.
+  /// </summary>
+  bool sse42 = false;
+  /// <summary>
+  /// Carry-less multiplication (PCLMULQDQ).
+  /// </summary>
+  bool pclmul = false;
+  /// <summary>
+  /// 256-bit integer SIMD.
+  /// </summary>
+  bool avx2 = false;
+};
+
+/// <summary>
+/// Gets the features of the current CPU.  This is thread-safe.
+/// </summary>
+const CpuFeatures& GetCpuFeatures();
+
+}  // namespace binary_reader
+
+#endif  // BINARY_READER_UTIL_CPU_FEATURES_H_
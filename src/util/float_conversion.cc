@@ -0,0 +1,155 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/float_conversion.h"
+
+#include <cstring>
+
+#include "util/cpu_features.h"
+
+namespace binary_reader {
+
+namespace {
+
+uint16_t Load16(const uint8_t* data, bool little_endian) {
+  if (little_endian)
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+  return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+uint32_t Load32(const uint8_t* data, bool little_endian) {
+  uint32_t ret = 0;
+  for (size_t i = 0; i < 4; i++) {
+    const size_t shift = little_endian ? i * 8 : (3 - i) * 8;
+    ret |= static_cast<uint32_t>(data[i]) << shift;
+  }
+  return ret;
+}
+
+uint64_t Load64(const uint8_t* data, bool little_endian) {
+  uint64_t ret = 0;
+  for (size_t i = 0; i < 8; i++) {
+    const size_t shift = little_endian ? i * 8 : (7 - i) * 8;
+    ret |= static_cast<uint64_t>(data[i]) << shift;
+  }
+  return ret;
+}
+
+#ifdef BINARY_READER_X86
+TARGET_ATTRIBUTE("avx,f16c")
+size_t DecodeFloat16ArrayF16c(const uint8_t* data, size_t count,
+                              bool little_endian, double* output) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i half =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 2));
+    if (!little_endian)
+      half = _mm_or_si128(_mm_slli_epi16(half, 8), _mm_srli_epi16(half, 8));
+    const __m256 single = _mm256_cvtph_ps(half);
+    _mm256_storeu_pd(output + i,
+                     _mm256_cvtps_pd(_mm256_castps256_ps128(single)));
+    _mm256_storeu_pd(output + i + 4,
+                     _mm256_cvtps_pd(_mm256_extractf128_ps(single, 1)));
+  }
+  return i;
+}
+#endif
+
+}  // namespace
+
+double Float16ToDouble(uint16_t bits) {
+  const uint32_t sign = static_cast<uint32_t>(bits & 0x8000u) << 16;
+  uint32_t exponent = (bits >> 10) & 0x1f;
+  uint32_t mantissa = bits & 0x3ff;
+
+  // Build the equivalent single-precision bits; the exponent bias changes from
+  // 15 to 127.
+  uint32_t single;
+  if (exponent == 0x1f) {
+    // Infinity and NaN keep their payload.
+    single = sign | 0x7f800000u | (mantissa << 13);
+  } else if (exponent != 0) {
+    single = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  } else if (mantissa == 0) {
+    single = sign;
+  } else {
+    // Subnormal halves are normal singles, so shift until the implicit bit is
+    // set.
+    exponent = 113;
+    while ((mantissa & 0x400) == 0) {
+      mantissa <<= 1;
+      exponent--;
+    }
+    single = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+  }
+
+  float ret;
+  std::memcpy(&ret, &single, sizeof(ret));
+  return ret;
+}
+
+double FloatBitsToDouble(uint64_t bits, size_t bit_size) {
+  switch (bit_size) {
+    case 16:
+      return Float16ToDouble(static_cast<uint16_t>(bits));
+    case 32: {
+      const uint32_t bits32 = static_cast<uint32_t>(bits);
+      float value;
+      std::memcpy(&value, &bits32, sizeof(value));
+      return value;
+    }
+    default: {
+      double value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+  }
+}
+
+void DecodeFloat16Array(const uint8_t* data, size_t count, ByteOrder order,
+                        double* output) {
+  const bool little_endian = order == ByteOrder::LittleEndian;
+  size_t i = 0;
+#ifdef BINARY_READER_X86
+  if (GetCpuFeatures().f16c)
+    i = DecodeFloat16ArrayF16c(data, count, little_endian, output);
+#endif
+  for (; i < count; i++)
+    output[i] = Float16ToDouble(Load16(data + i * 2, little_endian));
+}
+
+// The remaining loops are simple enough that the compiler vectorizes the byte
+// swaps and conversions itself.
+
+void DecodeFloat32Array(const uint8_t* data, size_t count, ByteOrder order,
+                        double* output) {
+  const bool little_endian = order == ByteOrder::LittleEndian;
+  for (size_t i = 0; i < count; i++) {
+    const uint32_t bits = Load32(data + i * 4, little_endian);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    output[i] = value;
+  }
+}
+
+void DecodeFloat64Array(const uint8_t* data, size_t count, ByteOrder order,
+                        double* output) {
+  const bool little_endian = order == ByteOrder::LittleEndian;
+  for (size_t i = 0; i < count; i++) {
+    const uint64_t bits = Load64(data + i * 8, little_endian);
+    std::memcpy(output + i, &bits, sizeof(bits));
+  }
+}
+
+}  // namespace binary_reader
@@ -0,0 +1,54 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BINARY_READER_UTIL_FLOAT_CONVERSION_H_
+#define BINARY_READER_UTIL_FLOAT_CONVERSION_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "binary_reader/options.h"
+
+namespace binary_reader {
+
+/// <summary>
+/// Converts the bits of an IEEE 754 half-precision number to a double.  This
+/// is exact since every half value can be represented as a double.
+/// </summary>
+double Float16ToDouble(uint16_t bits);
+
+/// <summary>
+/// Converts the raw bits of a 16, 32, or 64 bit float to a double.
+/// </summary>
+double FloatBitsToDouble(uint64_t bits, size_t bit_size);
+
+/// <summary>
+/// Decodes an array of packed floating-point numbers into doubles.  The input
+/// doesn't need to be aligned.  These use SIMD kernels when the CPU supports
+/// them; an Unset byte order is treated as big endian.
+/// </summary>
+/// <param name="data">The raw bytes to read.</param>
+/// <param name="count">The number of elements to decode.</param>
+/// <param name="order">The byte order of the elements.</param>
+/// <param name="output">Will be filled with |count| values.</param>
+void DecodeFloat16Array(const uint8_t* data, size_t count, ByteOrder order,
+                        double* output);
+void DecodeFloat32Array(const uint8_t* data, size_t count, ByteOrder order,
+                        double* output);
+void DecodeFloat64Array(const uint8_t* data, size_t count, ByteOrder order,
+                        double* output);
+
+}  // namespace binary_reader
+
+#endif  // BINARY_READER_UTIL_FLOAT_CONVERSION_H_
@@ -0,0 +1,76 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BINARY_READER_UTIL_GENERATION_H_
+#define BINARY_READER_UTIL_GENERATION_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "util/macros.h"
+
+namespace binary_reader {
+
+/// <summary>
+/// Counts how many times an object has been reparsed, so the child objects
+/// created by an earlier parse can tell they are stale.  Each child records
+/// its parent's Generation and count when it is created.
+///
+/// Reparsing only increments the counter, without visiting the children.
+/// Checking a child compares the counts up its chain of parents, which is
+/// short.  A Generation is shared by the object and its children, so it
+/// outlives the object if the app keeps a child.
+/// </summary>
+class Generation final {
+  NON_COPYABLE_OR_MOVABLE_TYPE(Generation);
+
+ public:
+  Generation(std::shared_ptr<const Generation> parent, uint64_t parent_count)
+      : parent_(std::move(parent)), parent_count_(parent_count) {}
+
+  uint64_t count() const {
+    return count_.load(std::memory_order_acquire);
+  }
+
+  /// <summary>
+  /// Marks the children created so far as stale.
+  /// </summary>
+  void Advance() {
+    count_.fetch_add(1, std::memory_order_acq_rel);
+  }
+
+  /// <summary>
+  /// Returns whether an object created when |parent| had the given count is
+  /// still valid, i.e. none of its parents were reparsed since then.
+  /// </summary>
+  static bool IsValid(const Generation* parent, uint64_t parent_count) {
+    while (parent) {
+      if (parent->count() != parent_count)
+        return false;
+      parent_count = parent->parent_count_;
+      parent = parent->parent_.get();
+    }
+    return true;
+  }
+
+ private:
+  std::atomic<uint64_t> count_{0};
+  const std::shared_ptr<const Generation> parent_;
+  const uint64_t parent_count_;
+};
+
+}  // namespace binary_reader
+
+#endif  // BINARY_READER_UTIL_GENERATION_H_
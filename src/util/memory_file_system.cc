@@ -54,6 +54,19 @@ bool MemoryFileReader::Seek(uint64_t* position, ErrorCollection*) {
   return true;
 }
 
+bool MemoryFileReader::can_read_at() const {
+  return true;
+}
+
+bool MemoryFileReader::ReadAt(uint64_t position, uint8_t* buffer,
+                              size_t* size, ErrorCollection*) {
+  position = std::min<uint64_t>(buffer_.size(), position);
+  *size = std::min<uint64_t>(*size, buffer_.size() - position);
+  if (*size > 0)
+    std::memcpy(buffer, &buffer_[position], *size);
+  return true;
+}
+
 std::shared_ptr<MemoryFileReader> MemoryFileReader::Clone() const {
   return std::make_shared<MemoryFileReader>(buffer_, pos_);
 }
@@ -35,6 +35,9 @@ class MemoryFileReader final : public FileReader {
 
   bool Read(uint8_t* buffer, size_t* size, ErrorCollection* errors) override;
   bool Seek(uint64_t* position, ErrorCollection* errors) override;
+  bool can_read_at() const override;
+  bool ReadAt(uint64_t position, uint8_t* buffer, size_t* size,
+              ErrorCollection* errors) override;
 
   std::shared_ptr<MemoryFileReader> Clone() const;
 
@@ -0,0 +1,62 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/per_thread.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace binary_reader {
+
+namespace {
+
+std::atomic<uint64_t> next_serial{1};
+
+/// <summary>
+/// Releases the current thread's instances when the thread exits.
+/// </summary>
+struct ThreadExitReleaser final {
+  ~ThreadExitReleaser() {
+    const std::thread::id id = std::this_thread::get_id();
+    for (auto& weak : owners) {
+      if (auto owner = weak.lock())
+        owner->Release(id);
+    }
+  }
+
+  std::vector<std::weak_ptr<internal::PerThreadInstances>> owners;
+};
+
+}  // namespace
+
+uint64_t NextPerThreadSerial() {
+  return next_serial.fetch_add(1, std::memory_order_relaxed);
+}
+
+namespace internal {
+
+void ReleaseOnThreadExit(std::weak_ptr<PerThreadInstances> instances) {
+  thread_local ThreadExitReleaser releaser;
+  // Forget objects that were already destroyed so long-lived threads don't
+  // keep growing this.
+  auto& owners = releaser.owners;
+  owners.erase(std::remove_if(owners.begin(), owners.end(),
+                              [](const auto& weak) { return weak.expired(); }),
+               owners.end());
+  owners.emplace_back(std::move(instances));
+}
+
+}  // namespace internal
+
+}  // namespace binary_reader
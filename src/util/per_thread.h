@@ -0,0 +1,191 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BINARY_READER_UTIL_PER_THREAD_H_
+#define BINARY_READER_UTIL_PER_THREAD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "util/macros.h"
+
+namespace binary_reader {
+
+/// <summary>
+/// Gets a number that is unique for the life of the process, used to tell
+/// PerThread objects apart in the per-thread caches.
+/// </summary>
+uint64_t NextPerThreadSerial();
+
+/// <summary>
+/// How long a PerThread keeps the instance for each thread.
+/// </summary>
+enum class PerThreadLifetime : uint8_t {
+  /// <summary>
+  /// Until the PerThread is destroyed.  Use this when the instances own data
+  /// that other threads can still use.
+  /// </summary>
+  Object,
+  /// <summary>
+  /// Until the thread exits (or the PerThread is destroyed), so threads that
+  /// come and go don't keep adding instances.
+  /// </summary>
+  Thread,
+};
+
+namespace internal {
+
+/// <summary>
+/// The instances of a PerThread, shared with the threads that use them so
+/// they can be released when the thread exits.
+/// </summary>
+class PerThreadInstances {
+ public:
+  virtual ~PerThreadInstances() = default;
+
+  /// <summary>
+  /// Destroys the instance for the given thread, if there is one.
+  /// </summary>
+  virtual void Release(std::thread::id id) = 0;
+};
+
+/// <summary>
+/// Calls |instances->Release| when the current thread exits, if it is still
+/// alive then.
+/// </summary>
+void ReleaseOnThreadExit(std::weak_ptr<PerThreadInstances> instances);
+
+}  // namespace internal
+
+/// <summary>
+/// Holds a separate instance of T for each thread that uses this object.  The
+/// instances are owned here and are destroyed along with this object, or when
+/// their thread exits if |lifetime| is PerThreadLifetime::Thread.
+///
+/// Each thread remembers the instances it used most recently, so getting the
+/// instance is lock-free after the first time.  A lock is only taken to
+/// create an instance or when the thread has used many other PerThread
+/// objects since.
+/// </summary>
+template <typename T>
+class PerThread final {
+  NON_COPYABLE_OR_MOVABLE_TYPE(PerThread);
+
+ public:
+  explicit PerThread(PerThreadLifetime lifetime = PerThreadLifetime::Object)
+      : serial_(NextPerThreadSerial()),
+        lifetime_(lifetime),
+        instances_(std::make_shared<Instances>()) {}
+
+  /// <summary>
+  /// Gets the current thread's instance, calling |create| to create it if
+  /// this is the first time.
+  /// </summary>
+  /// <param name="create">
+  /// Called as <code>std::unique_ptr&lt;T&gt; create()</code>.
+  /// </param>
+  template <typename Create>
+  T* Get(Create&& create) {
+    // Serials are never reused, so a stale entry can't match a new object.
+    thread_local CachedInstance cache[kThreadCacheSize];
+    thread_local size_t next_slot = 0;
+    for (auto& entry : cache) {
+      if (entry.serial == serial_)
+        return entry.instance;
+    }
+
+    T* ret = nullptr;
+    bool created = false;
+    {
+      std::lock_guard<std::mutex> lock(instances_->mutex);
+      const std::thread::id id = std::this_thread::get_id();
+      for (auto& pair : instances_->list) {
+        if (pair.first == id)
+          ret = pair.second.get();
+      }
+      if (!ret) {
+        instances_->list.emplace_back(id, create());
+        ret = instances_->list.back().second.get();
+        created = true;
+      }
+    }
+    if (created && lifetime_ == PerThreadLifetime::Thread)
+      internal::ReleaseOnThreadExit(instances_);
+
+    cache[next_slot] = {serial_, ret};
+    next_slot = (next_slot + 1) % kThreadCacheSize;
+    return ret;
+  }
+
+  /// <summary>
+  /// Calls |func| with each instance that has been created.  This must not
+  /// be called while other threads are using this object.
+  /// </summary>
+  template <typename Func>
+  void ForEach(Func&& func) const {
+    std::lock_guard<std::mutex> lock(instances_->mutex);
+    for (auto& pair : instances_->list) {
+      func(*pair.second);
+    }
+  }
+
+  /// <summary>
+  /// Gets the number of instances that exist.
+  /// </summary>
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(instances_->mutex);
+    return instances_->list.size();
+  }
+
+ private:
+  static constexpr const size_t kThreadCacheSize = 8;
+
+  struct CachedInstance {
+    uint64_t serial = 0;
+    T* instance = nullptr;
+  };
+
+  struct Instances final : internal::PerThreadInstances {
+    void Release(std::thread::id id) override {
+      // Declared first so it is destroyed after the lock is released.
+      std::unique_ptr<T> released;
+      std::lock_guard<std::mutex> lock(mutex);
+      for (auto it = list.begin(); it != list.end(); ++it) {
+        if (it->first == id) {
+          released = std::move(it->second);
+          list.erase(it);
+          break;
+        }
+      }
+    }
+
+    std::mutex mutex;
+    std::vector<std::pair<std::thread::id, std::unique_ptr<T>>> list;
+  };
+
+  const uint64_t serial_;
+  const PerThreadLifetime lifetime_;
+  // Shared with the threads that release their instance when they exit, so
+  // this can be destroyed first.
+  const std::shared_ptr<Instances> instances_;
+};
+
+}  // namespace binary_reader
+
+#endif  // BINARY_READER_UTIL_PER_THREAD_H_
@@ -0,0 +1,247 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BINARY_READER_UTIL_READ_CONTEXT_H_
+#define BINARY_READER_UTIL_READ_CONTEXT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <thread>
+
+#include "binary_reader/error_collection.h"
+#include "util/arena.h"
+#include "util/buffered_file_reader.h"
+#include "util/generation.h"
+#include "util/macros.h"
+#include "util/per_thread.h"
+#include "util/string_interner.h"
+#include "util/value_cache.h"
+
+namespace binary_reader {
+
+/// <summary>
+/// Counters for the work done while parsing a file.
+/// </summary>
+struct ReadStats final {
+  /// <summary>
+  /// The number of objects (of user-defined types) that were created.
+  /// </summary>
+  std::atomic<uint64_t> objects_created{0};
+  /// <summary>
+  /// The number of times objects had their fields laid out.
+  /// </summary>
+  std::atomic<uint64_t> objects_laid_out{0};
+  /// <summary>
+  /// The number of field values that were decoded from the file.
+  /// </summary>
+  std::atomic<uint64_t> fields_decoded{0};
+};
+
+/// <summary>
+/// Holds the state shared by every object created while parsing a single
+/// file.  Objects keep a reference to this so they can read their fields
+/// later.
+///
+/// Objects can be read from several threads at once.  The thread that
+/// created this uses the given reader; other threads each get their own
+/// reader that uses FileReader::ReadAt, so they don't share a file position.
+/// A thread's reader is freed when the thread exits.
+/// The Enable* methods must be called before any objects are created.
+/// </summary>
+class ParseState final : public std::enable_shared_from_this<ParseState> {
+  NON_COPYABLE_OR_MOVABLE_TYPE(ParseState);
+
+ public:
+  explicit ParseState(std::shared_ptr<BufferedFileReader> reader,
+                      std::pmr::memory_resource* memory =
+                          std::pmr::get_default_resource())
+      : reader_(std::move(reader)),
+        thread_readers_(PerThreadLifetime::Thread),
+        memory_(memory),
+        owner_thread_(std::this_thread::get_id()) {}
+
+  /// <summary>
+  /// Gets the reader for the current thread.
+  /// </summary>
+  BufferedFileReader* reader() const {
+    if (std::this_thread::get_id() == owner_thread_)
+      return reader_.get();
+    return thread_readers_.Get([this]() {
+      return BufferedFileReader::CreatePositional(reader_->file());
+    });
+  }
+
+  std::pmr::memory_resource* memory_resource() const {
+    return memory_;
+  }
+
+  ReadStats* stats() {
+    return &stats_;
+  }
+
+  /// <summary>
+  /// Gets the table used to share repeated strings, or nullptr if strings
+  /// aren't interned.
+  /// </summary>
+  StringInterner* interner() const {
+    return interner_.get();
+  }
+
+  void EnableStringInterning() {
+    if (!interner_)
+      interner_ = std::make_unique<StringInterner>();
+  }
+
+  /// <summary>
+  /// Gets the arena that objects and values are allocated from, or nullptr
+  /// if they use the normal heap.
+  /// </summary>
+  const std::shared_ptr<Arena>& arena() const {
+    return arena_;
+  }
+
+  /// <summary>
+  /// Allocates objects and values from an arena.  This must be called
+  /// before any objects are created.
+  /// </summary>
+  void EnableArena() {
+    if (!arena_)
+      arena_ = std::make_shared<Arena>();
+  }
+
+  /// <summary>
+  /// Gets the cache that limits the memory used by cached field values, or
+  /// nullptr if there's no limit.
+  /// </summary>
+  ValueCache* value_cache() const {
+    return value_cache_.get();
+  }
+
+  /// <summary>
+  /// Limits the memory used by cached field values to about |budget| bytes.
+  /// This must be called before any objects are created.
+  /// </summary>
+  void EnableValueCache(uint64_t budget) {
+    if (!value_cache_)
+      value_cache_ = std::make_unique<ValueCache>(budget);
+  }
+
+  /// <summary>
+  /// Gets whether objects read all their fields when they are parsed.
+  /// </summary>
+  bool eager_decode() const {
+    return eager_decode_;
+  }
+
+  void EnableEagerDecode() {
+    eager_decode_ = true;
+  }
+
+  /// <summary>
+  /// Creates the Generation for an object, allocated with the objects.
+  /// </summary>
+  std::shared_ptr<Generation> NewGeneration(
+      std::shared_ptr<const Generation> parent, uint64_t parent_count) const {
+    if (arena_) {
+      return std::allocate_shared<Generation>(
+          ArenaAllocator<Generation>{arena_}, std::move(parent),
+          parent_count);
+    }
+    return std::make_shared<Generation>(std::move(parent), parent_count);
+  }
+
+ private:
+  const std::shared_ptr<BufferedFileReader> reader_;
+  mutable PerThread<BufferedFileReader> thread_readers_;
+  std::pmr::memory_resource* const memory_;
+  const std::thread::id owner_thread_;
+  ReadStats stats_;
+  std::unique_ptr<StringInterner> interner_;
+  std::shared_ptr<Arena> arena_;
+  bool eager_decode_ = false;
+  std::unique_ptr<ValueCache> value_cache_;
+};
+
+/// <summary>
+/// The arguments for reading a value from a file.  This is a cheap,
+/// non-owning view that is passed down the read path so new state doesn't
+/// need to be added to every signature.
+/// </summary>
+class ReadContext final {
+ public:
+  ReadContext(ParseState* state, ErrorCollection* errors)
+      : ReadContext(state, errors, kNoParent) {}
+  /// <summary>
+  /// Creates a context for reading the fields of an object.  |parent| must
+  /// outlive this.
+  /// </summary>
+  ReadContext(ParseState* state, ErrorCollection* errors,
+              const std::shared_ptr<Generation>& parent)
+      : state_(state),
+        reader_(state->reader()),
+        errors_(errors),
+        parent_(parent) {}
+
+  ParseState* state() const {
+    return state_;
+  }
+
+  BufferedFileReader* reader() const {
+    return reader_;
+  }
+
+  ErrorCollection* errors() const {
+    return errors_;
+  }
+
+  std::pmr::memory_resource* memory_resource() const {
+    return state_->memory_resource();
+  }
+
+  ReadStats* stats() const {
+    return state_->stats();
+  }
+
+  StringInterner* interner() const {
+    return state_->interner();
+  }
+
+  const std::shared_ptr<Arena>& arena() const {
+    return state_->arena();
+  }
+
+  /// <summary>
+  /// Gets the Generation of the object being read, which is the parent of
+  /// any objects created, or nullptr if there isn't one.  This refers to the
+  /// object's own pointer; copying it touches a reference count shared by
+  /// every thread reading the object, so only copy it to create a child.
+  /// </summary>
+  const std::shared_ptr<Generation>& parent() const {
+    return parent_;
+  }
+
+ private:
+  static inline const std::shared_ptr<Generation> kNoParent;
+
+  ParseState* const state_;
+  BufferedFileReader* const reader_;
+  ErrorCollection* const errors_;
+  const std::shared_ptr<Generation>& parent_;
+};
+
+}  // namespace binary_reader
+
+#endif  // BINARY_READER_UTIL_READ_CONTEXT_H_
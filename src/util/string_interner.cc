@@ -0,0 +1,118 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/string_interner.h"
+
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+namespace binary_reader {
+
+namespace {
+
+constexpr const uint32_t kEmptySlot = UINT32_MAX;
+// The size each shard's table starts at.
+constexpr const size_t kInitialSlots = 16;
+
+}  // namespace
+
+StringInterner::StringInterner() {}
+
+StringInterner::~StringInterner() {}
+
+StringInternStats StringInterner::stats() const {
+  StringInternStats ret;
+  for (const ValueShard& shard : value_shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    ret.strings += shard.values.size();
+    ret.table_bytes += shard.values.bucket_count() * sizeof(void*);
+  }
+  for (const Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    ret.encodings += shard.entries.size();
+    ret.hits += shard.hits;
+    ret.bytes_shared += shard.bytes_shared;
+    ret.table_bytes += shard.slots.size() * sizeof(Slot) +
+                       shard.entries.capacity() * sizeof(Entry);
+  }
+  return ret;
+}
+
+size_t StringInterner::HashBytes(const Codec* codec, const uint8_t* bytes,
+                                 size_t size) {
+  const size_t hash = std::hash<std::string_view>()(
+      {reinterpret_cast<const char*>(bytes), size});
+  return hash ^ (std::hash<const Codec*>()(codec) * 0x9e3779b97f4a7c15ull);
+}
+
+Value StringInterner::Share(UtfString str) {
+  Value value{std::move(str)};
+  ValueShard& shard =
+      value_shards_[ShardIndex(std::hash<Value>()(value))];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  return *shard.values.insert(std::move(value)).first;
+}
+
+StringInterner::Shard::Shard() : slots(kInitialSlots, {0, kEmptySlot}) {}
+
+const Value* StringInterner::Shard::Find(size_t hash, const Codec* codec,
+                                         const uint8_t* bytes,
+                                         size_t size) const {
+  const size_t mask = slots.size() - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    const Slot& slot = slots[i];
+    if (slot.entry == kEmptySlot)
+      return nullptr;
+    if (slot.hash != hash)
+      continue;
+    const Entry& entry = entries[slot.entry];
+    if (entry.codec == codec && entry.bytes.size() == size &&
+        memcmp(entry.bytes.data(), bytes, size) == 0) {
+      return &entry.value;
+    }
+  }
+}
+
+void StringInterner::Shard::Insert(size_t hash, const Codec* codec,
+                                   const uint8_t* bytes, size_t size,
+                                   const Value& value) {
+  // Keep the table at most half full.
+  if ((entries.size() + 1) * 2 > slots.size())
+    Grow();
+
+  const size_t mask = slots.size() - 1;
+  size_t i = hash & mask;
+  while (slots[i].entry != kEmptySlot)
+    i = (i + 1) & mask;
+  slots[i] = {hash, static_cast<uint32_t>(entries.size())};
+  entries.push_back(
+      {codec, std::string(reinterpret_cast<const char*>(bytes), size), value});
+}
+
+void StringInterner::Shard::Grow() {
+  std::vector<Slot> new_slots(slots.size() * 2, {0, kEmptySlot});
+  const size_t mask = new_slots.size() - 1;
+  for (const Slot& slot : slots) {
+    if (slot.entry == kEmptySlot)
+      continue;
+    size_t i = slot.hash & mask;
+    while (new_slots[i].entry != kEmptySlot)
+      i = (i + 1) & mask;
+    new_slots[i] = slot;
+  }
+  slots = std::move(new_slots);
+}
+
+}  // namespace binary_reader
@@ -0,0 +1,160 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BINARY_READER_UTIL_STRING_INTERNER_H_
+#define BINARY_READER_UTIL_STRING_INTERNER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "binary_reader/codecs.h"
+#include "binary_reader/file_object.h"
+#include "binary_reader/value.h"
+#include "util/macros.h"
+
+namespace binary_reader {
+
+/// <summary>
+/// Shares one copy of each short string read from a file.  Strings are found
+/// by their encoded bytes, so a repeated string is neither decoded nor
+/// allocated again.  Equal strings always share the same value, even if they
+/// came from different bytes (e.g. in different encodings).
+///
+/// This is thread-safe.  The table is split into shards by the hash of the
+/// bytes, each with its own lock, so threads reading different strings don't
+/// contend.  The locks are only held to look up and add strings; decoding
+/// happens outside them.
+/// </summary>
+class StringInterner final {
+  NON_COPYABLE_OR_MOVABLE_TYPE(StringInterner);
+
+ public:
+  /// <summary>
+  /// Strings longer than this (in encoded bytes) aren't interned; long
+  /// strings are rarely repeated and would make the table large.
+  /// </summary>
+  static constexpr const size_t kMaxSize = 64;
+
+  StringInterner();
+  ~StringInterner();
+
+  StringInternStats stats() const;
+
+  /// <summary>
+  /// Gets the shared value for the string encoded as |bytes|.  If these bytes
+  /// haven't been seen before, this calls |decode| to decode them.
+  /// </summary>
+  /// <param name="codec">The codec the bytes are encoded with.</param>
+  /// <param name="decode">
+  /// Called as <code>bool decode(UtfString*)</code> to decode the bytes.
+  /// </param>
+  /// <param name="result">Will be filled in with the shared value.</param>
+  /// <returns>False if |decode| failed, true otherwise.</returns>
+  template <typename Decode>
+  bool Intern(const Codec* codec, const uint8_t* bytes, size_t size,
+              Decode&& decode, Value* result) {
+    const size_t hash = HashBytes(codec, bytes, size);
+    Shard* shard = &shards_[ShardIndex(hash)];
+    {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      if (const Value* found = shard->Find(hash, codec, bytes, size)) {
+        shard->hits++;
+        shard->bytes_shared += size;
+        *result = *found;
+        return true;
+      }
+    }
+
+    UtfString str;
+    if (!decode(&str))
+      return false;
+    Value value = Share(std::move(str));
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    // Another thread may have added the same bytes while this was decoding.
+    if (const Value* found = shard->Find(hash, codec, bytes, size)) {
+      *result = *found;
+      return true;
+    }
+    shard->Insert(hash, codec, bytes, size, value);
+    *result = std::move(value);
+    return true;
+  }
+
+ private:
+  static constexpr const size_t kShardBits = 4;
+  static constexpr const size_t kShardCount = size_t{1} << kShardBits;
+
+  struct Slot {
+    size_t hash;
+    // The index into |entries|, or UINT32_MAX if the slot is empty.
+    uint32_t entry;
+  };
+  struct Entry {
+    const Codec* codec;
+    std::string bytes;
+    Value value;
+  };
+
+  /// <summary>
+  /// Part of the table, holding the encoded strings whose hash maps to it.
+  /// </summary>
+  struct alignas(64) Shard final {
+    Shard();
+
+    const Value* Find(size_t hash, const Codec* codec, const uint8_t* bytes,
+                      size_t size) const;
+    void Insert(size_t hash, const Codec* codec, const uint8_t* bytes,
+                size_t size, const Value& value);
+    void Grow();
+
+    mutable std::mutex mutex;
+    // An open-addressed table found by the hash of the encoded bytes.  The
+    // size is always a power of two.
+    std::vector<Slot> slots;
+    std::vector<Entry> entries;
+    uint64_t hits = 0;
+    uint64_t bytes_shared = 0;
+  };
+  /// <summary>
+  /// Part of the distinct decoded strings, found by the hash of the string.
+  /// </summary>
+  struct alignas(64) ValueShard final {
+    mutable std::mutex mutex;
+    std::unordered_set<Value> values;
+  };
+
+  static size_t HashBytes(const Codec* codec, const uint8_t* bytes,
+                          size_t size);
+  static size_t ShardIndex(size_t hash) {
+    // The low bits pick the slot within the shard, so use the high ones.
+    return (static_cast<uint64_t>(hash) * 0x9e3779b97f4a7c15ull) >>
+           (64 - kShardBits);
+  }
+
+  /// <summary>
+  /// Gets the value shared by every string equal to |str|.
+  /// </summary>
+  Value Share(UtfString str);
+
+  Shard shards_[kShardCount];
+  ValueShard value_shards_[kShardCount];
+};
+
+}  // namespace binary_reader
+
+#endif  // BINARY_READER_UTIL_STRING_INTERNER_H_
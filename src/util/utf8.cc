@@ -0,0 +1,526 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/utf8.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "util/cpu_features.h"
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
+namespace binary_reader {
+
+namespace {
+
+// ASCII runs shorter than this are copied directly, since they are common
+// between multi-byte sequences and don't gain from SIMD.
+constexpr const size_t kShortRun = 8;
+
+#if defined(__SSE2__) || defined(_M_X64)
+unsigned CountTrailingZeros(uint32_t value) {
+#  if defined(_MSC_VER)
+  unsigned long ret;
+  _BitScanForward(&ret, value);
+  return static_cast<unsigned>(ret);
+#  else
+  return static_cast<unsigned>(__builtin_ctz(value));
+#  endif
+}
+
+unsigned CountTrailingZeros64(uint64_t value) {
+#  if defined(_MSC_VER)
+  unsigned long ret;
+  _BitScanForward64(&ret, value);
+  return static_cast<unsigned>(ret);
+#  else
+  return static_cast<unsigned>(__builtin_ctzll(value));
+#  endif
+}
+#endif
+
+#ifdef BINARY_READER_X86
+// The error bits for the AVX2 validator, from "Validating UTF-8 In Less
+// Than One Instruction Per Byte" (Keiser and Lemire).  Each pair of bytes is
+// classified by three table lookups (the high and low nibbles of the first
+// byte and the high nibble of the second); the pair is invalid if any error
+// bit is set in all three.
+constexpr const uint8_t kTooShort = 1 << 0;  // Lead not followed by a cont.
+constexpr const uint8_t kTooLong = 1 << 1;  // ASCII followed by a cont.
+constexpr const uint8_t kOverlong3 = 1 << 2;
+constexpr const uint8_t kTooLarge = 1 << 3;
+constexpr const uint8_t kSurrogate = 1 << 4;
+constexpr const uint8_t kOverlong2 = 1 << 5;
+constexpr const uint8_t kTooLarge1000 = 1 << 6;
+constexpr const uint8_t kOverlong4 = 1 << 6;
+constexpr const uint8_t kTwoConts = 1 << 7;  // Cont. followed by a cont.
+constexpr const uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+constexpr const uint8_t kLarge = kCarry | kTooLarge | kTooLarge1000;
+constexpr const uint8_t kCont = kTooLong | kOverlong2 | kTwoConts;
+
+// Indexed by the high nibble of the first byte.
+constexpr const uint8_t kByte1High[16] = {
+    kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+    kTooLong, kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+    kTooShort | kOverlong2, kTooShort, kTooShort | kOverlong3 | kSurrogate,
+    kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,
+};
+// Indexed by the low nibble of the first byte.
+constexpr const uint8_t kByte1Low[16] = {
+    kCarry | kOverlong3 | kOverlong2 | kOverlong4, kCarry | kOverlong2, kCarry,
+    kCarry, kCarry | kTooLarge, kLarge, kLarge, kLarge, kLarge, kLarge, kLarge,
+    kLarge, kLarge, kLarge | kSurrogate, kLarge, kLarge,
+};
+// Indexed by the high nibble of the second byte.
+constexpr const uint8_t kByte2High[16] = {
+    kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+    kTooShort, kTooShort, kCont | kOverlong3 | kTooLarge1000 | kOverlong4,
+    kCont | kOverlong3 | kTooLarge, kCont | kSurrogate | kTooLarge,
+    kCont | kSurrogate | kTooLarge, kTooShort, kTooShort, kTooShort,
+    kTooShort,
+};
+// The largest value allowed in each position of the last block; a lead byte
+// in the last three bytes must have room for its continuations.
+constexpr const uint8_t kMaxValue[32] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,     0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,     0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,     0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xf0 - 1, 0xe0 - 1, 0xc0 - 1,
+};
+
+// Loads a 16-entry table into both lanes.
+TARGET_ATTRIBUTE("avx2")
+inline __m256i LoadTable(const uint8_t* table) {
+  return _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(table)));
+}
+
+TARGET_ATTRIBUTE("avx2")
+inline __m256i Lookup16(__m256i table, __m256i index) {
+  return _mm256_shuffle_epi8(table, index);
+}
+
+TARGET_ATTRIBUTE("avx2")
+inline __m256i HighNibbles(__m256i input) {
+  return _mm256_and_si256(_mm256_srli_epi16(input, 4), _mm256_set1_epi8(0xf));
+}
+
+// Returns |input| shifted by |N| bytes, with the end of |prev| shifted in.
+template <int N>
+TARGET_ATTRIBUTE("avx2")
+inline __m256i Prev(__m256i input, __m256i prev) {
+  return _mm256_alignr_epi8(
+      input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - N);
+}
+
+struct Utf8CheckerAvx2 {
+  __m256i error;
+  __m256i prev_input;
+  __m256i prev_incomplete;
+
+  TARGET_ATTRIBUTE("avx2")
+  void CheckBlock(__m256i input) {
+    if (_mm256_movemask_epi8(input) == 0) {
+      // An ASCII block is valid unless the previous block ended early.
+      error = _mm256_or_si256(error, prev_incomplete);
+      return;
+    }
+
+    const __m256i byte1_high_table = LoadTable(kByte1High);
+    const __m256i byte1_low_table = LoadTable(kByte1Low);
+    const __m256i byte2_high_table = LoadTable(kByte2High);
+
+    const __m256i prev1 = Prev<1>(input, prev_input);
+    const __m256i special = _mm256_and_si256(
+        _mm256_and_si256(Lookup16(byte1_high_table, HighNibbles(prev1)),
+                         Lookup16(byte1_low_table,
+                                  _mm256_and_si256(prev1,
+                                                   _mm256_set1_epi8(0xf)))),
+        Lookup16(byte2_high_table, HighNibbles(input)));
+
+    // The third and fourth bytes of a sequence are continuations that follow
+    // a continuation, so they are only valid if the lead requires them.
+    const __m256i prev2 = Prev<2>(input, prev_input);
+    const __m256i prev3 = Prev<3>(input, prev_input);
+    const __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8(0x60));
+    const __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8(0x70));
+    const __m256i must_be_cont = _mm256_and_si256(
+        _mm256_or_si256(third, fourth), _mm256_set1_epi8(-0x80));
+    error = _mm256_or_si256(error, _mm256_xor_si256(must_be_cont, special));
+
+    // The block is incomplete if one of the last three bytes starts a
+    // sequence that doesn't fit.
+    const __m256i max_value =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(kMaxValue));
+    prev_incomplete = _mm256_subs_epu8(input, max_value);
+    prev_input = input;
+  }
+};
+
+TARGET_ATTRIBUTE("avx2")
+bool IsValidUtf8Avx2(const uint8_t* buffer, size_t size) {
+  Utf8CheckerAvx2 checker;
+  checker.error = _mm256_setzero_si256();
+  checker.prev_input = _mm256_setzero_si256();
+  checker.prev_incomplete = _mm256_setzero_si256();
+
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    checker.CheckBlock(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer + i)));
+  }
+  if (i < size) {
+    // Pad the end with ASCII; this catches a truncated final sequence.
+    uint8_t tail[32] = {};
+    std::memcpy(tail, buffer + i, size - i);
+    checker.CheckBlock(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tail)));
+  }
+  const __m256i error =
+      _mm256_or_si256(checker.error, checker.prev_incomplete);
+  return _mm256_testz_si256(error, error) != 0;
+}
+
+// The ASCII kernels below convert whole blocks, even if they contain
+// non-ASCII, then return the length of the ASCII prefix.  The output has room
+// for the block, and the caller overwrites the rest.  This keeps short ASCII
+// runs between multi-byte sequences to a single iteration.
+
+TARGET_ATTRIBUTE("avx2")
+size_t WidenAsciiAvx2(const uint8_t* buffer, size_t size, char16_t* output) {
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    const __m256i input =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer + i));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(output + i),
+        _mm256_cvtepu8_epi16(_mm256_castsi256_si128(input)));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(output + i + 16),
+        _mm256_cvtepu8_epi16(_mm256_extracti128_si256(input, 1)));
+    const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(input));
+    if (mask != 0)
+      return i + CountTrailingZeros(mask);
+  }
+  return i;
+}
+
+TARGET_ATTRIBUTE("avx2")
+size_t NarrowAsciiAvx2(const char16_t* buffer, size_t size, uint8_t* output) {
+  const __m256i high_bits = _mm256_set1_epi16(static_cast<int16_t>(0xff80));
+  const __m256i zero = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    const __m256i a =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer + i));
+    const __m256i b =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer + i + 16));
+    // The pack works within each 128-bit lane, so put the lanes back in
+    // order afterwards.
+    const __m256i packed =
+        _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), packed);
+
+    const __m256i high = _mm256_and_si256(_mm256_or_si256(a, b), high_bits);
+    if (!_mm256_testz_si256(high, high)) {
+      // Each code unit gives two mask bits.
+      const uint64_t ascii_a = static_cast<uint32_t>(_mm256_movemask_epi8(
+          _mm256_cmpeq_epi16(_mm256_and_si256(a, high_bits), zero)));
+      const uint64_t ascii_b = static_cast<uint32_t>(_mm256_movemask_epi8(
+          _mm256_cmpeq_epi16(_mm256_and_si256(b, high_bits), zero)));
+      return i + CountTrailingZeros64(~(ascii_a | (ascii_b << 32))) / 2;
+    }
+  }
+  return i;
+}
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+size_t WidenAsciiSse2(const uint8_t* buffer, size_t size, char16_t* output) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m128i input =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i),
+                     _mm_unpacklo_epi8(input, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i + 8),
+                     _mm_unpackhi_epi8(input, zero));
+    const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(input));
+    if (mask != 0)
+      return i + CountTrailingZeros(mask);
+  }
+  return i;
+}
+
+size_t NarrowAsciiSse2(const char16_t* buffer, size_t size, uint8_t* output) {
+  const __m128i high_bits = _mm_set1_epi16(static_cast<int16_t>(0xff80));
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m128i a =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i));
+    const __m128i b =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i + 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i),
+                     _mm_packus_epi16(a, b));
+    // Each code unit gives two mask bits.
+    const uint32_t ascii_a = static_cast<uint32_t>(_mm_movemask_epi8(
+        _mm_cmpeq_epi16(_mm_and_si128(a, high_bits), zero)));
+    const uint32_t ascii_b = static_cast<uint32_t>(_mm_movemask_epi8(
+        _mm_cmpeq_epi16(_mm_and_si128(b, high_bits), zero)));
+    const uint32_t ascii = ascii_a | (ascii_b << 16);
+    if (ascii != 0xffffffff)
+      return i + CountTrailingZeros(~ascii) / 2;
+  }
+  return i;
+}
+
+size_t CountAsciiSse2(const uint8_t* buffer, size_t size) {
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const __m128i input =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i));
+    if (_mm_movemask_epi8(input) != 0)
+      break;
+  }
+  return i;
+}
+#endif
+
+// Returns the number of leading ASCII bytes.
+size_t CountAscii(const uint8_t* buffer, size_t size) {
+  size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+  i = CountAsciiSse2(buffer, size);
+#endif
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, buffer + i, sizeof(word));
+    if (word & 0x8080808080808080ull)
+      break;
+  }
+  while (i < size && buffer[i] < 0x80)
+    i++;
+  return i;
+}
+
+bool IsValidUtf8Scalar(const uint8_t* buffer, size_t size) {
+  size_t i = 0;
+  while (i < size) {
+    i += CountAscii(buffer + i, size - i);
+    if (i == size)
+      break;
+
+    const uint8_t head = buffer[i];
+    size_t num_bytes;
+    // The valid range of the second byte depends on the first byte; this
+    // excludes overlong forms, surrogates, and values past U+10FFFF.
+    uint8_t min = 0x80;
+    uint8_t max = 0xbf;
+    if (head >= 0xc2 && head <= 0xdf) {
+      num_bytes = 2;
+    } else if (head >= 0xe0 && head <= 0xef) {
+      num_bytes = 3;
+      if (head == 0xe0)
+        min = 0xa0;
+      else if (head == 0xed)
+        max = 0x9f;
+    } else if (head >= 0xf0 && head <= 0xf4) {
+      num_bytes = 4;
+      if (head == 0xf0)
+        min = 0x90;
+      else if (head == 0xf4)
+        max = 0x8f;
+    } else {
+      return false;
+    }
+
+    if (num_bytes > size - i)
+      return false;
+    if (buffer[i + 1] < min || buffer[i + 1] > max)
+      return false;
+    for (size_t j = 2; j < num_bytes; j++) {
+      if ((buffer[i + j] & 0xc0) != 0x80)
+        return false;
+    }
+    i += num_bytes;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool IsValidUtf8(const uint8_t* buffer, size_t size) {
+#ifdef BINARY_READER_X86
+  if (size >= 32 && GetCpuFeatures().avx2)
+    return IsValidUtf8Avx2(buffer, size);
+#endif
+  return IsValidUtf8Scalar(buffer, size);
+}
+
+size_t WidenAscii(const uint8_t* buffer, size_t size, char16_t* output) {
+  size_t i = 0;
+#ifdef BINARY_READER_X86
+  if (size >= 32 && GetCpuFeatures().avx2) {
+    i = WidenAsciiAvx2(buffer, size, output);
+    if (i == size || buffer[i] >= 0x80)
+      return i;
+  }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+  i += WidenAsciiSse2(buffer + i, size - i, output + i);
+  if (i == size || buffer[i] >= 0x80)
+    return i;
+#endif
+  for (; i < size && buffer[i] < 0x80; i++)
+    output[i] = buffer[i];
+  return i;
+}
+
+size_t NarrowAscii(const char16_t* buffer, size_t size, uint8_t* output) {
+  size_t i = 0;
+#ifdef BINARY_READER_X86
+  if (size >= 32 && GetCpuFeatures().avx2) {
+    i = NarrowAsciiAvx2(buffer, size, output);
+    if (i == size || buffer[i] >= 0x80)
+      return i;
+  }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+  i += NarrowAsciiSse2(buffer + i, size - i, output + i);
+  if (i == size || buffer[i] >= 0x80)
+    return i;
+#endif
+  for (; i < size && buffer[i] < 0x80; i++)
+    output[i] = static_cast<uint8_t>(buffer[i]);
+  return i;
+}
+
+size_t ConvertUtf8ToUtf16(const uint8_t* buffer, size_t size,
+                          char16_t* output) {
+  char16_t* out = output;
+  size_t i = 0;
+  while (i < size) {
+    if (buffer[i] < 0x80) {
+      // Only use the SIMD kernel for longer runs.
+      const size_t end = std::min(size, i + kShortRun);
+      while (i < end && buffer[i] < 0x80)
+        *out++ = buffer[i++];
+      if (i == end && i < size) {
+        const size_t ascii = WidenAscii(buffer + i, size - i, out);
+        out += ascii;
+        i += ascii;
+      }
+      if (i == size)
+        break;
+    }
+
+    const uint8_t head = buffer[i];
+    uint32_t code_point;
+    if (head < 0xe0) {
+      code_point = ((head & 0x1f) << 6) | (buffer[i + 1] & 0x3f);
+      i += 2;
+    } else if (head < 0xf0) {
+      code_point = ((head & 0x0f) << 12) | ((buffer[i + 1] & 0x3f) << 6) |
+                   (buffer[i + 2] & 0x3f);
+      i += 3;
+    } else {
+      code_point = ((head & 0x07) << 18) | ((buffer[i + 1] & 0x3f) << 12) |
+                   ((buffer[i + 2] & 0x3f) << 6) | (buffer[i + 3] & 0x3f);
+      i += 4;
+    }
+
+    if (code_point < 0x10000) {
+      *out++ = static_cast<char16_t>(code_point);
+    } else {
+      code_point -= 0x10000;
+      *out++ = static_cast<char16_t>(0xd800 | (code_point >> 10));
+      *out++ = static_cast<char16_t>(0xdc00 | (code_point & 0x3ff));
+    }
+  }
+  return out - output;
+}
+
+size_t ConvertUtf16ToUtf8(const char16_t* buffer, size_t size,
+                          uint8_t* output) {
+  uint8_t* out = output;
+  size_t i = 0;
+  while (i < size) {
+    if (buffer[i] < 0x80) {
+      // Only use the SIMD kernel for longer runs.
+      const size_t end = std::min(size, i + kShortRun);
+      while (i < end && buffer[i] < 0x80)
+        *out++ = static_cast<uint8_t>(buffer[i++]);
+      if (i == end && i < size) {
+        const size_t ascii = NarrowAscii(buffer + i, size - i, out);
+        out += ascii;
+        i += ascii;
+      }
+      if (i == size)
+        break;
+    }
+
+    // Encode unpaired surrogates directly.
+    uint32_t code_point = buffer[i];
+    if (i + 1 < size && code_point >= 0xd800 && code_point <= 0xdbff &&
+        buffer[i + 1] >= 0xdc00 && buffer[i + 1] <= 0xdfff) {
+      code_point =
+          (((code_point & 0x3ff) << 10) | (buffer[i + 1] & 0x3ff)) + 0x10000;
+      i++;
+    }
+    i++;
+
+    if (code_point < 0x800) {
+      *out++ = static_cast<uint8_t>(0xc0 | (code_point >> 6));
+      *out++ = static_cast<uint8_t>(0x80 | (code_point & 0x3f));
+    } else if (code_point < 0x10000) {
+      *out++ = static_cast<uint8_t>(0xe0 | (code_point >> 12));
+      *out++ = static_cast<uint8_t>(0x80 | ((code_point >> 6) & 0x3f));
+      *out++ = static_cast<uint8_t>(0x80 | (code_point & 0x3f));
+    } else {
+      *out++ = static_cast<uint8_t>(0xf0 | (code_point >> 18));
+      *out++ = static_cast<uint8_t>(0x80 | ((code_point >> 12) & 0x3f));
+      *out++ = static_cast<uint8_t>(0x80 | ((code_point >> 6) & 0x3f));
+      *out++ = static_cast<uint8_t>(0x80 | (code_point & 0x3f));
+    }
+  }
+  return out - output;
+}
+
+void AppendUtf8AsUtf16(const uint8_t* buffer, size_t size,
+                       std::u16string* output) {
+  // UTF-16 never needs more code units than UTF-8 has bytes.
+  const size_t start = output->size();
+  output->resize(start + size);
+  const size_t used =
+      ConvertUtf8ToUtf16(buffer, size, output->data() + start);
+  output->resize(start + used);
+}
+
+void AppendUtf16AsUtf8(const char16_t* buffer, size_t size,
+                       std::string* output) {
+  // Each UTF-16 code unit is at most 3 UTF-8 bytes; a surrogate pair is two
+  // code units and 4 bytes.
+  const size_t start = output->size();
+  output->resize(start + size * 3);
+  const size_t used = ConvertUtf16ToUtf8(
+      buffer, size, reinterpret_cast<uint8_t*>(output->data() + start));
+  output->resize(start + used);
+}
+
+}  // namespace binary_reader
@@ -0,0 +1,82 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BINARY_READER_UTIL_UTF8_H_
+#define BINARY_READER_UTIL_UTF8_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace binary_reader {
+
+/// <summary>
+/// Returns whether the given bytes are well-formed UTF-8.  This rejects
+/// overlong sequences, encoded surrogates, and code points above U+10FFFF,
+/// so valid strings sort the same as their code points.  This checks 32 bytes
+/// at a time when AVX2 is available.
+/// </summary>
+bool IsValidUtf8(const uint8_t* buffer, size_t size);
+
+/// <summary>
+/// Copies the leading ASCII bytes of |buffer| to |output| as UTF-16.  This
+/// stops at the first non-ASCII byte.
+/// </summary>
+/// <param name="output">Must have room for |size| code units.</param>
+/// <returns>The number of bytes converted.</returns>
+size_t WidenAscii(const uint8_t* buffer, size_t size, char16_t* output);
+
+/// <summary>
+/// Copies the leading ASCII code units of |buffer| to |output| as bytes.
+/// This stops at the first non-ASCII code unit.
+/// </summary>
+/// <param name="output">Must have room for |size| bytes.</param>
+/// <returns>The number of code units converted.</returns>
+size_t NarrowAscii(const char16_t* buffer, size_t size, uint8_t* output);
+
+/// <summary>
+/// Converts well-formed UTF-8 to UTF-16.  The input must have been checked
+/// with IsValidUtf8.
+/// </summary>
+/// <param name="output">Must have room for |size| code units.</param>
+/// <returns>The number of code units written.</returns>
+size_t ConvertUtf8ToUtf16(const uint8_t* buffer, size_t size,
+                          char16_t* output);
+
+/// <summary>
+/// Converts UTF-16 to UTF-8.  Unpaired surrogates are encoded directly as
+/// three-byte sequences.
+/// </summary>
+/// <param name="output">Must have room for 3 * |size| bytes.</param>
+/// <returns>The number of bytes written.</returns>
+size_t ConvertUtf16ToUtf8(const char16_t* buffer, size_t size,
+                          uint8_t* output);
+
+/// <summary>
+/// Converts well-formed UTF-8 to UTF-16 and appends it to |output|.  The input
+/// must have been checked with IsValidUtf8.
+/// </summary>
+void AppendUtf8AsUtf16(const uint8_t* buffer, size_t size,
+                       std::u16string* output);
+
+/// <summary>
+/// Converts UTF-16 to UTF-8 and appends it to |output|.  Unpaired surrogates
+/// are encoded directly as three-byte sequences.
+/// </summary>
+void AppendUtf16AsUtf8(const char16_t* buffer, size_t size,
+                       std::string* output);
+
+}  // namespace binary_reader
+
+#endif  // BINARY_READER_UTIL_UTF8_H_
@@ -0,0 +1,126 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/value_cache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <vector>
+
+namespace binary_reader {
+
+ValueCache::~ValueCache() {
+  // Every object holds a reference to the parse state that owns the cache,
+  // so they have all removed their entries by now.
+  assert(std::all_of(std::begin(shards_), std::end(shards_),
+                     [](const Shard& shard) { return !shard.head; }));
+  assert(size_ == 0);
+}
+
+void ValueCache::Add(Entry* entry, Owner* owner, size_t index, size_t size) {
+  Shard* shard = GetShard(owner);
+  std::lock_guard<std::mutex> lock(shard->mutex);
+  RemoveLocked(shard, entry);
+  entry->owner = owner;
+  entry->index = index;
+  entry->size = size;
+  entry->referenced.store(false, std::memory_order_relaxed);
+  size_.fetch_add(size, std::memory_order_relaxed);
+  LinkFirst(shard, entry);
+}
+
+void ValueCache::Remove(Entry* entry, Owner* owner) {
+  Shard* shard = GetShard(owner);
+  std::lock_guard<std::mutex> lock(shard->mutex);
+  RemoveLocked(shard, entry);
+}
+
+void ValueCache::Trim() {
+  if (size_.load(std::memory_order_relaxed) <= budget_)
+    return;
+
+  // Releasing a child object removes the entries for its own fields, which
+  // needs their shard's lock, so the values are released after unlocking.
+  std::vector<Value> evicted;
+  const size_t first = next_trim_.fetch_add(1, std::memory_order_relaxed);
+  bool any = true;
+  while (any && size_.load(std::memory_order_relaxed) > budget_) {
+    // Take one value from each shard in turn so they are trimmed evenly.
+    any = false;
+    for (size_t i = 0; i < kShardCount; i++) {
+      if (size_.load(std::memory_order_relaxed) <= budget_)
+        break;
+      Shard* shard = &shards_[(first + i) % kShardCount];
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      if (EvictOne(shard, &evicted))
+        any = true;
+    }
+  }
+}
+
+ValueCache::Shard* ValueCache::GetShard(const Owner* owner) {
+  // Mix the address so owners allocated next to each other are spread out.
+  const uint64_t bits = reinterpret_cast<uintptr_t>(owner);
+  return &shards_[(bits * 0x9e3779b97f4a7c15ull) >> (64 - kShardBits)];
+}
+
+bool ValueCache::EvictOne(Shard* shard, std::vector<Value>* evicted) {
+  while (Entry* entry = shard->tail) {
+    if (entry->referenced.exchange(false, std::memory_order_relaxed)) {
+      Unlink(shard, entry);
+      LinkFirst(shard, entry);
+      continue;
+    }
+
+    Owner* owner = entry->owner;
+    RemoveLocked(shard, entry);
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+    evicted->emplace_back(owner->EvictCachedValue(entry->index));
+    return true;
+  }
+  return false;
+}
+
+void ValueCache::RemoveLocked(Shard* shard, Entry* entry) {
+  if (!entry->linked())
+    return;
+  Unlink(shard, entry);
+  size_.fetch_sub(entry->size, std::memory_order_relaxed);
+  entry->owner = nullptr;
+}
+
+void ValueCache::LinkFirst(Shard* shard, Entry* entry) {
+  entry->prev = nullptr;
+  entry->next = shard->head;
+  if (shard->head)
+    shard->head->prev = entry;
+  else
+    shard->tail = entry;
+  shard->head = entry;
+}
+
+void ValueCache::Unlink(Shard* shard, Entry* entry) {
+  if (entry->prev)
+    entry->prev->next = entry->next;
+  else
+    shard->head = entry->next;
+  if (entry->next)
+    entry->next->prev = entry->prev;
+  else
+    shard->tail = entry->prev;
+  entry->prev = entry->next = nullptr;
+}
+
+}  // namespace binary_reader
@@ -0,0 +1,163 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BINARY_READER_UTIL_VALUE_CACHE_H_
+#define BINARY_READER_UTIL_VALUE_CACHE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "binary_reader/value.h"
+#include "util/macros.h"
+
+namespace binary_reader {
+
+/// <summary>
+/// Tracks the field values cached by every object parsed from a file and
+/// keeps their total size within a budget.  When the budget is exceeded, the
+/// least-recently-used values are evicted; the objects decode them again the
+/// next time they're needed.
+///
+/// The entries are stored by the objects that own the values and are linked
+/// into a list here, so tracking a value doesn't allocate.  Values are only
+/// evicted by Trim, so callers can add values and use them before letting
+/// the cache shrink.
+///
+/// This is thread-safe.  Using a value only sets a flag on its entry, so
+/// reads don't take a lock; the list is reordered when trimming instead,
+/// giving recently used values a second chance (the "clock" algorithm).  The
+/// entries are split into shards by owner, each with its own list and lock,
+/// so threads reading different objects don't contend.  Values are evicted
+/// from each shard in turn, so the order is only least-recently-used within
+/// a shard.
+/// </summary>
+class ValueCache final {
+  NON_COPYABLE_OR_MOVABLE_TYPE(ValueCache);
+
+ public:
+  /// <summary>
+  /// An object that holds cached values.
+  /// </summary>
+  class Owner {
+   public:
+    /// <summary>
+    /// Takes out the value with the given index.  This is called with the
+    /// owner's shard locked, after the entry for it is removed; the value is
+    /// released once the cache is unlocked.
+    /// </summary>
+    virtual Value EvictCachedValue(size_t index) = 0;
+
+   protected:
+    ~Owner() = default;
+  };
+
+  /// <summary>
+  /// The cache's record of one value.  This is owned by the Owner and must
+  /// be removed from the cache before it is destroyed or moved.  Only
+  /// |referenced| may be used without the lock for the owner's shard.
+  /// </summary>
+  struct Entry final {
+    Entry* prev = nullptr;
+    Entry* next = nullptr;
+    Owner* owner = nullptr;
+    size_t index = 0;
+    size_t size = 0;
+    std::atomic<bool> referenced{false};
+
+    bool linked() const {
+      return owner != nullptr;
+    }
+  };
+
+  explicit ValueCache(uint64_t budget) : budget_(budget) {}
+  ~ValueCache();
+
+  uint64_t budget() const {
+    return budget_;
+  }
+  /// <summary>
+  /// Gets the total size of the values currently cached.
+  /// </summary>
+  uint64_t size() const {
+    return size_.load(std::memory_order_relaxed);
+  }
+  /// <summary>
+  /// Gets the number of values that have been evicted.
+  /// </summary>
+  uint64_t evictions() const {
+    return evictions_.load(std::memory_order_relaxed);
+  }
+
+  /// <summary>
+  /// Starts tracking a value of the given size, as the most-recently-used
+  /// one.  If the entry is already tracked, this updates its size.
+  /// </summary>
+  void Add(Entry* entry, Owner* owner, size_t index, size_t size);
+
+  /// <summary>
+  /// Marks the value as recently used, so it isn't evicted by the next Trim.
+  /// </summary>
+  void Touch(Entry* entry) {
+    // Avoid writing to the shared cache line if it's already set.
+    if (!entry->referenced.load(std::memory_order_relaxed))
+      entry->referenced.store(true, std::memory_order_relaxed);
+  }
+
+  /// <summary>
+  /// Stops tracking a value of |owner|.  This does nothing if the entry isn't
+  /// tracked.
+  /// </summary>
+  void Remove(Entry* entry, Owner* owner);
+
+  /// <summary>
+  /// Evicts the least-recently-used values until the cache is within its
+  /// budget.
+  /// </summary>
+  void Trim();
+
+ private:
+  static constexpr const size_t kShardBits = 4;
+  static constexpr const size_t kShardCount = size_t{1} << kShardBits;
+
+  struct alignas(64) Shard final {
+    std::mutex mutex;
+    Entry* head = nullptr;
+    Entry* tail = nullptr;
+  };
+
+  Shard* GetShard(const Owner* owner);
+  /// <summary>
+  /// Evicts the least-recently-used value in the shard, which must be
+  /// locked.
+  /// </summary>
+  /// <returns>False if the shard is empty.</returns>
+  bool EvictOne(Shard* shard, std::vector<Value>* evicted);
+  void RemoveLocked(Shard* shard, Entry* entry);
+  static void LinkFirst(Shard* shard, Entry* entry);
+  static void Unlink(Shard* shard, Entry* entry);
+
+  const uint64_t budget_;
+  std::atomic<uint64_t> size_{0};
+  std::atomic<uint64_t> evictions_{0};
+  // The shard Trim starts with, so the same one isn't always evicted first.
+  std::atomic<size_t> next_trim_{0};
+  Shard shards_[kShardCount];
+};
+
+}  // namespace binary_reader
+
+#endif  // BINARY_READER_UTIL_VALUE_CACHE_H_
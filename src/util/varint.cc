@@ -0,0 +1,157 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/varint.h"
+
+#include "util/cpu_features.h"
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
+namespace binary_reader {
+
+namespace {
+
+/// <summary>
+/// Combines the 7-bit groups of a LEB128 value whose last byte is at
+/// |length - 1|.  The bits past 64 must all be zero or, for signed values,
+/// copies of bit 63.
+/// </summary>
+/// <returns>False if the value doesn't fit in 64 bits.</returns>
+bool AssembleLeb128(const uint8_t* buffer, size_t length, bool is_signed,
+                    uint64_t* value) {
+  if (length > kMaxVarintSize)
+    return false;
+  if (length == kMaxVarintSize) {
+    // The low bit of the last byte is bit 63; the rest are past the end.
+    const uint8_t last = buffer[kMaxVarintSize - 1] & 0x7f;
+    if (is_signed ? last != 0 && last != 0x7f : last > 1)
+      return false;
+  }
+
+  uint64_t ret = 0;
+  for (size_t i = 0; i < length; i++)
+    ret |= static_cast<uint64_t>(buffer[i] & 0x7f) << (7 * i);
+  *value = ret;
+  return true;
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+unsigned CountTrailingZeros(uint32_t value) {
+#  if defined(_MSC_VER)
+  unsigned long ret;
+  _BitScanForward(&ret, value);
+  return static_cast<unsigned>(ret);
+#  else
+  return static_cast<unsigned>(__builtin_ctz(value));
+#  endif
+}
+
+/// <summary>
+/// Decodes values 16 bytes at a time, using the high bit of each byte to find
+/// where the values end.  This stops when there are fewer than 16 bytes left
+/// or a value doesn't end within a window.
+/// </summary>
+size_t DecodeLeb128ArraySse2(const uint8_t* buffer, size_t size, size_t count,
+                             uint64_t* values, uint8_t* lengths,
+                             size_t* consumed) {
+  size_t pos = 0;
+  size_t i = 0;
+  while (i < count && pos + 16 <= size) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + pos));
+    const uint32_t continues =
+        static_cast<uint32_t>(_mm_movemask_epi8(chunk));
+    if (continues == 0 && i + 16 <= count) {
+      // Sixteen single byte values; this is common for small numbers.
+      for (size_t j = 0; j < 16; j++) {
+        values[i + j] = buffer[pos + j];
+        lengths[i + j] = 1;
+      }
+      i += 16;
+      pos += 16;
+      continue;
+    }
+
+    uint32_t ends = ~continues & 0xffff;
+    size_t start = 0;
+    while (ends != 0 && i < count) {
+      const size_t end = CountTrailingZeros(ends);
+      const size_t length = end - start + 1;
+      if (!AssembleLeb128(buffer + pos + start, length, false, &values[i]))
+        break;
+      lengths[i] = static_cast<uint8_t>(length);
+      i++;
+      start = end + 1;
+      ends &= ends - 1;
+    }
+    if (start == 0)
+      break;
+    pos += start;
+  }
+  *consumed = pos;
+  return i;
+}
+#endif
+
+}  // namespace
+
+size_t DecodeLeb128(const uint8_t* buffer, size_t size, bool is_signed,
+                    uint64_t* value) {
+  const size_t max = size < kMaxVarintSize ? size : kMaxVarintSize;
+  for (size_t i = 0; i < max; i++) {
+    if ((buffer[i] & 0x80) == 0)
+      return AssembleLeb128(buffer, i + 1, is_signed, value) ? i + 1 : 0;
+  }
+  return 0;
+}
+
+size_t DecodePrefixVarint(const uint8_t* buffer, size_t size,
+                          uint64_t* value) {
+  if (size == 0)
+    return 0;
+
+  size_t extra = 0;
+  while (extra < 8 && (buffer[0] & (0x80 >> extra)))
+    extra++;
+  if (size < extra + 1)
+    return 0;
+
+  uint64_t ret = extra == 8 ? 0 : buffer[0] & (0x7f >> extra);
+  for (size_t i = 1; i <= extra; i++)
+    ret = (ret << 8) | buffer[i];
+  *value = ret;
+  return extra + 1;
+}
+
+size_t DecodeLeb128Array(const uint8_t* buffer, size_t size, size_t count,
+                         uint64_t* values, uint8_t* lengths) {
+  size_t i = 0;
+  size_t pos = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+  i = DecodeLeb128ArraySse2(buffer, size, count, values, lengths, &pos);
+#endif
+  for (; i < count; i++) {
+    const size_t length =
+        DecodeLeb128(buffer + pos, size - pos, false, &values[i]);
+    if (length == 0)
+      break;
+    lengths[i] = static_cast<uint8_t>(length);
+    pos += length;
+  }
+  return i;
+}
+
+}  // namespace binary_reader
@@ -0,0 +1,94 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BINARY_READER_UTIL_VARINT_H_
+#define BINARY_READER_UTIL_VARINT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace binary_reader {
+
+/// <summary>
+/// The largest number of bytes a 64-bit variable-length integer can use.
+/// </summary>
+constexpr const size_t kMaxVarintSize = 10;
+
+/// <summary>
+/// Decodes a single LEB128 (base 128, little endian) value.  This is the
+/// encoding used by protobuf, WebAssembly, and DWARF.
+/// </summary>
+/// <param name="buffer">The bytes to read.</param>
+/// <param name="size">The number of bytes available.</param>
+/// <param name="is_signed">Whether the value is signed LEB128.</param>
+/// <param name="value">Will be filled in with the raw 64-bit value.</param>
+/// <returns>
+/// The number of bytes used, or 0 if the value is truncated or doesn't fit in
+/// 64 bits.
+/// </returns>
+size_t DecodeLeb128(const uint8_t* buffer, size_t size, bool is_signed,
+                    uint64_t* value);
+
+/// <summary>
+/// Decodes a single UTF-8-style prefix varint.  The number of leading one
+/// bits in the first byte is the number of bytes that follow; the remaining
+/// bits of the first byte and the following bytes hold the value, most
+/// significant first.  A first byte of 0xff is followed by a full 64-bit
+/// value.
+/// </summary>
+/// <returns>
+/// The number of bytes used, or 0 if the value is truncated.
+/// </returns>
+size_t DecodePrefixVarint(const uint8_t* buffer, size_t size,
+                          uint64_t* value);
+
+/// <summary>
+/// Decodes consecutive unsigned LEB128 values.  This uses SIMD to find the
+/// value boundaries 16 bytes at a time when available.  Signed values only
+/// differ when they use all 10 bytes, so callers can decode those separately
+/// with DecodeLeb128 if this stops at one.
+/// </summary>
+/// <param name="buffer">The bytes to read.</param>
+/// <param name="size">The number of bytes available.</param>
+/// <param name="count">The number of values to decode.</param>
+/// <param name="values">Will be filled in with the raw values.</param>
+/// <param name="lengths">Will be filled in with the size of each value.</param>
+/// <returns>
+/// The number of values decoded.  This is less than |count| if a value is
+/// truncated or invalid.
+/// </returns>
+size_t DecodeLeb128Array(const uint8_t* buffer, size_t size, size_t count,
+                         uint64_t* values, uint8_t* lengths);
+
+/// <summary>
+/// Sign-extends a raw signed LEB128 value that used |length| bytes.
+/// </summary>
+inline int64_t SignExtendLeb128(uint64_t raw, size_t length) {
+  const size_t bits = length * 7;
+  if (bits < 64 && (raw & (1ull << (bits - 1))))
+    raw |= ~0ull << bits;
+  return static_cast<int64_t>(raw);
+}
+
+/// <summary>
+/// Decodes a protobuf-style zigzag value, which maps 0, 1, 2, 3, ... to
+/// 0, -1, 1, -2, ....
+/// </summary>
+inline int64_t ZigZagDecode(uint64_t raw) {
+  return static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+}
+
+}  // namespace binary_reader
+
+#endif  // BINARY_READER_UTIL_VARINT_H_
@@ -23,7 +23,7 @@ namespace binary_reader {
 
 namespace {
 
-std::shared_ptr<BufferedFileReader> MakeReader(
+std::shared_ptr<ParseState> MakeReader(
     std::initializer_list<uint8_t> buffer, uint64_t bits = 0,
     bool eof = false) {
   std::shared_ptr<MockFileReader> file;
@@ -36,11 +36,17 @@ std::shared_ptr<BufferedFileReader> MakeReader(
   EXPECT_CALL(*file, Seek(testing::Pointee(bits / 8), testing::_))
       .WillOnce(testing::Return(true));
 
-  auto ret = std::make_shared<BufferedFileReader>(file);
-  EXPECT_TRUE(ret->Seek(Size::FromBits(bits), nullptr));
+  auto ret =
+      std::make_shared<ParseState>(std::make_shared<BufferedFileReader>(file));
+  EXPECT_TRUE(ret->reader()->Seek(Size::FromBits(bits), nullptr));
   return ret;
 }
 
+bool ReadValue(const TypeInfoBase& type, std::shared_ptr<ParseState> state,
+               Value* result, ErrorCollection* errors) {
+  return type.ReadValue(ReadContext(state.get(), errors), result);
+}
+
 }  // namespace
 
 TEST(IntegerTypeInfoTest, ReadValue_UnsignedInt) {
@@ -48,8 +54,9 @@ TEST(IntegerTypeInfoTest, ReadValue_UnsignedInt) {
   ErrorCollection errors;
   IntegerTypeInfo integer({}, "", Size::FromBits(32), Signedness::Unsigned,
                           ByteOrder::BigEndian);
-  ASSERT_TRUE(integer.ReadValue(
-      MakeReader({0x11, 0x22, 0x33, 0x44, 0x55, 0x66}), &result, &errors));
+  ASSERT_TRUE(ReadValue(integer,
+                        MakeReader({0x11, 0x22, 0x33, 0x44, 0x55, 0x66}),
+                        &result, &errors));
   ASSERT_EQ(result, Value{0x11223344u});
 }
 
@@ -59,20 +66,33 @@ TEST(IntegerTypeInfoTest, ReadValue_LargeUnaligned) {
   ErrorCollection errors;
   IntegerTypeInfo int32({}, "", Size::FromBits(32), Signedness::Unsigned,
                         ByteOrder::BigEndian);
-  ASSERT_TRUE(
-      int32.ReadValue(MakeReader({0x12, 0x34, 0x56, 0x78, 0x90, 0x12}, kOffset),
-                      &result, &errors));
+  ASSERT_TRUE(ReadValue(
+      int32, MakeReader({0x12, 0x34, 0x56, 0x78, 0x90, 0x12}, kOffset),
+      &result, &errors));
   ASSERT_EQ(result, Value{0x23456789u});
 
   IntegerTypeInfo int64({}, "", Size::FromBits(64), Signedness::Unsigned,
                         ByteOrder::BigEndian);
-  ASSERT_TRUE(int64.ReadValue(
+  ASSERT_TRUE(ReadValue(
+      int64,
       MakeReader({0x12, 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x45},
                  kOffset),
       &result, &errors));
   ASSERT_EQ(result, Value{0x2333333333333334ull});
 }
 
+TEST(IntegerTypeInfoTest, ReadValue_OddUnaligned) {
+  constexpr const uint8_t kOffset = 3;
+  Value result;
+  ErrorCollection errors;
+  IntegerTypeInfo integer({}, "", Size::FromBits(32), Signedness::Unsigned,
+                          ByteOrder::BigEndian);
+  ASSERT_TRUE(ReadValue(
+      integer, MakeReader({0x12, 0x34, 0x56, 0x78, 0x9a, 0x0}, kOffset),
+      &result, &errors));
+  ASSERT_EQ(result, Value{0x91a2b3c4u});
+}
+
 TEST(IntegerTypeInfoTest, ReadValue_SmallUnaligned) {
   constexpr const uint8_t kOffset = 1;
   Value result;
@@ -80,7 +100,8 @@ TEST(IntegerTypeInfoTest, ReadValue_SmallUnaligned) {
   IntegerTypeInfo integer({}, "", Size::FromBits(5), Signedness::Unsigned,
                           ByteOrder::BigEndian);
   // 0110 1011
-  ASSERT_TRUE(integer.ReadValue(MakeReader({0x6b}, kOffset), &result, &errors));
+  ASSERT_TRUE(
+      ReadValue(integer, MakeReader({0x6b}, kOffset), &result, &errors));
   ASSERT_EQ(result, Value{0x1a});  // 110 10
 }
 
@@ -89,8 +110,9 @@ TEST(IntegerTypeInfoTest, ReadValue_SignedInt) {
   ErrorCollection errors;
   IntegerTypeInfo integer({}, "", Size::FromBits(32), Signedness::Signed,
                           ByteOrder::BigEndian);
-  ASSERT_TRUE(integer.ReadValue(
-      MakeReader({0x11, 0x22, 0x33, 0x44, 0x55, 0x66}), &result, &errors));
+  ASSERT_TRUE(ReadValue(integer,
+                        MakeReader({0x11, 0x22, 0x33, 0x44, 0x55, 0x66}),
+                        &result, &errors));
   ASSERT_EQ(result, Value{0x11223344});
 }
 
@@ -99,18 +121,19 @@ TEST(IntegerTypeInfoTest, ReadValue_Negative) {
   ErrorCollection errors;
   IntegerTypeInfo int16({}, "", Size::FromBits(16), Signedness::Signed,
                         ByteOrder::BigEndian);
-  ASSERT_TRUE(int16.ReadValue(MakeReader({0xff, 0xcd, 0x0}), &result, &errors));
+  ASSERT_TRUE(
+      ReadValue(int16, MakeReader({0xff, 0xcd, 0x0}), &result, &errors));
   ASSERT_EQ(result, Value{-51});
   IntegerTypeInfo int64({}, "", Size::FromBits(64), Signedness::Signed,
                         ByteOrder::BigEndian);
-  ASSERT_TRUE(int64.ReadValue(
-      MakeReader({0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xcd, 0x0}),
+  ASSERT_TRUE(ReadValue(
+      int64, MakeReader({0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xcd, 0x0}),
       &result, &errors));
   ASSERT_EQ(result, Value{-51});
   IntegerTypeInfo int_little({}, "", Size::FromBits(16), Signedness::Signed,
                              ByteOrder::LittleEndian);
   ASSERT_TRUE(
-      int_little.ReadValue(MakeReader({0xcd, 0xff, 0x0}), &result, &errors));
+      ReadValue(int_little, MakeReader({0xcd, 0xff, 0x0}), &result, &errors));
   ASSERT_EQ(result, Value{-51});
 }
 
@@ -119,9 +142,9 @@ TEST(IntegerTypeInfoTest, ReadValue_Eof) {
   ErrorCollection errors;
   IntegerTypeInfo integer({}, "", Size::FromBits(32), Signedness::Unsigned,
                           ByteOrder::BigEndian);
-  ASSERT_FALSE(integer.ReadValue(
-      MakeReader({0x11, 0x22}, /* bits= */ 0, /* eof= */ true), &result,
-      &errors));
+  ASSERT_FALSE(ReadValue(
+      integer, MakeReader({0x11, 0x22}, /* bits= */ 0, /* eof= */ true),
+      &result, &errors));
 }
 
 TEST(IntegerTypeInfoTest, ReadValue_EofUnaligned) {
@@ -130,9 +153,220 @@ TEST(IntegerTypeInfoTest, ReadValue_EofUnaligned) {
   ErrorCollection errors;
   IntegerTypeInfo integer({}, "", Size::FromBits(32), Signedness::Unsigned,
                           ByteOrder::BigEndian);
-  ASSERT_FALSE(integer.ReadValue(
-      MakeReader({0x11, 0x22, 0x33, 0x44}, kOffset, /* eof= */ true), &result,
+  ASSERT_FALSE(ReadValue(
+      integer, MakeReader({0x11, 0x22, 0x33, 0x44}, kOffset, /* eof= */ true),
+      &result, &errors));
+}
+
+TEST(FloatTypeInfoTest, ReadValue_Float16) {
+  Value result;
+  ErrorCollection errors;
+  FloatTypeInfo half({}, "", Size::FromBits(16), ByteOrder::BigEndian);
+  ASSERT_TRUE(
+      ReadValue(half, MakeReader({0x3e, 0x00, 0x0}), &result, &errors));
+  ASSERT_EQ(result, Value{1.5});
+  ASSERT_TRUE(
+      ReadValue(half, MakeReader({0xc5, 0x00, 0x0}), &result, &errors));
+  ASSERT_EQ(result, Value{-5.0});
+}
+
+TEST(FloatTypeInfoTest, ReadValue_Float32) {
+  Value result;
+  ErrorCollection errors;
+  FloatTypeInfo big({}, "", Size::FromBits(32), ByteOrder::BigEndian);
+  ASSERT_TRUE(ReadValue(big, MakeReader({0x40, 0x49, 0x0f, 0xdb, 0x0}),
+                        &result, &errors));
+  ASSERT_EQ(result, Value{3.1415927410125732});
+
+  FloatTypeInfo little({}, "", Size::FromBits(32), ByteOrder::LittleEndian);
+  ASSERT_TRUE(ReadValue(little, MakeReader({0x00, 0x00, 0x20, 0xc1, 0x0}),
+                        &result, &errors));
+  ASSERT_EQ(result, Value{-10.0});
+}
+
+TEST(FloatTypeInfoTest, ReadValue_Float64) {
+  Value result;
+  ErrorCollection errors;
+  FloatTypeInfo big({}, "", Size::FromBits(64), ByteOrder::BigEndian);
+  ASSERT_TRUE(ReadValue(
+      big, MakeReader({0x3f, 0xb9, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a, 0x0}),
+      &result, &errors));
+  ASSERT_EQ(result, Value{0.1});
+
+  FloatTypeInfo little({}, "", Size::FromBits(64), ByteOrder::LittleEndian);
+  ASSERT_TRUE(ReadValue(
+      little, MakeReader({0x9a, 0x99, 0x99, 0x99, 0x99, 0x99, 0xb9, 0x3f, 0x0}),
+      &result, &errors));
+  ASSERT_EQ(result, Value{0.1});
+}
+
+TEST(FloatTypeInfoTest, ReadValue_Unaligned) {
+  constexpr const uint8_t kOffset = 4;
+  Value result;
+  ErrorCollection errors;
+  FloatTypeInfo half({}, "", Size::FromBits(16), ByteOrder::BigEndian);
+  // 1.5 (0x3e00) shifted by 4 bits.
+  ASSERT_TRUE(ReadValue(half, MakeReader({0xa3, 0xe0, 0x0f}, kOffset),
+                        &result, &errors));
+  ASSERT_EQ(result, Value{1.5});
+}
+
+TEST(VarintTypeInfoTest, ReadValue) {
+  Value result;
+  ErrorCollection errors;
+  VarintTypeInfo uleb({}, "", VarintEncoding::Leb128);
+  ASSERT_TRUE(ReadValue(uleb, MakeReader({0xe5, 0x8e, 0x26, 0x0}, 0, true),
+                        &result, &errors));
+  EXPECT_EQ(result, Value{624485u});
+
+  VarintTypeInfo sleb({}, "", VarintEncoding::SignedLeb128);
+  ASSERT_TRUE(ReadValue(sleb, MakeReader({0xc0, 0xbb, 0x78, 0x0}, 0, true),
+                        &result, &errors));
+  EXPECT_EQ(result, Value{-123456});
+
+  VarintTypeInfo zigzag({}, "", VarintEncoding::ZigZag);
+  ASSERT_TRUE(
+      ReadValue(zigzag, MakeReader({0x03, 0x0}, 0, true), &result, &errors));
+  EXPECT_EQ(result, Value{-2});
+
+  VarintTypeInfo prefix({}, "", VarintEncoding::Prefix);
+  ASSERT_TRUE(ReadValue(prefix, MakeReader({0x81, 0x23, 0x0}, 0, true),
+                        &result, &errors));
+  EXPECT_EQ(result, Value{0x123u});
+}
+
+TEST(VarintTypeInfoTest, ReadValue_Eof) {
+  Value result;
+  ErrorCollection errors;
+  VarintTypeInfo uleb({}, "", VarintEncoding::Leb128);
+  ASSERT_FALSE(ReadValue(
+      uleb, MakeReader({0x80, 0x80}, /* bits= */ 0, /* eof= */ true), &result,
+      &errors));
+  ASSERT_EQ(errors.size(), 1u);
+  EXPECT_EQ(errors.begin()->kind, ErrorKind::UnexpectedEndOfStream);
+}
+
+TEST(VarintTypeInfoTest, ReadValue_TooLong) {
+  Value result;
+  ErrorCollection errors;
+  VarintTypeInfo uleb({}, "", VarintEncoding::Leb128);
+  ASSERT_FALSE(ReadValue(uleb,
+                         MakeReader({0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                                     0xff, 0xff, 0x7f}),
+                         &result, &errors));
+  ASSERT_EQ(errors.size(), 1u);
+  EXPECT_EQ(errors.begin()->kind, ErrorKind::VarintTooLong);
+
+  // The same last byte ends the smallest signed value.
+  errors.clear();
+  VarintTypeInfo sleb({}, "", VarintEncoding::SignedLeb128);
+  ASSERT_TRUE(ReadValue(sleb,
+                        MakeReader({0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                                    0x80, 0x80, 0x7f}),
+                        &result, &errors));
+  EXPECT_EQ(result, Value{INT64_MIN});
+}
+
+TEST(VarintTypeInfoTest, ReadValue_Unaligned) {
+  Value result;
+  ErrorCollection errors;
+  VarintTypeInfo uleb({}, "", VarintEncoding::Leb128);
+  auto state = MakeReader({0x01}, /* bits= */ 4);
+  ASSERT_TRUE(state->reader()->EnsureBuffer(Size::FromBits(4), &errors));
+  ASSERT_FALSE(ReadValue(uleb, state, &result, &errors));
+  ASSERT_EQ(errors.size(), 1u);
+  EXPECT_EQ(errors.begin()->kind, ErrorKind::VarintAlign);
+}
+
+TEST(StringTypeInfoTest, Instantiate) {
+  StringTypeInfo builtin({}, "cstring", CodecId::Unknown);
+  EXPECT_EQ(builtin.codec(), CodecCollection::GetBuiltinCodec(CodecId::Utf8));
+
+  Options options;
+  ASSERT_TRUE(options.SetOption(OptionType::Encoding, CodecId::Latin1));
+  auto latin1 = std::dynamic_pointer_cast<StringTypeInfo>(
+      builtin.Instantiate({}, options));
+  ASSERT_TRUE(latin1);
+  EXPECT_EQ(latin1->encoding(), CodecId::Latin1);
+  EXPECT_EQ(latin1->codec(),
+            CodecCollection::GetBuiltinCodec(CodecId::Latin1));
+}
+
+TEST(StringTypeInfoTest, ReadValue) {
+  Value result;
+  ErrorCollection errors;
+  StringTypeInfo utf8({}, "", CodecId::Utf8);
+  auto state = MakeReader({'a', 0xc2, 0xa3, 0, 'b'});
+  ASSERT_TRUE(ReadValue(utf8, state, &result, &errors));
+  EXPECT_EQ(result, Value{UtfString::FromUtf8("a\xc2\xa3")});
+  EXPECT_EQ(state->reader()->position(), Size::FromBytes(4));
+
+  StringTypeInfo latin1({}, "", CodecId::Latin1);
+  ASSERT_TRUE(ReadValue(latin1, MakeReader({'a', 0xa3, 0}), &result, &errors));
+  EXPECT_EQ(result, Value{UtfString::FromUtf8("a\xc2\xa3")});
+}
+
+TEST(StringTypeInfoTest, ReadValue_Utf16) {
+  Value result;
+  ErrorCollection errors;
+  StringTypeInfo utf16({}, "", CodecId::Utf16Le);
+  // The zero bytes that straddle two code units aren't the terminator.
+  auto state = MakeReader({'a', 0, 0, 0x01, 0, 0, 'b', 0});
+  ASSERT_TRUE(ReadValue(utf16, state, &result, &errors));
+  EXPECT_EQ(result, Value{UtfString{u"a\u0100"}});
+  EXPECT_EQ(state->reader()->position(), Size::FromBytes(6));
+}
+
+TEST(StringTypeInfoTest, ReadValue_Eof) {
+  Value result;
+  ErrorCollection errors;
+  StringTypeInfo utf8({}, "", CodecId::Utf8);
+  ASSERT_FALSE(ReadValue(
+      utf8, MakeReader({'a', 'b'}, /* bits= */ 0, /* eof= */ true), &result,
       &errors));
+  ASSERT_EQ(errors.size(), 1u);
+  EXPECT_EQ(errors.begin()->kind, ErrorKind::UnexpectedEndOfStream);
+}
+
+TEST(StringTypeInfoTest, ReadValue_Invalid) {
+  Value result;
+  ErrorCollection errors;
+  StringTypeInfo sjis({}, "", CodecId::ShiftJis);
+  ASSERT_FALSE(ReadValue(sjis, MakeReader({'a', 0x82, 0x20, 0}), &result,
+                         &errors));
+  ASSERT_EQ(errors.size(), 1u);
+  EXPECT_EQ(errors.begin()->kind, ErrorKind::InvalidString);
+  EXPECT_EQ(errors.begin()->offset, 1u);
+}
+
+TEST(StringTypeInfoTest, ReadValue_Truncated) {
+  Value result;
+  ErrorCollection errors;
+  StringTypeInfo sjis({}, "", CodecId::ShiftJis);
+  ASSERT_FALSE(ReadValue(sjis, MakeReader({0x82, 0}), &result, &errors));
+  StringTypeInfo utf8({}, "", CodecId::Utf8);
+  ASSERT_FALSE(ReadValue(utf8, MakeReader({'a', 0xe2, 0x82, 0}), &result,
+                         &errors));
+  ASSERT_EQ(errors.size(), 2u);
+  EXPECT_EQ(errors.errors()[0].kind, ErrorKind::InvalidString);
+  EXPECT_EQ(errors.errors()[0].offset, 0u);
+  EXPECT_EQ(errors.errors()[1].kind, ErrorKind::InvalidString);
+  EXPECT_EQ(errors.errors()[1].offset, 1u);
+}
+
+TEST(StringTypeInfoTest, ReadValue_Interned) {
+  Value first, second;
+  ErrorCollection errors;
+  StringTypeInfo utf8({}, "", CodecId::Utf8);
+  auto state = MakeReader({'a', 'b', 0, 'a', 'b', 0});
+  state->EnableStringInterning();
+  ASSERT_TRUE(ReadValue(utf8, state, &first, &errors));
+  ASSERT_TRUE(ReadValue(utf8, state, &second, &errors));
+  EXPECT_EQ(first, Value{UtfString::FromUtf8("ab")});
+  EXPECT_EQ(second, first);
+  EXPECT_EQ(state->interner()->stats().strings, 1u);
+  EXPECT_EQ(state->interner()->stats().hits, 1u);
+  EXPECT_EQ(state->interner()->stats().bytes_shared, 2u);
 }
 
 }  // namespace binary_reader
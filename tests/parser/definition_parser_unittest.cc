@@ -113,6 +113,26 @@ TEST(DefinitionParserTest, ParseFile_Fields_Options) {
                ByteOrder::LittleEndian);
 }
 
+TEST(DefinitionParserTest, ParseFile_Fields_Encoding) {
+  std::vector<std::shared_ptr<TypeDefinition>> defs;
+  std::shared_ptr<FieldInfo> field;
+  ASSERT_TRUE(ParseSuccess(
+      "type foo { cstring x; cstring<latin1> y; cstring<encoding=utf16le> z; }",
+      &defs));
+  ASSERT_EQ(defs.size(), 1u);
+
+  const CodecId expected[] = {CodecId::Unknown, CodecId::Latin1,
+                              CodecId::Utf16Le};
+  ASSERT_EQ(defs[0]->statements().size(), 3u);
+  for (size_t i = 0; i < 3; i++) {
+    ASSERT_TRUE((field = as_field(defs[0]->statements()[i])));
+    auto* str = dynamic_cast<StringTypeInfo*>(field->type().get());
+    ASSERT_TRUE(str);
+    EXPECT_EQ(str->encoding(), expected[i]);
+    ASSERT_TRUE(str->codec());
+  }
+}
+
 TEST(DefinitionParserTest, ParseFile_Fields_Expected) {
   std::vector<std::shared_ptr<TypeDefinition>> defs;
   std::shared_ptr<FieldInfo> field;
@@ -14,6 +14,9 @@
 
 #include "binary_reader/codecs.h"
 
+#include <string>
+#include <vector>
+
 #include "gtest_wrapper.h"
 #include "util/templates.h"
 
@@ -27,6 +30,55 @@ std::shared_ptr<TextConverter> MakeUtf8() {
       ->CreateCoder();
 }
 
+std::shared_ptr<TextConverter> MakeCoder(const std::string& name) {
+  return CodecCollection::CreateDefaultCollection()
+      ->GetCodec(name)
+      ->CreateCoder();
+}
+
+// Decodes the bytes and encodes the result, checking both directions.
+void ExpectRoundTrip(const std::string& codec,
+                     const std::vector<uint8_t>& bytes,
+                     const std::u16string& text) {
+  SCOPED_TRACE(codec);
+  ErrorInfo err;
+  std::u16string decoded;
+  ASSERT_EQ(MakeCoder(codec)->Decode(bytes.data(), bytes.size(), &decoded,
+                                     &err),
+            TextConverter::Status::Success)
+      << err.message;
+  EXPECT_EQ(decoded, text);
+
+  std::vector<uint8_t> encoded;
+  ASSERT_EQ(
+      MakeCoder(codec)->Encode(text.data(), text.size(), &encoded, &err),
+      TextConverter::Status::Success)
+      << err.message;
+  EXPECT_EQ(encoded, bytes);
+}
+
+// Decodes the bytes one at a time to check characters split between calls.
+std::u16string DecodeBytewise(const std::string& codec,
+                              const std::vector<uint8_t>& bytes) {
+  ErrorInfo err;
+  std::u16string ret;
+  auto conv = MakeCoder(codec);
+  for (uint8_t b : bytes) {
+    EXPECT_EQ(conv->Decode(&b, 1, &ret, &err), TextConverter::Status::Success);
+  }
+  return ret;
+}
+
+class CountingCodec final : public Codec {
+ public:
+  std::shared_ptr<TextConverter> CreateCoder() override {
+    created++;
+    return CodecCollection::GetBuiltinCodec(CodecId::Utf8)->CreateCoder();
+  }
+
+  int created = 0;
+};
+
 }  // namespace
 
 TEST(Utf8CodecsTest, Decode) {
@@ -98,4 +150,213 @@ TEST(Utf8CodecsTest, Encode) {
             std::vector<uint8_t>(expected, expected + arraysize(expected)));
 }
 
+TEST(Utf8CodecsTest, Decode_Long) {
+  // Long enough to use the SIMD paths, with a sequence split between calls.
+  const std::string text =
+      "A long run of plain ASCII text to decode \xe2\x82\xac and "
+      "more ASCII after it \xef\xbf\xbf\xf0\xa0\x80\x80";
+  const std::u16string expected =
+      u"A long run of plain ASCII text to decode € and more ASCII after it "
+      u"\uffff\U00020000";
+  const auto* bytes = reinterpret_cast<const uint8_t*>(text.data());
+  const size_t split = text.size() - 2;
+
+  ErrorInfo err;
+  std::u16string actual;
+  auto conv = MakeUtf8();
+  ASSERT_EQ(conv->Decode(bytes, split, &actual, &err),
+            TextConverter::Status::Success);
+  ASSERT_EQ(conv->Decode(bytes + split, text.size() - split, &actual, &err),
+            TextConverter::Status::Success);
+  EXPECT_EQ(actual, expected);
+}
+
+TEST(Utf8CodecsTest, Encode_Long) {
+  const std::u16string chars =
+      u"A long run of plain ASCII text to encode € and more ASCII after it "
+      u"\U00020000\U0010ffff";
+  const std::string expected =
+      "A long run of plain ASCII text to encode \xe2\x82\xac and "
+      "more ASCII after it \xf0\xa0\x80\x80\xf4\x8f\xbf\xbf";
+
+  ErrorInfo err;
+  std::vector<uint8_t> actual;
+  auto conv = MakeUtf8();
+  ASSERT_EQ(conv->Encode(chars.data(), chars.size(), &actual, &err),
+            TextConverter::Status::Success);
+  EXPECT_EQ(std::string(actual.begin(), actual.end()), expected);
+}
+
+TEST(Utf8CodecsTest, DecodeBuffer) {
+  const uint8_t bytes[] = {'a', 0xc2, 0xa3, 0xe2, 0x82, 0xac, 0xe2, 0x82};
+  const auto& codec = CodecCollection::GetBuiltinCodec(CodecId::Utf8);
+
+  // Each call is independent, so a sequence cut off at the end is invalid.
+  ErrorInfo err;
+  std::u16string actual;
+  ASSERT_EQ(codec->DecodeBuffer(bytes, sizeof(bytes), &actual, &err),
+            TextConverter::Status::Error);
+  EXPECT_EQ(err.offset, 6u);
+  actual.clear();
+  ASSERT_EQ(codec->DecodeBuffer(bytes, sizeof(bytes) - 2, &actual, &err),
+            TextConverter::Status::Success);
+  EXPECT_EQ(actual, u"a£€");
+  ASSERT_EQ(codec->DecodeBuffer(bytes, 3, &actual, &err),
+            TextConverter::Status::Success);
+  EXPECT_EQ(actual, u"a£€a£");
+
+  std::vector<uint8_t> encoded;
+  ASSERT_EQ(codec->EncodeBuffer(actual.data(), actual.size(), &encoded, &err),
+            TextConverter::Status::Success);
+  EXPECT_EQ(encoded, std::vector<uint8_t>({'a', 0xc2, 0xa3, 0xe2, 0x82, 0xac,
+                                           'a', 0xc2, 0xa3}));
+}
+
+TEST(LegacyCodecsTest, SingleByte) {
+  ExpectRoundTrip("latin1", {'a', 0x80, 0xa3, 0xff}, u"a\u0080\u00a3\u00ff");
+  ExpectRoundTrip("windows-1252", {'a', 0x80, 0x81, 0xe9},
+                  u"a\u20ac\u0081\u00e9");
+  ExpectRoundTrip("cp1251", {0xc0, 'b', 0xff}, u"\u0410b\u044f");
+}
+
+TEST(LegacyCodecsTest, SingleByte_Long) {
+  // Long enough to use the SIMD paths.
+  std::vector<uint8_t> bytes;
+  std::u16string text;
+  for (int i = 0; i < 256; i++) {
+    bytes.push_back(static_cast<uint8_t>(i));
+    text.push_back(static_cast<char16_t>(i));
+  }
+  ExpectRoundTrip("latin1", bytes, text);
+
+  // Windows-1252 only differs from Latin-1 in 0x80-0x9f.
+  bytes.erase(bytes.begin() + 0x81, bytes.begin() + 0xa0);
+  text.erase(text.begin() + 0x81, text.begin() + 0xa0);
+  text[0x80] = 0x20ac;
+  ExpectRoundTrip("windows-1252", bytes, text);
+}
+
+TEST(LegacyCodecsTest, SingleByte_Unencodable) {
+  const std::u16string text = u"abc\u20ac";
+  ErrorInfo err;
+  std::vector<uint8_t> actual;
+  EXPECT_EQ(MakeCoder("latin1")->Encode(text.data(), text.size(), &actual,
+                                        &err),
+            TextConverter::Status::Error);
+  EXPECT_EQ(err.offset, 3u);
+
+  err = ErrorInfo();
+  actual.clear();
+  EXPECT_EQ(MakeCoder("windows-1251")->Encode(text.data(), text.size(),
+                                              &actual, &err),
+            TextConverter::Status::Success);
+  EXPECT_EQ(actual, std::vector<uint8_t>({'a', 'b', 'c', 0x88}));
+}
+
+TEST(LegacyCodecsTest, Utf16) {
+  const std::u16string text = u"a\u20ac\U00010000 and a longer tail of text";
+  std::vector<uint8_t> little, big;
+  for (char16_t c : text) {
+    little.push_back(static_cast<uint8_t>(c & 0xff));
+    little.push_back(static_cast<uint8_t>(c >> 8));
+    big.push_back(static_cast<uint8_t>(c >> 8));
+    big.push_back(static_cast<uint8_t>(c & 0xff));
+  }
+  ExpectRoundTrip("utf-16le", little, text);
+  ExpectRoundTrip("UTF-16BE", big, text);
+  EXPECT_EQ(DecodeBytewise("utf-16le", little), text);
+  EXPECT_EQ(DecodeBytewise("utf-16be", big), text);
+}
+
+TEST(LegacyCodecsTest, ShiftJis) {
+  const std::vector<uint8_t> bytes = {'a', 0x82, 0xa0, 0x8a, 0xbf, 0xb1, 'z'};
+  const std::u16string text = u"a\u3042\u6f22\uff71z";
+  ExpectRoundTrip("shift_jis", bytes, text);
+  EXPECT_EQ(DecodeBytewise("sjis", bytes), text);
+}
+
+TEST(LegacyCodecsTest, ShiftJis_Invalid) {
+  const uint8_t bytes[] = {'a', 0x82, 0x20};
+  ErrorInfo err;
+  std::u16string actual;
+  EXPECT_EQ(MakeCoder("Shift_JIS")->Decode(bytes, sizeof(bytes), &actual,
+                                           &err),
+            TextConverter::Status::Error);
+  EXPECT_EQ(err.offset, 1u);
+}
+
+TEST(LegacyCodecsTest, Gb18030) {
+  const std::vector<uint8_t> bytes = {
+      0xd6, 0xd0, 0xa2, 0xe3, 0x81, 0x30, 0x8a, 0x31,
+      0x90, 0x30, 0x81, 0x30, 0xe3, 0x32, 0x9a, 0x35, 'z',
+  };
+  const std::u16string text = u"\u4e2d\u20ac\u00e4\U00010000\U0010ffffz";
+  ExpectRoundTrip("gb18030", bytes, text);
+  EXPECT_EQ(DecodeBytewise("GB18030", bytes), text);
+}
+
+TEST(LegacyCodecsTest, Gb18030_LoneSurrogate) {
+  const char16_t text[] = {'a', 0xd800, 'b'};
+  ErrorInfo err;
+  std::vector<uint8_t> actual;
+  EXPECT_EQ(MakeCoder("gb18030")->Encode(text, arraysize(text), &actual,
+                                         &err),
+            TextConverter::Status::Error);
+  EXPECT_EQ(err.offset, 1u);
+}
+
+TEST(CodecTest, ReusesThreadCoder) {
+  CountingCodec codec;
+  const uint8_t bytes[] = {'a', 'b'};
+  for (int i = 0; i < 100; i++) {
+    ErrorInfo err;
+    std::u16string actual;
+    ASSERT_EQ(codec.DecodeBuffer(bytes, sizeof(bytes), &actual, &err),
+              TextConverter::Status::Success);
+    EXPECT_EQ(actual, u"ab");
+  }
+  EXPECT_EQ(codec.created, 1);
+
+  // A converter that is still held isn't handed out again.
+  auto first = codec.GetThreadCoder();
+  auto second = codec.GetThreadCoder();
+  EXPECT_NE(first, second);
+  EXPECT_EQ(codec.created, 2);
+
+  // A converter is reset before it is reused.
+  const uint8_t partial[] = {0xc2};
+  ErrorInfo err;
+  std::u16string actual;
+  ASSERT_EQ(first->Decode(partial, sizeof(partial), &actual, &err),
+            TextConverter::Status::Success);
+  first.reset();
+  second.reset();
+  ASSERT_EQ(codec.GetThreadCoder()->Decode(bytes, sizeof(bytes), &actual,
+                                           &err),
+            TextConverter::Status::Success);
+  EXPECT_EQ(actual, u"ab");
+  EXPECT_EQ(codec.created, 2);
+}
+
+TEST(CodecCollectionTest, GetCodecId) {
+  EXPECT_EQ(GetCodecId("utf8"), CodecId::Utf8);
+  EXPECT_EQ(GetCodecId("UTF-8"), CodecId::Utf8);
+  EXPECT_EQ(GetCodecId("cp1252"), CodecId::Windows1252);
+  EXPECT_EQ(GetCodecId("Shift_JIS"), CodecId::ShiftJis);
+  EXPECT_EQ(GetCodecId("foo"), CodecId::Unknown);
+}
+
+TEST(CodecCollectionTest, SharesBuiltinCodecs) {
+  const auto& utf8 = CodecCollection::GetBuiltinCodec(CodecId::Utf8);
+  ASSERT_TRUE(utf8);
+  EXPECT_EQ(utf8->id(), CodecId::Utf8);
+  EXPECT_EQ(CodecCollection::GetBuiltinCodec(CodecId::Unknown), nullptr);
+
+  auto first = CodecCollection::CreateDefaultCollection();
+  auto second = CodecCollection::CreateDefaultCollection();
+  EXPECT_EQ(first->GetCodec("utf-8"), utf8);
+  EXPECT_EQ(second->GetCodec("UTF8"), utf8);
+  EXPECT_EQ(first->GetDefaultCodec(), utf8);
+}
+
 }  // namespace binary_reader
@@ -14,10 +14,15 @@
 
 #include "binary_reader/file_object.h"
 
+#include <atomic>
+#include <thread>
+
 #include "ast/field_info.h"
+#include "ast/literal.h"
 #include "gtest_wrapper.h"
 #include "mocks.h"
 #include "public/file_object_init.h"
+#include "util/memory_file_system.h"
 
 namespace binary_reader {
 
@@ -29,6 +34,49 @@ std::shared_ptr<IntegerTypeInfo> MakeInt(size_t bits) {
       ByteOrder::BigEndian);
 }
 
+std::shared_ptr<FloatTypeInfo> MakeFloat(size_t bits) {
+  return std::make_shared<FloatTypeInfo>(DebugInfo{}, "", Size::FromBits(bits),
+                                         ByteOrder::LittleEndian);
+}
+
+/// <summary>
+/// Reads from memory, counting the positional reads.
+/// </summary>
+class CountingFileReader final : public FileReader {
+ public:
+  explicit CountingFileReader(const std::string& data)
+      : file_(std::make_shared<MemoryFileReader>(data)) {}
+
+  bool can_seek() const override {
+    return file_->can_seek();
+  }
+  uint64_t position() const override {
+    return file_->position();
+  }
+  std::optional<uint64_t> size() const override {
+    return file_->size();
+  }
+  bool Read(uint8_t* buffer, size_t* size, ErrorCollection* errors) override {
+    return file_->Read(buffer, size, errors);
+  }
+  bool Seek(uint64_t* position, ErrorCollection* errors) override {
+    return file_->Seek(position, errors);
+  }
+  bool can_read_at() const override {
+    return true;
+  }
+  bool ReadAt(uint64_t position, uint8_t* buffer, size_t* size,
+              ErrorCollection* errors) override {
+    reads++;
+    return file_->ReadAt(position, buffer, size, errors);
+  }
+
+  int reads = 0;
+
+ private:
+  const std::shared_ptr<MemoryFileReader> file_;
+};
+
 }  // namespace
 
 class FileObjectTest : public testing::Test {
@@ -42,24 +90,47 @@ class FileObjectTest : public testing::Test {
 
   std::shared_ptr<FileObject> MakeObjectFromFile(
       std::shared_ptr<TypeDefinition> type,
-      std::initializer_list<uint8_t> data) {
-    auto file = std::make_shared<MockFileReader>(data);
+      std::initializer_list<uint8_t> data, bool eof = false) {
+    std::shared_ptr<MockFileReader> file;
+    {
+      testing::InSequence seq;
+      file = std::make_shared<MockFileReader>(data);
+      // Variable-length values buffer past the end of the data, possibly
+      // more than once.
+      if (eof) {
+        EXPECT_CALL(*file, Read(testing::_, testing::_, testing::_))
+            .WillRepeatedly(testing::DoAll(testing::SetArgPointee<1>(0),
+                                           testing::Return(true)));
+      }
+    }
     EXPECT_CALL(*file, Seek(testing::Pointee(0), testing::_))
         .WillOnce(testing::Return(true));
+    // Only reading fields one at a time skips past the end of the object.
     EXPECT_CALL(*file, Seek(testing::Pointee(data.size()), testing::_))
-        .WillOnce(testing::Return(true));
+        .Times(testing::AtMost(1))
+        .WillRepeatedly(testing::Return(true));
 
     FileObjectInit init;
-    init.file = std::make_shared<BufferedFileReader>(file);
+    state_ = std::make_shared<ParseState>(
+        std::make_shared<BufferedFileReader>(file));
+    if (use_arena_)
+      state_->EnableArena();
+    if (eager_decode_)
+      state_->EnableEagerDecode();
+    init.state = state_;
     init.type = type;
     init.start_position = Size{};
 
     auto ret = MakeFileObject(init);
-    ErrorCollection errors;
-    if (ret && !ret->ReparseObject(&errors))
+    if (ret && !ret->ReparseObject(&errors_))
       ret.reset();
     return ret;
   }
+
+  std::shared_ptr<ParseState> state_;
+  ErrorCollection errors_;
+  bool use_arena_ = false;
+  bool eager_decode_ = false;
 };
 
 TEST_F(FileObjectTest, BasicFlow_TestMode) {
@@ -86,6 +157,914 @@ TEST_F(FileObjectTest, BasicFlow_NormalMode) {
   EXPECT_EQ(obj->GetFieldValue("a"), Value{0x1122});
   EXPECT_EQ(obj->GetFieldValue("b"), Value{0x55667788});
   EXPECT_EQ(obj->GetFieldValue("c"), Value{});
+  EXPECT_EQ(state_->stats()->fields_decoded, 2u);
+}
+
+TEST_F(FileObjectTest, StaticLayout_DecodesAllFields) {
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", MakeInt(4)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", MakeInt(12)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "c", MakeFloat(32)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "d", MakeFloat(32)),
+          });
+  ASSERT_TRUE(def->static_layout());
+
+  auto obj = MakeObjectFromFile(def, {0x12, 0x34, 0x00, 0x00, 0x80, 0x3f, 0x00,
+                                      0x00, 0x20, 0xc1});
+  ASSERT_TRUE(obj);
+  EXPECT_EQ(obj->GetFieldValue("a"), Value{0x1});
+  EXPECT_EQ(obj->GetFieldValue("b"), Value{0x234});
+  EXPECT_EQ(obj->GetFieldValue("c"), Value{1.0});
+  EXPECT_EQ(obj->GetFieldValue("d"), Value{-10.0});
+}
+
+TEST_F(FileObjectTest, StaticLayout_NotUsedForNestedTypes) {
+  auto inner = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "x", MakeInt(8)),
+          });
+  auto outer = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", MakeInt(8)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", inner),
+          });
+  EXPECT_TRUE(inner->static_layout());
+  EXPECT_FALSE(outer->static_layout());
+}
+
+TEST_F(FileObjectTest, ExpectedValue_Matches) {
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(
+                  DebugInfo{}, "magic", MakeInt(16),
+                  std::make_shared<Literal>(DebugInfo{}, Value{0x1122})),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", MakeInt(8)),
+          });
+
+  auto obj = MakeObjectFromFile(def, {0x11, 0x22, 0x33});
+  ASSERT_TRUE(obj);
+  EXPECT_EQ(obj->GetFieldValue("magic"), Value{0x1122});
+  EXPECT_EQ(obj->GetFieldValue("b"), Value{0x33});
+}
+
+TEST_F(FileObjectTest, ExpectedValue_Mismatch) {
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", MakeInt(8)),
+              std::make_shared<FieldInfo>(
+                  DebugInfo{}, "magic", MakeInt(16),
+                  std::make_shared<Literal>(DebugInfo{}, Value{0x1122})),
+          });
+
+  EXPECT_FALSE(MakeObjectFromFile(def, {0x00, 0x11, 0x23}));
+  ASSERT_EQ(errors_.size(), 1u);
+  EXPECT_EQ(errors_.begin()->kind, ErrorKind::UnexpectedFieldValue);
+  EXPECT_EQ(errors_.begin()->offset, 1u);
+}
+
+TEST_F(FileObjectTest, DynamicFields) {
+  auto uleb = std::make_shared<VarintTypeInfo>(DebugInfo{}, "",
+                                               VarintEncoding::Leb128);
+  auto zigzag = std::make_shared<VarintTypeInfo>(DebugInfo{}, "",
+                                                 VarintEncoding::ZigZag);
+  auto prefix = std::make_shared<VarintTypeInfo>(DebugInfo{}, "",
+                                                 VarintEncoding::Prefix);
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", uleb),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", zigzag),
+              std::make_shared<FieldInfo>(DebugInfo{}, "c", uleb),
+              std::make_shared<FieldInfo>(DebugInfo{}, "d", MakeInt(8)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "e", prefix),
+              std::make_shared<FieldInfo>(DebugInfo{}, "f", MakeInt(8)),
+          });
+  EXPECT_FALSE(def->static_size());
+  EXPECT_FALSE(def->static_layout());
+
+  auto obj = MakeObjectFromFile(
+      def, {0xe5, 0x8e, 0x26, 0x03, 0x7f, 0x11, 0x81, 0x23, 0x22},
+      /* eof= */ true);
+  ASSERT_TRUE(obj);
+  EXPECT_EQ(obj->GetFieldValue("a"), Value{624485u});
+  EXPECT_EQ(obj->GetFieldValue("b"), Value{-2});
+  EXPECT_EQ(obj->GetFieldValue("c"), Value{0x7fu});
+  EXPECT_EQ(obj->GetFieldValue("d"), Value{0x11});
+  EXPECT_EQ(obj->GetFieldValue("e"), Value{0x123u});
+  EXPECT_EQ(obj->GetFieldValue("f"), Value{0x22});
+}
+
+TEST_F(FileObjectTest, DynamicFields_SignedRun) {
+  auto sleb = std::make_shared<VarintTypeInfo>(DebugInfo{}, "",
+                                               VarintEncoding::SignedLeb128);
+  auto uleb = std::make_shared<VarintTypeInfo>(DebugInfo{}, "",
+                                               VarintEncoding::Leb128);
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", sleb),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", uleb),
+          });
+
+  auto obj = MakeObjectFromFile(def,
+                                {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                                 0x80, 0x80, 0x7f, 0x05},
+                                /* eof= */ true);
+  ASSERT_TRUE(obj);
+  EXPECT_EQ(obj->GetFieldValue("a"), Value{INT64_MIN});
+  EXPECT_EQ(obj->GetFieldValue("b"), Value{5u});
+
+  // Bit 63 is set without the sign bits past it.
+  EXPECT_FALSE(MakeObjectFromFile(def,
+                                  {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                                   0x80, 0x80, 0x01, 0x05},
+                                  /* eof= */ true));
+  ASSERT_EQ(errors_.size(), 1u);
+  EXPECT_EQ(errors_.begin()->kind, ErrorKind::VarintTooLong);
+}
+
+TEST_F(FileObjectTest, DynamicFields_NestedType) {
+  auto inner = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(
+                  DebugInfo{}, "x",
+                  std::make_shared<VarintTypeInfo>(DebugInfo{}, "",
+                                                   VarintEncoding::Leb128)),
+          });
+  auto outer = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", inner),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", MakeInt(8)),
+          });
+
+  auto obj = MakeObjectFromFile(outer, {0x80, 0x01, 0x33}, /* eof= */ true);
+  ASSERT_TRUE(obj);
+  auto a = obj->GetFieldValue("a").as_object();
+  ASSERT_TRUE(a);
+  EXPECT_EQ(a->GetFieldValue("x"), Value{0x80u});
+  EXPECT_EQ(obj->GetFieldValue("b"), Value{0x33});
+}
+
+TEST_F(FileObjectTest, EagerDecode) {
+  auto uleb = std::make_shared<VarintTypeInfo>(DebugInfo{}, "",
+                                               VarintEncoding::Leb128);
+  auto inner = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "x", MakeInt(8)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "y", MakeInt(8)),
+          });
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", MakeInt(8)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", uleb),
+              std::make_shared<FieldInfo>(DebugInfo{}, "c", inner),
+              std::make_shared<FieldInfo>(DebugInfo{}, "d", MakeInt(8)),
+          });
+
+  eager_decode_ = true;
+  auto obj = MakeObjectFromFile(def, {0x11, 0x7f, 0x22, 0x33, 0x44},
+                                /* eof= */ true);
+  ASSERT_TRUE(obj);
+  // Everything is read while parsing, including the child object.
+  EXPECT_EQ(state_->stats()->fields_decoded, 6u);
+  EXPECT_EQ(obj->GetFieldValue("a"), Value{0x11});
+  EXPECT_EQ(obj->GetFieldValue("b"), Value{0x7fu});
+  auto c = obj->GetFieldValue("c").as_object();
+  ASSERT_TRUE(c);
+  EXPECT_EQ(c->GetFieldValue("x"), Value{0x22});
+  EXPECT_EQ(c->GetFieldValue("y"), Value{0x33});
+  EXPECT_EQ(obj->GetFieldValue("d"), Value{0x44});
+  EXPECT_EQ(state_->stats()->fields_decoded, 6u);
+}
+
+TEST_F(FileObjectTest, EagerDecode_StaticLayout) {
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", MakeInt(16)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", MakeInt(32)),
+          });
+
+  eager_decode_ = true;
+  auto obj = MakeObjectFromFile(def, {0x11, 0x22, 0x55, 0x66, 0x77, 0x88});
+  ASSERT_TRUE(obj);
+  EXPECT_EQ(state_->stats()->fields_decoded, 2u);
+  EXPECT_EQ(obj->GetFieldValue("a"), Value{0x1122});
+  EXPECT_EQ(obj->GetFieldValue("b"), Value{0x55667788});
+  EXPECT_EQ(state_->stats()->fields_decoded, 2u);
+}
+
+TEST_F(FileObjectTest, GetFieldValues) {
+  auto uleb = std::make_shared<VarintTypeInfo>(DebugInfo{}, "",
+                                               VarintEncoding::Leb128);
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", uleb),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", MakeInt(8)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "c", uleb),
+              std::make_shared<FieldInfo>(DebugInfo{}, "d", MakeInt(16)),
+          });
+
+  // Cleared values are read again, which the mock file doesn't allow.
+  MemoryFileSystem fs;
+  fs.Add("file", {0xe5, 0x8e, 0x26, 0x11, 0x7f, 0x22, 0x33});
+  state_ = std::make_shared<ParseState>(
+      std::make_shared<BufferedFileReader>(fs.Open("file")));
+  FileObjectInit init;
+  init.state = state_;
+  init.type = def;
+  auto obj = MakeFileObject(init);
+  ASSERT_TRUE(obj->ReparseObject(&errors_));
+  obj->ClearCache();
+  const uint64_t decoded = state_->stats()->fields_decoded;
+
+  std::vector<Value> values;
+  ASSERT_TRUE(obj->GetFieldValues({"d", "a", "missing", "b"}, &values,
+                                  &errors_));
+  EXPECT_EQ(values, (std::vector<Value>{Value{0x2233}, Value{624485u},
+                                        Value{}, Value{0x11}}));
+  EXPECT_EQ(state_->stats()->fields_decoded, decoded + 3);
+
+  // Cached values are reused.
+  EXPECT_EQ(obj->GetFieldValues(std::vector<FieldHandle>{
+                obj->ResolveField("c"), obj->ResolveField("b"), FieldHandle{}}),
+            (std::vector<Value>{Value{0x7fu}, Value{0x11}, Value{}}));
+  EXPECT_EQ(state_->stats()->fields_decoded, decoded + 4);
+  EXPECT_TRUE(obj->GetFieldValues(std::vector<std::string>{}).empty());
+}
+
+TEST_F(FileObjectTest, GetFieldValues_OneRead) {
+  // A child object makes a gap bigger than a positional reader reads at once.
+  std::vector<std::shared_ptr<Statement>> pad_fields;
+  for (size_t i = 0; i < BufferedFileReader::kPositionalReadSize / 8; i++) {
+    pad_fields.emplace_back(std::make_shared<FieldInfo>(
+        DebugInfo{}, "p" + std::to_string(i), MakeInt(64)));
+  }
+  auto pad = std::make_shared<TypeDefinition>(DebugInfo{}, "", pad_fields);
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", MakeInt(8)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "pad", pad),
+              std::make_shared<FieldInfo>(DebugInfo{}, "z", MakeInt(64)),
+          });
+
+  std::string data(1 + BufferedFileReader::kPositionalReadSize + 8, '\0');
+  data[0] = 0x11;
+  data[data.size() - 1] = 0x22;
+  auto file = std::make_shared<CountingFileReader>(data);
+  state_ = std::make_shared<ParseState>(
+      BufferedFileReader::CreatePositional(file));
+  FileObjectInit init;
+  init.state = state_;
+  init.type = def;
+  auto obj = MakeFileObject(init);
+  ASSERT_TRUE(obj->ReparseObject(&errors_));
+
+  // The batch is buffered through the end of the last field.
+  file->reads = 0;
+  std::vector<Value> values;
+  ASSERT_TRUE(obj->GetFieldValues(std::vector<std::string>{"a", "z"}, &values,
+                                  &errors_));
+  EXPECT_EQ(values, (std::vector<Value>{Value{0x11}, Value{0x22}}));
+  EXPECT_EQ(file->reads, 1);
+}
+
+TEST_F(FileObjectTest, SharedLayout) {
+  auto uleb = std::make_shared<VarintTypeInfo>(DebugInfo{}, "",
+                                               VarintEncoding::Leb128);
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", MakeInt(16)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", uleb),
+              std::make_shared<FieldInfo>(DebugInfo{}, "c", MakeInt(8)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", MakeInt(8)),
+          });
+  const TypeProgram& program = def->program();
+  ASSERT_EQ(program.fields().size(), 4u);
+  EXPECT_EQ(program.fields()[0].offset, Size{});
+  EXPECT_EQ(program.fields()[1].offset, Size::FromBytes(2));
+  EXPECT_FALSE(program.fields()[2].offset);
+  EXPECT_FALSE(program.fields()[3].offset);
+  EXPECT_EQ(program.dynamic_offset_count(), 2u);
+  EXPECT_EQ(program.FindField("a"), 3u);
+  EXPECT_FALSE(program.FindField("d"));
+}
+
+TEST_F(FileObjectTest, SharedLayout_DuplicateNames) {
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(
+                  DebugInfo{}, "a",
+                  std::make_shared<VarintTypeInfo>(DebugInfo{}, "",
+                                                   VarintEncoding::Leb128)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", MakeInt(8)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", MakeInt(8)),
+          });
+
+  auto obj = MakeObjectFromFile(def, {0x80, 0x01, 0x33, 0x44},
+                                /* eof= */ true);
+  ASSERT_TRUE(obj);
+  EXPECT_EQ(obj->GetFieldNames(), (std::vector<std::string>{"b", "a"}));
+  EXPECT_EQ(obj->GetFieldValue("a"), Value{0x44});
+  EXPECT_EQ(obj->GetFieldValue("b"), Value{0x33});
+}
+
+TEST_F(FileObjectTest, DuplicateNames_PartialLayout) {
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", MakeInt(8)),
+              std::make_shared<FieldInfo>(
+                  DebugInfo{}, "b",
+                  std::make_shared<VarintTypeInfo>(DebugInfo{}, "",
+                                                   VarintEncoding::Leb128)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", MakeInt(8)),
+          });
+
+  // The layout stops at "b", so the first "a" is the one that was declared.
+  MemoryFileSystem fs;
+  fs.Add("file", {0x11, 0x80});
+  state_ = std::make_shared<ParseState>(
+      std::make_shared<BufferedFileReader>(fs.Open("file")));
+  FileObjectInit init;
+  init.state = state_;
+  init.type = def;
+  auto obj = MakeFileObject(init);
+  ErrorCollection errors;
+  EXPECT_FALSE(obj->ReparseObject(&errors));
+  EXPECT_EQ(obj->GetFieldNames(), (std::vector<std::string>{"a", "b"}));
+  EXPECT_EQ(obj->GetFieldValue("a"), Value{0x11});
+}
+
+TEST_F(FileObjectTest, ForEachField) {
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "c", MakeInt(8)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", MakeInt(8)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "c", MakeInt(8)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", MakeInt(8)),
+          });
+
+  auto obj = MakeObjectFromFile(def, {0x11, 0x22, 0x33, 0x44});
+  ASSERT_TRUE(obj);
+  std::vector<std::pair<std::string, Value>> fields;
+  const auto visit = [&](const std::string& name, const Value& value) {
+    fields.emplace_back(name, value);
+  };
+  ASSERT_TRUE(obj->ForEachField(visit, &errors_));
+  EXPECT_EQ(fields, (std::vector<std::pair<std::string, Value>>{
+                        {"a", Value{0x22}},
+                        {"c", Value{0x33}},
+                        {"b", Value{0x44}},
+                    }));
+
+  fields.clear();
+  MakeObjectFromFields({{"x", Value{1}}, {"y", Value{2}}})->ForEachField(visit);
+  EXPECT_EQ(fields, (std::vector<std::pair<std::string, Value>>{
+                        {"x", Value{1}},
+                        {"y", Value{2}},
+                    }));
+}
+
+TEST_F(FileObjectTest, FieldHandle) {
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", MakeInt(8)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", MakeInt(8)),
+          });
+  auto other = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", MakeInt(8)),
+          });
+
+  auto obj1 = MakeObjectFromFile(def, {0x11, 0x22});
+  ASSERT_TRUE(obj1);
+  auto obj2 = MakeObjectFromFile(def, {0x33, 0x44});
+  ASSERT_TRUE(obj2);
+  auto obj3 = MakeObjectFromFile(other, {0x55});
+  ASSERT_TRUE(obj3);
+
+  const FieldHandle b = obj1->ResolveField("b");
+  ASSERT_TRUE(b.valid());
+  EXPECT_FALSE(obj1->ResolveField("c").valid());
+  EXPECT_TRUE(obj1->HasField(b));
+  EXPECT_EQ(obj1->GetFieldValue(b), Value{0x22});
+  EXPECT_EQ(obj2->GetFieldValue(b), Value{0x44});
+
+  // Handles from another type don't match any field.
+  EXPECT_FALSE(obj3->HasField(b));
+  EXPECT_EQ(obj3->GetFieldValue(b), Value{});
+  EXPECT_EQ(obj1->GetFieldValue(FieldHandle{}), Value{});
+  EXPECT_EQ(obj3->GetFieldValue(obj3->ResolveField("a")), Value{0x55});
+
+  // Uses of a type as a field share its layout, so handles work on them.
+  auto inst = std::static_pointer_cast<TypeDefinition>(
+      def->Instantiate(DebugInfo{}, Options{}));
+  EXPECT_EQ(&inst->program(), &def->program());
+  auto obj4 = MakeObjectFromFile(inst, {0x66, 0x77});
+  ASSERT_TRUE(obj4);
+  EXPECT_EQ(obj4->GetFieldValue(b), Value{0x77});
+}
+
+TEST_F(FileObjectTest, Arena) {
+  auto inner = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(
+                  DebugInfo{}, "s",
+                  std::make_shared<StringTypeInfo>(DebugInfo{}, "",
+                                                   CodecId::Utf8)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "x", MakeInt(8)),
+          });
+  auto outer = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", inner),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", MakeInt(8)),
+          });
+
+  use_arena_ = true;
+  auto obj = MakeObjectFromFile(outer, {'h', 'i', 0, 0x11, 0x22},
+                                /* eof= */ true);
+  ASSERT_TRUE(obj);
+  std::weak_ptr<Arena> arena = state_->arena();
+  ASSERT_TRUE(arena.lock());
+  EXPECT_GT(arena.lock()->bytes_allocated(), 0u);
+
+  auto a = obj->GetFieldValue("a").as_object();
+  ASSERT_TRUE(a);
+  EXPECT_EQ(a->GetFieldValue("x"), Value{0x11});
+  EXPECT_EQ(obj->GetFieldValue("b"), Value{0x22});
+
+  // Values and objects from the arena keep it alive after the root is gone.
+  Value s = a->GetFieldValue("s");
+  obj.reset();
+  state_.reset();
+  a.reset();
+  EXPECT_FALSE(arena.expired());
+  EXPECT_EQ(s, Value{UtfString::FromUtf8("hi")});
+  s = Value{};
+  EXPECT_TRUE(arena.expired());
+}
+
+TEST_F(FileObjectTest, CacheBudget) {
+  auto inner = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "x", MakeInt(8)),
+          });
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", inner),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", MakeInt(8)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "c", MakeInt(8)),
+          });
+
+  // Evicted values are read again, which the mock file doesn't allow.
+  MemoryFileSystem fs;
+  fs.Add("file", {0x11, 0x22, 0x33});
+  state_ = std::make_shared<ParseState>(
+      std::make_shared<BufferedFileReader>(fs.Open("file")));
+  // Room for about two number values, each stored with its cache entry.
+  state_->EnableValueCache(
+      2 * (sizeof(Value) + sizeof(ValueCache::Entry) + sizeof(uint64_t)));
+  ValueCache* cache = state_->value_cache();
+  FileObjectInit init;
+  init.state = state_;
+  init.type = def;
+  auto obj = MakeFileObject(init);
+  ASSERT_TRUE(obj->ReparseObject(&errors_));
+  EXPECT_LE(cache->size(), cache->budget());
+  const uint64_t decoded = state_->stats()->fields_decoded;
+
+  EXPECT_EQ(obj->GetFieldValue("b"), Value{0x22});
+  EXPECT_EQ(obj->GetFieldValue("c"), Value{0x33});
+  EXPECT_EQ(obj->GetFieldValue("b"), Value{0x22});
+  EXPECT_LE(cache->size(), cache->budget());
+
+  // The child object is too big to keep.
+  auto a = obj->GetFieldValue("a").as_object();
+  ASSERT_TRUE(a);
+  EXPECT_EQ(a->GetFieldValue("x"), Value{0x11});
+  EXPECT_NE(obj->GetFieldValue("a").as_object(), a);
+  EXPECT_GT(state_->stats()->fields_decoded, decoded);
+  EXPECT_GT(cache->evictions(), 0u);
+  EXPECT_LE(cache->size(), cache->budget());
+
+  obj.reset();
+  a.reset();
+  EXPECT_EQ(cache->size(), 0u);
+}
+
+TEST_F(FileObjectTest, CacheBudget_DeferredChild) {
+  auto inner = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "x", MakeInt(8)),
+          });
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", inner),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", MakeInt(8)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "c", MakeInt(8)),
+          });
+
+  MemoryFileSystem fs;
+  fs.Add("file", {0x11, 0x22, 0x33});
+  auto parse = [&](bool eager) {
+    state_ = std::make_shared<ParseState>(
+        std::make_shared<BufferedFileReader>(fs.Open("file")));
+    if (eager)
+      state_->EnableEagerDecode();
+    state_->EnableValueCache(1 << 20);
+    FileObjectInit init;
+    init.state = state_;
+    init.type = def;
+    auto obj = MakeFileObject(init);
+    EXPECT_TRUE(obj->ReparseObject(&errors_));
+    return obj;
+  };
+
+  // A deferred child is charged the same as one laid out when it was read,
+  // which also read its field and the parent's other fields.
+  auto obj = parse(false);
+  ASSERT_TRUE(obj->GetFieldValue("a").as_object());
+  const uint64_t child_size = state_->value_cache()->size();
+  EXPECT_EQ(obj->GetFieldValue("b"), Value{0x22});
+  const uint64_t number_size = state_->value_cache()->size() - child_size;
+
+  obj = parse(true);
+  EXPECT_EQ(state_->value_cache()->size(), child_size + 3 * number_size);
+}
+
+TEST_F(FileObjectTest, ConcurrentReads) {
+  auto uleb = std::make_shared<VarintTypeInfo>(DebugInfo{}, "",
+                                               VarintEncoding::Leb128);
+  auto inner = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "x", uleb),
+          });
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", inner),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", uleb),
+              std::make_shared<FieldInfo>(DebugInfo{}, "c", MakeInt(8)),
+          });
+
+  for (bool budget : {false, true}) {
+    MemoryFileSystem fs;
+    fs.Add("file", {0x80, 0x01, 0x05, 0x33});
+    state_ = std::make_shared<ParseState>(
+        std::make_shared<BufferedFileReader>(fs.Open("file")));
+    // Keep evicting values so the threads read them again.
+    if (budget)
+      state_->EnableValueCache(1);
+    FileObjectInit init;
+    init.state = state_;
+    init.type = def;
+    auto obj = MakeFileObject(init);
+    ASSERT_TRUE(obj->ReparseObject(&errors_));
+
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+      threads.emplace_back([&]() {
+        for (int j = 0; j < 200; j++) {
+          auto a = obj->GetFieldValue("a").as_object();
+          if (!a || a->GetFieldValue("x") != Value{0x80u} ||
+              obj->GetFieldValue("b") != Value{5u} ||
+              obj->GetFieldValue("c") != Value{0x33}) {
+            failures++;
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(failures, 0);
+  }
+}
+
+TEST_F(FileObjectTest, ConcurrentReads_SharedCaches) {
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(
+                  DebugInfo{}, "s",
+                  std::make_shared<StringTypeInfo>(DebugInfo{}, "",
+                                                   CodecId::Utf8)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "x", MakeInt(8)),
+          });
+
+  // Many objects with a few distinct strings, so the threads use every shard
+  // of the cache and the interner.
+  constexpr const size_t kCount = 32;
+  std::string data;
+  for (size_t i = 0; i < kCount; i++) {
+    data += {'s', static_cast<char>('a' + i % 8), 0, static_cast<char>(i)};
+  }
+  MemoryFileSystem fs;
+  fs.Add("file", data);
+  state_ = std::make_shared<ParseState>(
+      std::make_shared<BufferedFileReader>(fs.Open("file")));
+  state_->EnableValueCache(64);
+  state_->EnableStringInterning();
+  std::vector<std::shared_ptr<FileObject>> objects;
+  for (size_t i = 0; i < kCount; i++) {
+    FileObjectInit init;
+    init.state = state_;
+    init.type = def;
+    init.start_position = Size::FromBytes(i * 4);
+    objects.emplace_back(MakeFileObject(init));
+    ASSERT_TRUE(objects.back()->ReparseObject(&errors_));
+  }
+
+  std::atomic<int> failures{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t]() {
+      for (int j = 0; j < 50; j++) {
+        for (size_t i = 0; i < kCount; i++) {
+          const size_t index = (i + t * 8) % kCount;
+          const auto& obj = objects[index];
+          const Value s{UtfString::FromUtf8(
+              {'s', static_cast<char>('a' + index % 8)})};
+          if (obj->GetFieldValue("s") != s ||
+              obj->GetFieldValue("x") != Value{static_cast<uint64_t>(index)}) {
+            failures++;
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(failures, 0);
+  EXPECT_GT(state_->value_cache()->evictions(), 0u);
+  EXPECT_EQ(state_->interner()->stats().strings, 8u);
+  EXPECT_GT(state_->interner()->stats().hits, 0u);
+}
+
+TEST_F(FileObjectTest, ReparseInvalidatesChildren) {
+  auto leaf = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "x", MakeInt(8)),
+          });
+  auto inner = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "leaf", leaf),
+          });
+  auto outer = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "inner", inner),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", MakeInt(8)),
+          });
+
+  // Reparsing reads the file again, which the mock file doesn't allow.
+  MemoryFileSystem fs;
+  fs.Add("file", {0x11, 0x22});
+  state_ = std::make_shared<ParseState>(
+      std::make_shared<BufferedFileReader>(fs.Open("file")));
+  FileObjectInit init;
+  init.state = state_;
+  init.type = outer;
+  auto obj = MakeFileObject(init);
+  ASSERT_TRUE(obj->ReparseObject(&errors_));
+  auto child = obj->GetFieldValue("inner").as_object();
+  ASSERT_TRUE(child);
+  auto grandchild = child->GetFieldValue("leaf").as_object();
+  ASSERT_TRUE(grandchild);
+  EXPECT_TRUE(grandchild->valid());
+
+  // Reparsing the child only invalidates its own children.
+  ASSERT_TRUE(child->ReparseObject(&errors_));
+  EXPECT_TRUE(child->valid());
+  EXPECT_FALSE(grandchild->valid());
+  grandchild = child->GetFieldValue("leaf").as_object();
+  ASSERT_TRUE(grandchild);
+  EXPECT_TRUE(grandchild->valid());
+
+  ASSERT_TRUE(obj->ReparseObject(&errors_));
+  EXPECT_TRUE(obj->valid());
+  EXPECT_FALSE(child->valid());
+  EXPECT_FALSE(grandchild->valid());
+  EXPECT_FALSE(child->HasField("leaf"));
+  EXPECT_TRUE(child->GetFieldNames().empty());
+
+  Value value;
+  ErrorCollection errors;
+  EXPECT_FALSE(grandchild->GetFieldValue("x", &value, &errors));
+  ASSERT_EQ(errors.size(), 1u);
+  EXPECT_EQ(errors.errors()[0].kind, ErrorKind::StaleObject);
+  EXPECT_FALSE(child->ReparseObject(&errors));
+
+  auto new_child = obj->GetFieldValue("inner").as_object();
+  ASSERT_TRUE(new_child);
+  EXPECT_TRUE(new_child->valid());
+  EXPECT_EQ(new_child->GetFieldValue("leaf").as_object()->GetFieldValue("x"),
+            Value{0x11});
+}
+
+TEST_F(FileObjectTest, DeferredLayout) {
+  auto uleb = std::make_shared<VarintTypeInfo>(DebugInfo{}, "",
+                                               VarintEncoding::Leb128);
+  auto fixed = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "x", MakeInt(8)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "y", MakeInt(8)),
+          });
+  auto dynamic = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "z", uleb),
+          });
+  auto outer = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "fixed", fixed),
+              std::make_shared<FieldInfo>(DebugInfo{}, "dynamic", dynamic),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", MakeInt(8)),
+          });
+
+  MemoryFileSystem fs;
+  fs.Add("file", {0x11, 0x22, 0x85, 0x01, 0x33});
+  auto parse = [&](bool eager) {
+    state_ = std::make_shared<ParseState>(
+        std::make_shared<BufferedFileReader>(fs.Open("file")));
+    if (eager)
+      state_->EnableEagerDecode();
+    FileObjectInit init;
+    init.state = state_;
+    init.type = outer;
+    auto obj = MakeFileObject(init);
+    EXPECT_TRUE(obj->ReparseObject(&errors_));
+    return obj;
+  };
+
+  // Only the child that reads the file to find its end is laid out.
+  auto obj = parse(false);
+  EXPECT_EQ(obj->GetFieldValue("b"), Value{0x33});
+  EXPECT_EQ(state_->stats()->objects_laid_out, 2u);
+  auto child = obj->GetFieldValue("fixed").as_object();
+  ASSERT_TRUE(child);
+  EXPECT_EQ(state_->stats()->objects_laid_out, 2u);
+  // Fields can be resolved before the child is laid out.
+  const FieldHandle y = child->ResolveField("y");
+  EXPECT_TRUE(y.valid());
+  EXPECT_EQ(state_->stats()->objects_laid_out, 2u);
+  EXPECT_EQ(child->GetFieldValue(y), Value{0x22});
+  EXPECT_EQ(state_->stats()->objects_laid_out, 3u);
+  EXPECT_EQ(child->GetFieldValue("y"), Value{0x22});
+  EXPECT_EQ(child->GetFieldNames(), (std::vector<std::string>{"x", "y"}));
+  EXPECT_EQ(state_->stats()->objects_laid_out, 3u);
+
+  // Using a deferred child in any way lays it out first.
+  obj->ClearCache();
+  child = obj->GetFieldValue("fixed").as_object();
+  ASSERT_TRUE(child);
+  EXPECT_TRUE(child->HasField("x"));
+  EXPECT_EQ(state_->stats()->objects_laid_out, 4u);
+
+  // Eager decoding lays out every child up front.
+  obj = parse(true);
+  EXPECT_EQ(state_->stats()->objects_laid_out, 3u);
+  EXPECT_EQ(obj->GetFieldValue("fixed").as_object()->GetFieldValue("x"),
+            Value{0x11});
+  EXPECT_EQ(state_->stats()->objects_laid_out, 3u);
+}
+
+TEST_F(FileObjectTest, DeferredLayout_FirstUse) {
+  auto inner = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "x", MakeInt(8)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "y", MakeInt(8)),
+          });
+  auto outer = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "inner", inner),
+          });
+
+  MemoryFileSystem fs;
+  fs.Add("file", {0x11, 0x22});
+  fs.Add("short", {0x11});
+  auto parse = [&](const std::string& path) {
+    state_ = std::make_shared<ParseState>(
+        std::make_shared<BufferedFileReader>(fs.Open(path)));
+    FileObjectInit init;
+    init.state = state_;
+    init.type = outer;
+    auto obj = MakeFileObject(init);
+    EXPECT_TRUE(obj->ReparseObject(&errors_));
+    return obj;
+  };
+
+  // Threads using the child at once lay it out only once.
+  auto obj = parse("file");
+  auto child = obj->GetFieldValue("inner").as_object();
+  ASSERT_TRUE(child);
+  std::atomic<int> failures{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&]() {
+      if (child->GetFieldValue("y") != Value{0x22})
+        failures++;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(failures, 0);
+  EXPECT_EQ(state_->stats()->objects_laid_out, 2u);
+
+  // A failed layout isn't published, so each use tries again.  Reading
+  // eagerly makes laying out the child read its fields, which fails here.
+  obj = parse("short");
+  child = obj->GetFieldValue("inner").as_object();
+  ASSERT_TRUE(child);
+  state_->EnableEagerDecode();
+  Value value;
+  ErrorCollection errors;
+  EXPECT_FALSE(child->GetFieldValue("x", &value, &errors));
+  EXPECT_EQ(state_->stats()->objects_laid_out, 2u);
+  EXPECT_FALSE(child->GetFieldValue("x", &value, &errors));
+  EXPECT_EQ(state_->stats()->objects_laid_out, 3u);
+  ASSERT_EQ(errors.size(), 2u);
+  EXPECT_EQ(errors.errors()[1].kind, ErrorKind::UnexpectedEndOfStream);
+  EXPECT_FALSE(child->HasField("x"));
+}
+
+TEST_F(FileObjectTest, Checksum_Matches) {
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", MakeInt(32)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "b", MakeInt(8)),
+              std::make_shared<FieldInfo>(
+                  DebugInfo{}, "crc",
+                  std::make_shared<ChecksumTypeInfo>(
+                      DebugInfo{}, "", ChecksumAlgorithm::Crc32,
+                      ByteOrder::BigEndian, ChecksumRange::Object)),
+          });
+
+  // CRC-32 of "12345" is 0xcbf53a1c.
+  auto obj = MakeObjectFromFile(
+      def, {'1', '2', '3', '4', '5', 0xcb, 0xf5, 0x3a, 0x1c});
+  ASSERT_TRUE(obj);
+  EXPECT_EQ(obj->GetFieldValue("crc"), Value{0xcbf53a1cu});
+}
+
+TEST_F(FileObjectTest, Checksum_PreviousField) {
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(
+                  DebugInfo{}, "length", MakeInt(8),
+                  std::make_shared<Literal>(DebugInfo{}, Value{4})),
+              std::make_shared<FieldInfo>(DebugInfo{}, "data", MakeInt(32)),
+              std::make_shared<FieldInfo>(
+                  DebugInfo{}, "check",
+                  std::make_shared<ChecksumTypeInfo>(
+                      DebugInfo{}, "", ChecksumAlgorithm::Adler32,
+                      ByteOrder::LittleEndian, ChecksumRange::PreviousField)),
+          });
+
+  // Adler-32 of "abcd" is 0x03d8018b.
+  auto obj = MakeObjectFromFile(
+      def, {0x04, 'a', 'b', 'c', 'd', 0x8b, 0x01, 0xd8, 0x03});
+  ASSERT_TRUE(obj);
+  EXPECT_EQ(obj->GetFieldValue("check"), Value{0x03d8018bu});
+}
+
+TEST_F(FileObjectTest, Checksum_NoPreviousField) {
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(
+                  DebugInfo{}, "check",
+                  std::make_shared<ChecksumTypeInfo>(
+                      DebugInfo{}, "", ChecksumAlgorithm::Crc32,
+                      ByteOrder::BigEndian, ChecksumRange::PreviousField)),
+              std::make_shared<FieldInfo>(DebugInfo{}, "data", MakeInt(8)),
+          });
+
+  // This fails before anything is read, which the mock file doesn't allow.
+  MemoryFileSystem fs;
+  fs.Add("file", {0x00, 0x00, 0x00, 0x00, 0x11});
+  state_ = std::make_shared<ParseState>(
+      std::make_shared<BufferedFileReader>(fs.Open("file")));
+  FileObjectInit init;
+  init.state = state_;
+  init.type = def;
+  EXPECT_FALSE(MakeFileObject(init)->ReparseObject(&errors_));
+  ASSERT_EQ(errors_.size(), 1u);
+  EXPECT_EQ(errors_.begin()->kind, ErrorKind::ChecksumNoPreviousField);
+  EXPECT_EQ(errors_.begin()->offset, 0u);
+}
+
+TEST_F(FileObjectTest, Checksum_Mismatch) {
+  auto def = std::make_shared<TypeDefinition>(
+      DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+              std::make_shared<FieldInfo>(DebugInfo{}, "a", MakeInt(8)),
+              std::make_shared<FieldInfo>(
+                  DebugInfo{}, "crc",
+                  std::make_shared<ChecksumTypeInfo>(
+                      DebugInfo{}, "", ChecksumAlgorithm::Crc32c,
+                      ByteOrder::BigEndian, ChecksumRange::Object)),
+          });
+
+  EXPECT_FALSE(MakeObjectFromFile(def, {0x00, 0x12, 0x34, 0x56, 0x78}));
+  ASSERT_EQ(errors_.size(), 1u);
+  EXPECT_EQ(errors_.begin()->kind, ErrorKind::ChecksumMismatch);
+  EXPECT_EQ(errors_.begin()->offset, 1u);
 }
 
 }  // namespace binary_reader
@@ -39,6 +39,63 @@ TEST(FileParserIntegration, BasicFlow) {
   EXPECT_EQ(bin->GetFieldValue("c"), Value{});
 }
 
+TEST(FileParserIntegration, ResolveField) {
+  auto fs = std::make_shared<MemoryFileSystem>();
+  fs->Add("file.def", R"(
+type Vec {
+  int8 x;
+  int16 y;
+}
+type Main {
+  Vec a;
+  uint8 b;
+})");
+  fs->Add("file.bin", {0x11, 0x22, 0x33, 0x44});
+
+  FileParserOptions opts;
+  opts.file_system = fs;
+  auto parser = FileParser::CreateFromFile("file.def", opts);
+  ASSERT_TRUE(parser);
+  const FieldHandle y = parser->ResolveField("Vec", "y");
+  const FieldHandle b = parser->ResolveField("Main", "b");
+  ASSERT_TRUE(y.valid());
+  ASSERT_TRUE(b.valid());
+  EXPECT_FALSE(parser->ResolveField("Vec", "z").valid());
+  EXPECT_FALSE(parser->ResolveField("Foo", "x").valid());
+
+  auto main = parser->ParseFile("file.bin");
+  ASSERT_TRUE(main);
+  EXPECT_EQ(main->GetFieldValue(b), Value{0x44});
+  EXPECT_EQ(main->GetFieldValue(y), Value{});
+  auto a = main->GetFieldValue("a").as_object();
+  ASSERT_TRUE(a);
+  EXPECT_EQ(a->GetFieldValue(y), Value{0x2233});
+}
+
+TEST(FileParserIntegration, ParseRecords) {
+  auto fs = std::make_shared<MemoryFileSystem>();
+  fs->Add("file.def", R"(
+type Record {
+  uint8 id;
+  int16 value;
+})");
+  fs->Add("file.bin", {0x01, 0x00, 0x10, 0x02, 0x00, 0x20});
+
+  FileParserOptions opts;
+  opts.file_system = fs;
+  auto parser = FileParser::CreateFromFile("file.def", opts);
+  ASSERT_TRUE(parser);
+  EXPECT_FALSE(parser->ParseRecords("file.bin", "Foo"));
+
+  auto cursor = parser->ParseRecords("file.bin", "Record");
+  ASSERT_TRUE(cursor);
+  std::vector<Value> values;
+  while (cursor->Next()) {
+    values.emplace_back(cursor->record()->GetFieldValue("value"));
+  }
+  EXPECT_EQ(values, (std::vector<Value>{Value{0x10}, Value{0x20}}));
+}
+
 TEST(FileParserIntegration, Errors) {
   auto fs = std::make_shared<MemoryFileSystem>();
   fs->Add("file.def", "type foo { int16 a; int32 b;");
@@ -271,6 +271,42 @@ TEST_F(FileSystemTest, Default_Seek) {
   EXPECT_EQ(memcmp("ten", buffer, 3), 0);
 }
 
+TEST_F(FileSystemTest, ReadAt_Unsupported) {
+  MockFileReader reader;
+  EXPECT_FALSE(reader.can_read_at());
+
+  uint8_t buffer[4];
+  size_t read = sizeof(buffer);
+  ErrorCollection errors;
+  EXPECT_FALSE(reader.ReadAt(0, buffer, &read, &errors));
+  EXPECT_TRUE(errors.has_errors());
+}
+
+TEST_F(FileSystemTest, Default_ReadAt) {
+  const uint8_t expected[] = "contents";
+  MakeFile("file.def", expected);
+
+  auto system = FileSystem::DefaultFileSystem();
+  ASSERT_TRUE(system);
+  auto reader = system->Open("file.def");
+  ASSERT_TRUE(reader);
+  if (!reader->can_read_at())
+    return;
+
+  uint8_t buffer[3];
+  size_t read = sizeof(buffer);
+  ErrorCollection errors;
+  ASSERT_TRUE(reader->ReadAt(3, buffer, &read, &errors));
+  ASSERT_EQ(read, 3);
+  EXPECT_EQ(memcmp("ten", buffer, 3), 0);
+  // The current position isn't used or changed.
+  EXPECT_EQ(reader->position(), 0u);
+
+  read = sizeof(buffer);
+  ASSERT_TRUE(reader->ReadAt(sizeof(expected), buffer, &read, &errors));
+  EXPECT_EQ(read, 0);
+}
+
 TEST_F(FileSystemTest, Default_NotExist) {
   auto system = FileSystem::DefaultFileSystem();
   EXPECT_FALSE(system->Open("foo.def"));
@@ -50,6 +50,46 @@ TEST_F(OptionsTest, ParseOption_Success) {
             Options::ParseResult::Success);
   EXPECT_EQ(type, OptionType::ByteOrder);
   EXPECT_EQ(std::any_cast<ByteOrder>(result), ByteOrder::BigEndian);
+
+  ASSERT_EQ(Options::ParseOption({}, MakeVal("previous"), &type, &result),
+            Options::ParseResult::Success);
+  EXPECT_EQ(type, OptionType::ChecksumRange);
+  EXPECT_EQ(std::any_cast<ChecksumRange>(result),
+            ChecksumRange::PreviousField);
+}
+
+TEST_F(OptionsTest, GetOption_Impl) {
+  Options options;
+  EXPECT_EQ(options.GetOption<ChecksumRange>(ChecksumRange::Object),
+            ChecksumRange::Object);
+  ASSERT_TRUE(options.SetOption(OptionType::ChecksumRange,
+                                ChecksumRange::PreviousField));
+  EXPECT_EQ(options.GetOption<ChecksumRange>(ChecksumRange::Object),
+            ChecksumRange::PreviousField);
+  EXPECT_EQ(std::any_cast<ChecksumRange>(
+                Options::DefaultOptions.GetOption(OptionType::ChecksumRange)),
+            ChecksumRange::Object);
+}
+
+TEST_F(OptionsTest, ParseOption_Encoding) {
+  OptionType type;
+  std::any result;
+  ASSERT_EQ(Options::ParseOption({}, MakeVal("sjis"), &type, &result),
+            Options::ParseResult::Success);
+  EXPECT_EQ(type, OptionType::Encoding);
+  EXPECT_EQ(std::any_cast<CodecId>(result), CodecId::ShiftJis);
+
+  ASSERT_EQ(Options::ParseOption({OptionType::ByteOrder}, MakeVal("utf8"),
+                                 &type, &result),
+            Options::ParseResult::UnknownString);
+
+  Options options;
+  EXPECT_EQ(options.GetOption<CodecId>(CodecId::Latin1), CodecId::Latin1);
+  ASSERT_TRUE(options.SetOption(OptionType::Encoding, CodecId::Gb18030));
+  EXPECT_EQ(options.GetOption<CodecId>(CodecId::Latin1), CodecId::Gb18030);
+  EXPECT_EQ(std::any_cast<CodecId>(
+                Options::DefaultOptions.GetOption(OptionType::Encoding)),
+            CodecId::Utf8);
 }
 
 TEST_F(OptionsTest, ParseOption_Filter) {
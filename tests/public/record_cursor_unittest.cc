@@ -0,0 +1,104 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "binary_reader/record_cursor.h"
+
+#include "ast/field_info.h"
+#include "gtest_wrapper.h"
+#include "public/file_object_init.h"
+#include "util/memory_file_system.h"
+
+namespace binary_reader {
+
+class RecordCursorTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    type_ = std::make_shared<TypeDefinition>(
+        DebugInfo{}, "", std::vector<std::shared_ptr<Statement>>{
+                std::make_shared<FieldInfo>(
+                    DebugInfo{}, "a",
+                    std::make_shared<IntegerTypeInfo>(
+                        DebugInfo{}, "", Size::FromBits(8),
+                        Signedness::Unsigned, ByteOrder::BigEndian)),
+                std::make_shared<FieldInfo>(
+                    DebugInfo{}, "b",
+                    std::make_shared<VarintTypeInfo>(DebugInfo{}, "",
+                                                     VarintEncoding::Leb128)),
+            });
+  }
+
+  std::unique_ptr<RecordCursor> MakeCursor(
+      std::initializer_list<uint8_t> data) {
+    fs_.Add("file", data);
+    RecordCursorInit init;
+    state_ = std::make_shared<ParseState>(
+        std::make_shared<BufferedFileReader>(fs_.Open("file")));
+    init.state = state_;
+    init.type = type_;
+    return MakeRecordCursor(init);
+  }
+
+  MemoryFileSystem fs_;
+  std::shared_ptr<TypeDefinition> type_;
+  std::shared_ptr<ParseState> state_;
+  ErrorCollection errors_;
+};
+
+TEST_F(RecordCursorTest, ReusesObject) {
+  auto cursor = MakeCursor({0x01, 0x80, 0x01, 0x02, 0x03, 0x04, 0x05});
+  EXPECT_FALSE(cursor->record());
+
+  std::vector<Value> values;
+  const FileObject* first = nullptr;
+  while (cursor->Next(&errors_)) {
+    if (!first)
+      first = cursor->record().get();
+    EXPECT_EQ(cursor->record().get(), first);
+    values.emplace_back(cursor->record()->GetFieldValue("a"));
+    values.emplace_back(cursor->record()->GetFieldValue("b"));
+  }
+  EXPECT_FALSE(errors_.has_errors());
+  EXPECT_FALSE(cursor->record());
+  EXPECT_FALSE(cursor->Next(&errors_));
+  EXPECT_EQ(values, (std::vector<Value>{Value{1}, Value{0x80u}, Value{2},
+                                        Value{3u}, Value{4}, Value{5u}}));
+  EXPECT_EQ(state_->stats()->objects_created, 1u);
+}
+
+TEST_F(RecordCursorTest, KeptRecordsStayValid) {
+  auto cursor = MakeCursor({0x01, 0x02, 0x03, 0x04});
+  ASSERT_TRUE(cursor->Next(&errors_));
+  std::shared_ptr<FileObject> kept = cursor->record();
+  ASSERT_TRUE(cursor->Next(&errors_));
+  EXPECT_NE(cursor->record(), kept);
+  EXPECT_EQ(kept->GetFieldValue("a"), Value{1});
+  EXPECT_EQ(cursor->record()->GetFieldValue("a"), Value{3});
+  EXPECT_EQ(state_->stats()->objects_created, 2u);
+}
+
+TEST_F(RecordCursorTest, Empty) {
+  auto cursor = MakeCursor({});
+  EXPECT_FALSE(cursor->Next(&errors_));
+  EXPECT_FALSE(errors_.has_errors());
+}
+
+TEST_F(RecordCursorTest, Truncated) {
+  auto cursor = MakeCursor({0x01, 0x02, 0x03});
+  ASSERT_TRUE(cursor->Next(&errors_));
+  EXPECT_FALSE(cursor->Next(&errors_));
+  EXPECT_TRUE(errors_.has_errors());
+  EXPECT_FALSE(cursor->record());
+}
+
+}  // namespace binary_reader
@@ -0,0 +1,67 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "binary_reader/utf_string.h"
+
+#include <functional>
+
+#include "gtest_wrapper.h"
+
+namespace binary_reader {
+
+TEST(UtfStringTest, Utf8RoundTrip) {
+  const std::string str = "a\xc2\xa3" "b\xe2\x82\xac" "c\xf0\x90\x90\xb7";
+  const UtfString utf = UtfString::FromUtf8(str);
+  EXPECT_EQ(utf.AsUtf8(), str);
+  EXPECT_EQ(utf.AsUtf16(), u"a£b€c\U00010437");
+}
+
+TEST(UtfStringTest, Utf16RoundTrip) {
+  const std::u16string str = u"a£b€c\U00010437";
+  const UtfString utf{str};
+  EXPECT_EQ(utf.AsUtf16(), str);
+  EXPECT_EQ(utf.AsUtf8(), "a\xc2\xa3" "b\xe2\x82\xac" "c\xf0\x90\x90\xb7");
+}
+
+TEST(UtfStringTest, InvalidUtf8UsesDecoder) {
+  // An encoded surrogate isn't well-formed, but the decoder passes it along.
+  const UtfString utf = UtfString::FromUtf8("a\xed\xa0\x81");
+  EXPECT_EQ(utf.AsUtf16(), std::u16string(u"a") + char16_t{0xd801});
+
+  EXPECT_TRUE(UtfString::FromUtf8("a\xff").empty());
+}
+
+TEST(UtfStringTest, CompareAcrossEncodings) {
+  const UtfString a8 = UtfString::FromUtf8("a\xe2\x82\xac");
+  const UtfString a16{u"a€"};
+  EXPECT_EQ(a8, a16);
+  EXPECT_EQ(a16, a8);
+  EXPECT_EQ(std::hash<UtfString>()(a8), std::hash<UtfString>()(a16));
+  EXPECT_NE(a8, UtfString{u"a"});
+  EXPECT_NE(UtfString{u"a"}, a8);
+
+  // Strings compare by code point, so U+10437 sorts after U+FF00 in both
+  // forms even though its UTF-16 code units are smaller.
+  const UtfString high8 = UtfString::FromUtf8("\xf0\x90\x90\xb7");
+  const UtfString high16{u"\U00010437"};
+  const UtfString bmp8 = UtfString::FromUtf8("\xef\xbc\x80");
+  const UtfString bmp16{u"＀"};
+  EXPECT_LT(bmp8, high8);
+  EXPECT_LT(bmp16, high16);
+  EXPECT_LT(bmp8, high16);
+  EXPECT_LT(bmp16, high8);
+  EXPECT_GT(high16, bmp8);
+}
+
+}  // namespace binary_reader
@@ -0,0 +1,112 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "binary_reader/value.h"
+
+#include <type_traits>
+#include <utility>
+
+#include "gtest_wrapper.h"
+
+namespace binary_reader {
+
+static_assert(sizeof(Value) == 16, "Value is a 16-byte cell");
+static_assert(std::is_trivially_copyable_v<Number>,
+              "Number is trivially copyable");
+static_assert(std::is_same_v<decltype(Value{}.as_string()), UtfString>,
+              "A temporary Value returns a copy of its string");
+static_assert(
+    std::is_same_v<decltype(std::declval<const Value&>().as_string()),
+                   const UtfString&>,
+    "A Value returns a reference to its string");
+
+TEST(ValueTest, Numbers) {
+  Value v{12};
+  ASSERT_EQ(v.value_type(), ValueType::Number);
+  EXPECT_EQ(v.as_number(), Number{12});
+  EXPECT_FALSE(v.as_number().is_negative());
+
+  v = -5ll;
+  ASSERT_EQ(v.value_type(), ValueType::Number);
+  EXPECT_TRUE(v.as_number().is_negative());
+  EXPECT_EQ(v.as_number().as_signed(), -5);
+
+  v = 2.5;
+  ASSERT_EQ(v.value_type(), ValueType::Number);
+  EXPECT_TRUE(v.as_number().is_double());
+  EXPECT_EQ(v.as_number().as_double(), 2.5);
+
+  v = nullptr;
+  EXPECT_EQ(v.value_type(), ValueType::Null);
+}
+
+TEST(ValueTest, Strings) {
+  Value v{UtfString(u"foobar")};
+  ASSERT_EQ(v.value_type(), ValueType::String);
+  EXPECT_EQ(v.as_string().AsUtf16(), u"foobar");
+
+  Value copy = v;
+  EXPECT_EQ(&copy.as_string(), &v.as_string());
+  v = 4;
+  EXPECT_EQ(copy.as_string().AsUtf16(), u"foobar");
+
+  Value moved = std::move(copy);
+  EXPECT_EQ(moved.as_string().AsUtf16(), u"foobar");
+  EXPECT_EQ(copy.value_type(), ValueType::Null);
+
+  const Value& alias = moved;
+  moved = alias;
+  EXPECT_EQ(moved.as_string().AsUtf16(), u"foobar");
+
+  // A temporary's string outlives it.
+  const auto& temp = Value{UtfString(u"temp")}.as_string();
+  EXPECT_EQ(temp.AsUtf16(), u"temp");
+}
+
+TEST(ValueTest, Compare) {
+  EXPECT_EQ(Value{}, Value{});
+  EXPECT_EQ(Value{1}, Value{1.0});
+  EXPECT_NE(Value{1}, Value{2});
+  EXPECT_EQ(Value{UtfString(u"a")}, Value{UtfString(u"a")});
+  EXPECT_NE(Value{UtfString(u"a")}, Value{1});
+
+  // Values are ordered by type first.
+  EXPECT_LT(Value{}, Value{-3});
+  EXPECT_LT(Value{-3}, Value{2});
+  EXPECT_LT(Value{2}, Value{UtfString(u"a")});
+  EXPECT_LT(Value{UtfString(u"a")}, Value{UtfString(u"b")});
+  EXPECT_GE(Value{UtfString(u"b")}, Value{UtfString(u"a")});
+}
+
+TEST(ValueTest, Hash) {
+  EXPECT_EQ(Value{1}.hash(), Value{1.0}.hash());
+  EXPECT_EQ(Value{-2}.hash(), Value{-2.0}.hash());
+
+  // Strings hash the same however they are stored, and copies share the
+  // computed hash.
+  const Value str{UtfString::FromUtf8("abc")};
+  const Value copy = str;
+  EXPECT_EQ(str.hash(), Value{UtfString(u"abc")}.hash());
+  EXPECT_EQ(copy.hash(), str.hash());
+  EXPECT_EQ(copy, str);
+  EXPECT_NE(str, Value{UtfString(u"abd")});
+}
+
+TEST(ValueTest, WrongTypeThrows) {
+  EXPECT_THROW(Value{}.as_number(), std::bad_variant_access);
+  EXPECT_THROW(Value{1}.as_string(), std::bad_variant_access);
+  EXPECT_THROW(Value{1}.as_object(), std::bad_variant_access);
+}
+
+}  // namespace binary_reader
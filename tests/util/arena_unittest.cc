@@ -0,0 +1,59 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/arena.h"
+
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+namespace binary_reader {
+
+TEST(ArenaTest, Allocate) {
+  Arena arena;
+  void* a = arena.allocate(3, 1);
+  void* b = arena.allocate(16, 8);
+  EXPECT_NE(a, b);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 8, 0u);
+  EXPECT_EQ(arena.bytes_allocated(), 19u);
+
+  // Freeing doesn't return the memory.
+  arena.deallocate(b, 16, 8);
+  EXPECT_NE(arena.allocate(16, 8), b);
+  EXPECT_EQ(arena.bytes_allocated(), 35u);
+}
+
+TEST(ArenaTest, Allocator_KeepsArenaAlive) {
+  auto arena = std::make_shared<Arena>();
+  std::weak_ptr<Arena> weak = arena;
+  std::shared_ptr<int> value =
+      std::allocate_shared<int>(ArenaAllocator<int>{arena}, 5);
+  arena.reset();
+  EXPECT_FALSE(weak.expired());
+  EXPECT_EQ(*value, 5);
+
+  value.reset();
+  EXPECT_TRUE(weak.expired());
+}
+
+TEST(ArenaTest, Allocator_Container) {
+  auto arena = std::make_shared<Arena>();
+  std::vector<int, ArenaAllocator<int>> values{ArenaAllocator<int>{arena}};
+  for (int i = 0; i < 1000; i++)
+    values.push_back(i);
+  EXPECT_EQ(values[999], 999);
+  EXPECT_GE(arena->bytes_allocated(), 1000 * sizeof(int));
+}
+
+}  // namespace binary_reader
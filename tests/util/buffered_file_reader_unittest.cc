@@ -14,8 +14,12 @@
 
 #include "util/buffered_file_reader.h"
 
+#include <memory>
+#include <string>
+
 #include "gtest_wrapper.h"
 #include "mocks.h"
+#include "util/memory_file_system.h"
 
 namespace binary_reader {
 
@@ -100,4 +104,48 @@ TEST(BufferedFileReaderTest, UnbufferedSeek) {
   EXPECT_EQ(memcmp(second_buffer, actual, sizeof(second_buffer)), 0);
 }
 
+TEST(BufferedFileReaderTest, Positional) {
+  auto file = std::make_shared<MemoryFileReader>(std::string{"abcdefghij"});
+  auto reader = BufferedFileReader::CreatePositional(file);
+  const uint8_t* actual;
+  size_t actual_size;
+  ErrorCollection errors;
+  ASSERT_TRUE(reader->Seek(Size::FromBytes(4), &errors));
+  ASSERT_TRUE(reader->EnsureBuffer(Size::FromBytes(3), &errors));
+  ASSERT_TRUE(reader->GetBuffer(&actual, &actual_size, &errors));
+  EXPECT_EQ(std::string(actual, actual + actual_size), "efghij");
+
+  // The file's own position isn't used.
+  EXPECT_EQ(file->position(), 0u);
+  ASSERT_TRUE(reader->Seek(Size::FromBytes(1), &errors));
+  ASSERT_TRUE(reader->GetBuffer(&actual, &actual_size, &errors));
+  EXPECT_EQ(std::string(actual, actual + actual_size), "bcdefghij");
+}
+
+TEST(BufferedFileReaderTest, Positional_GrowsBuffer) {
+  constexpr const size_t kReadSize = BufferedFileReader::kPositionalReadSize;
+  std::string data(3 * kReadSize, '\0');
+  for (size_t i = 0; i < data.size(); i++)
+    data[i] = static_cast<char>(i * 7);
+  auto reader = BufferedFileReader::CreatePositional(
+      std::make_shared<MemoryFileReader>(data));
+  EXPECT_EQ(reader->capacity(), kReadSize);
+
+  const uint8_t* actual;
+  size_t actual_size;
+  ErrorCollection errors;
+  ASSERT_TRUE(reader->Seek(Size::FromBytes(10), &errors));
+  ASSERT_TRUE(reader->EnsureBuffer(Size::FromBytes(100), &errors));
+  EXPECT_EQ(reader->capacity(), kReadSize);
+
+  // Reads bigger than the buffer grow it, keeping what was already read.
+  ASSERT_TRUE(reader->EnsureBuffer(Size::FromBytes(2 * kReadSize), &errors));
+  EXPECT_GT(reader->capacity(), 2 * kReadSize);
+  EXPECT_LT(reader->capacity(), BufferedFileReader::kBufferSize);
+  ASSERT_TRUE(reader->GetBuffer(&actual, &actual_size, &errors));
+  ASSERT_GE(actual_size, 2 * kReadSize);
+  EXPECT_EQ(std::string(actual, actual + 2 * kReadSize),
+            data.substr(10, 2 * kReadSize));
+}
+
 }  // namespace binary_reader
@@ -0,0 +1,107 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/checksum.h"
+
+#include <cstring>
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+namespace binary_reader {
+
+namespace {
+
+const uint8_t kCheck[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+uint32_t BitwiseCrc(uint32_t polynomial, const uint8_t* data, size_t size) {
+  uint32_t crc = ~0u;
+  for (size_t i = 0; i < size; i++) {
+    crc ^= data[i];
+    for (int j = 0; j < 8; j++)
+      crc = (crc >> 1) ^ ((crc & 1) ? polynomial : 0);
+  }
+  return ~crc;
+}
+
+std::vector<uint8_t> MakeData(size_t size) {
+  std::vector<uint8_t> ret(size);
+  uint32_t seed = 12345;
+  for (auto& b : ret) {
+    seed = seed * 1103515245 + 12345;
+    b = static_cast<uint8_t>(seed >> 16);
+  }
+  return ret;
+}
+
+}  // namespace
+
+TEST(ChecksumTest, Crc32) {
+  EXPECT_EQ(Crc32(kCheck, sizeof(kCheck)), 0xcbf43926u);
+  EXPECT_EQ(Crc32(nullptr, 0), 0u);
+
+  // Cover the vector kernel with every tail size.
+  const auto data = MakeData(1000);
+  for (size_t size = 0; size < 300; size++) {
+    ASSERT_EQ(Crc32(data.data() + 1, size),
+              BitwiseCrc(0xedb88320, data.data() + 1, size))
+        << "size=" << size;
+  }
+  EXPECT_EQ(Crc32(data.data(), data.size()),
+            BitwiseCrc(0xedb88320, data.data(), data.size()));
+}
+
+TEST(ChecksumTest, Crc32c) {
+  EXPECT_EQ(Crc32c(kCheck, sizeof(kCheck)), 0xe3069283u);
+
+  const auto data = MakeData(300);
+  for (size_t size = 0; size < data.size(); size++) {
+    ASSERT_EQ(Crc32c(data.data(), size),
+              BitwiseCrc(0x82f63b78, data.data(), size))
+        << "size=" << size;
+  }
+}
+
+TEST(ChecksumTest, Incremental) {
+  const auto data = MakeData(500);
+  const uint32_t crc = Crc32(data.data(), 123);
+  EXPECT_EQ(Crc32(data.data() + 123, data.size() - 123, crc),
+            Crc32(data.data(), data.size()));
+  const uint32_t crc_c = Crc32c(data.data(), 7);
+  EXPECT_EQ(Crc32c(data.data() + 7, data.size() - 7, crc_c),
+            Crc32c(data.data(), data.size()));
+  const uint32_t adler = Adler32(data.data(), 99);
+  EXPECT_EQ(Adler32(data.data() + 99, data.size() - 99, adler),
+            Adler32(data.data(), data.size()));
+}
+
+TEST(ChecksumTest, Adler32) {
+  const char kWikipedia[] = "Wikipedia";
+  EXPECT_EQ(Adler32(reinterpret_cast<const uint8_t*>(kWikipedia),
+                    strlen(kWikipedia)),
+            0x11e60398u);
+  EXPECT_EQ(Adler32(nullptr, 0), 1u);
+
+  // Make sure the sums don't overflow for long runs of large bytes.
+  const std::vector<uint8_t> data(100000, 0xff);
+  uint32_t a = 1;
+  uint32_t b = 0;
+  for (uint8_t byte : data) {
+    a = (a + byte) % 65521;
+    b = (b + a) % 65521;
+  }
+  EXPECT_EQ(Adler32(data.data(), data.size()), (b << 16) | a);
+}
+
+}  // namespace binary_reader
@@ -0,0 +1,60 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/code_units.h"
+
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+namespace binary_reader {
+
+TEST(CodeUnitsTest, Latin1) {
+  // Long enough to use the SIMD paths with a scalar tail.
+  std::vector<uint8_t> bytes;
+  for (int i = 0; i < 300; i++)
+    bytes.push_back(static_cast<uint8_t>(i * 7));
+
+  std::vector<char16_t> wide(bytes.size());
+  WidenLatin1(bytes.data(), bytes.size(), wide.data());
+  for (size_t i = 0; i < bytes.size(); i++)
+    ASSERT_EQ(wide[i], bytes[i]) << i;
+
+  std::vector<uint8_t> narrow(bytes.size());
+  EXPECT_EQ(NarrowLatin1(wide.data(), wide.size(), narrow.data()),
+            wide.size());
+  EXPECT_EQ(narrow, bytes);
+
+  wide[37] = 0x100;
+  EXPECT_EQ(NarrowLatin1(wide.data(), wide.size(), narrow.data()), 37u);
+}
+
+TEST(CodeUnitsTest, Utf16) {
+  std::vector<char16_t> units;
+  for (int i = 0; i < 100; i++)
+    units.push_back(static_cast<char16_t>(0x1234 + i * 0x101));
+
+  for (bool big_endian : {false, true}) {
+    std::vector<uint8_t> bytes(units.size() * 2);
+    StoreUtf16(units.data(), units.size(), big_endian, bytes.data());
+    EXPECT_EQ(bytes[0], big_endian ? 0x12 : 0x34);
+    EXPECT_EQ(bytes[1], big_endian ? 0x34 : 0x12);
+
+    std::vector<char16_t> loaded(units.size());
+    LoadUtf16(bytes.data(), units.size(), big_endian, loaded.data());
+    EXPECT_EQ(loaded, units);
+  }
+}
+
+}  // namespace binary_reader
@@ -0,0 +1,87 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/float_conversion.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+namespace binary_reader {
+
+TEST(FloatConversionTest, Float16ToDouble) {
+  EXPECT_EQ(Float16ToDouble(0x0000), 0.0);
+  EXPECT_TRUE(std::signbit(Float16ToDouble(0x8000)));
+  EXPECT_EQ(Float16ToDouble(0x3c00), 1.0);
+  EXPECT_EQ(Float16ToDouble(0xc000), -2.0);
+  EXPECT_EQ(Float16ToDouble(0x7bff), 65504.0);
+  // Smallest subnormal and largest subnormal.
+  EXPECT_EQ(Float16ToDouble(0x0001), std::ldexp(1.0, -24));
+  EXPECT_EQ(Float16ToDouble(0x03ff), std::ldexp(1023.0, -24));
+  EXPECT_EQ(Float16ToDouble(0x7c00), std::numeric_limits<double>::infinity());
+  EXPECT_EQ(Float16ToDouble(0xfc00), -std::numeric_limits<double>::infinity());
+  EXPECT_TRUE(std::isnan(Float16ToDouble(0x7e00)));
+}
+
+TEST(FloatConversionTest, Float16Array) {
+  // Use enough elements to cover both the vector kernel and the tail.
+  std::vector<uint8_t> big;
+  std::vector<uint8_t> little;
+  std::vector<double> expected;
+  for (uint32_t i = 0; i < 37; i++) {
+    // Skip NaN since they don't compare equal.
+    const uint16_t bits = static_cast<uint16_t>(i * 1723);
+    if ((bits & 0x7c00) == 0x7c00 && (bits & 0x3ff) != 0)
+      continue;
+    big.push_back(static_cast<uint8_t>(bits >> 8));
+    big.push_back(static_cast<uint8_t>(bits));
+    little.push_back(static_cast<uint8_t>(bits));
+    little.push_back(static_cast<uint8_t>(bits >> 8));
+    expected.push_back(Float16ToDouble(bits));
+  }
+
+  std::vector<double> actual(expected.size());
+  DecodeFloat16Array(big.data(), actual.size(), ByteOrder::BigEndian,
+                     actual.data());
+  EXPECT_EQ(actual, expected);
+  DecodeFloat16Array(little.data(), actual.size(), ByteOrder::LittleEndian,
+                     actual.data());
+  EXPECT_EQ(actual, expected);
+}
+
+TEST(FloatConversionTest, Float32Array) {
+  const uint8_t big[] = {0x3f, 0x80, 0x00, 0x00, 0xc1, 0x20, 0x00, 0x00};
+  const uint8_t little[] = {0x00, 0x00, 0x80, 0x3f, 0x00, 0x00, 0x20, 0xc1};
+  double actual[2];
+  DecodeFloat32Array(big, 2, ByteOrder::BigEndian, actual);
+  EXPECT_EQ(actual[0], 1.0);
+  EXPECT_EQ(actual[1], -10.0);
+  DecodeFloat32Array(little, 2, ByteOrder::LittleEndian, actual);
+  EXPECT_EQ(actual[0], 1.0);
+  EXPECT_EQ(actual[1], -10.0);
+}
+
+TEST(FloatConversionTest, Float64Array) {
+  const uint8_t big[] = {0x3f, 0xb9, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a};
+  const uint8_t little[] = {0x9a, 0x99, 0x99, 0x99, 0x99, 0x99, 0xb9, 0x3f};
+  double actual;
+  DecodeFloat64Array(big, 1, ByteOrder::BigEndian, &actual);
+  EXPECT_EQ(actual, 0.1);
+  DecodeFloat64Array(little, 1, ByteOrder::LittleEndian, &actual);
+  EXPECT_EQ(actual, 0.1);
+}
+
+}  // namespace binary_reader
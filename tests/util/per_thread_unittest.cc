@@ -0,0 +1,119 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/per_thread.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+namespace binary_reader {
+
+TEST(PerThreadTest, InstancePerThread) {
+  PerThread<int> per_thread;
+  int created = 0;
+  auto create = [&]() {
+    return std::make_unique<int>(++created);
+  };
+
+  int* main_instance = per_thread.Get(create);
+  EXPECT_EQ(*main_instance, 1);
+  EXPECT_EQ(per_thread.Get(create), main_instance);
+
+  int* other_instance = nullptr;
+  std::thread thread([&]() {
+    other_instance = per_thread.Get(create);
+  });
+  thread.join();
+  EXPECT_NE(other_instance, main_instance);
+  EXPECT_EQ(*other_instance, 2);
+  EXPECT_EQ(per_thread.Get(create), main_instance);
+
+  int sum = 0;
+  per_thread.ForEach([&](int value) {
+    sum += value;
+  });
+  EXPECT_EQ(sum, 3);
+}
+
+TEST(PerThreadTest, ReleasedOnThreadExit) {
+  PerThread<int> kept;
+  PerThread<int> released(PerThreadLifetime::Thread);
+  auto create = []() {
+    return std::make_unique<int>(1);
+  };
+  kept.Get(create);
+  released.Get(create);
+
+  std::thread thread([&]() {
+    kept.Get(create);
+    released.Get(create);
+    EXPECT_EQ(released.size(), 2u);
+  });
+  thread.join();
+  EXPECT_EQ(kept.size(), 2u);
+  EXPECT_EQ(released.size(), 1u);
+
+  // The object can be destroyed before the thread exits.
+  auto early = std::make_unique<PerThread<int>>(PerThreadLifetime::Thread);
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool created = false;
+  bool destroyed = false;
+  std::thread other([&]() {
+    early->Get(create);
+    std::unique_lock<std::mutex> lock(mutex);
+    created = true;
+    cv.notify_all();
+    cv.wait(lock, [&]() {
+      return destroyed;
+    });
+  });
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&]() {
+      return created;
+    });
+    early.reset();
+    destroyed = true;
+  }
+  cv.notify_all();
+  other.join();
+}
+
+TEST(PerThreadTest, ManyObjects) {
+  // Use more objects than each thread caches, so instances have to be looked
+  // up again.
+  std::vector<std::unique_ptr<PerThread<int>>> objects;
+  std::vector<int*> instances;
+  for (int i = 0; i < 20; i++) {
+    objects.emplace_back(std::make_unique<PerThread<int>>());
+    instances.emplace_back(objects.back()->Get([i]() {
+      return std::make_unique<int>(i);
+    }));
+  }
+  for (int i = 0; i < 20; i++) {
+    int* instance = objects[i]->Get([]() {
+      return std::make_unique<int>(-1);
+    });
+    EXPECT_EQ(instance, instances[i]);
+    EXPECT_EQ(*instance, i);
+  }
+}
+
+}  // namespace binary_reader
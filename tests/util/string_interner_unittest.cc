@@ -0,0 +1,141 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/string_interner.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+namespace binary_reader {
+
+namespace {
+
+class InternerTest : public testing::Test {
+ public:
+  Value Intern(CodecId id, const std::string& bytes) {
+    const auto& codec = CodecCollection::GetBuiltinCodec(id);
+    auto* data = reinterpret_cast<const uint8_t*>(bytes.data());
+    Value ret;
+    EXPECT_TRUE(interner_.Intern(
+        codec.get(), data, bytes.size(),
+        [&](UtfString* str) {
+          decoded_++;
+          ErrorInfo error;
+          *str = UtfString::FromEncoding(data, bytes.size(), codec, &error);
+          return true;
+        },
+        &ret));
+    return ret;
+  }
+
+ protected:
+  StringInterner interner_;
+  int decoded_ = 0;
+};
+
+}  // namespace
+
+TEST_F(InternerTest, SharesRepeatedStrings) {
+  const Value first = Intern(CodecId::Utf8, "tag");
+  EXPECT_EQ(Intern(CodecId::Utf8, "tag"), first);
+  EXPECT_EQ(Intern(CodecId::Utf8, "tag"), first);
+  EXPECT_EQ(Intern(CodecId::Utf8, "other"), Value{UtfString(u"other")});
+  EXPECT_EQ(decoded_, 2);
+
+  const StringInternStats& stats = interner_.stats();
+  EXPECT_EQ(stats.strings, 2u);
+  EXPECT_EQ(stats.encodings, 2u);
+  EXPECT_EQ(stats.hits, 2u);
+  EXPECT_EQ(stats.bytes_shared, 6u);
+  EXPECT_GT(stats.table_bytes, 0u);
+}
+
+TEST_F(InternerTest, SharesAcrossEncodings) {
+  const Value utf8 = Intern(CodecId::Utf8, "\xc2\xa3");
+  const Value latin1 = Intern(CodecId::Latin1, "\xa3");
+  EXPECT_EQ(utf8, latin1);
+  EXPECT_EQ(latin1.as_string(), UtfString(u"£"));
+  // The same bytes in another encoding are a different string.
+  EXPECT_NE(Intern(CodecId::Latin1, "\xc2\xa3"), utf8);
+
+  EXPECT_EQ(interner_.stats().strings, 2u);
+  EXPECT_EQ(interner_.stats().encodings, 3u);
+  EXPECT_EQ(interner_.stats().hits, 0u);
+}
+
+TEST_F(InternerTest, Grows) {
+  std::vector<Value> values;
+  for (int i = 0; i < 1000; i++)
+    values.push_back(Intern(CodecId::Utf8, std::to_string(i)));
+  for (int i = 0; i < 1000; i++)
+    ASSERT_EQ(Intern(CodecId::Utf8, std::to_string(i)), values[i]);
+  EXPECT_EQ(decoded_, 1000);
+  EXPECT_EQ(interner_.stats().hits, 1000u);
+}
+
+TEST_F(InternerTest, Concurrent) {
+  std::vector<Value> expected;
+  for (int i = 0; i < 100; i++)
+    expected.push_back(Intern(CodecId::Utf8, std::to_string(i)));
+
+  // Each thread adds its own strings and looks up the shared ones.
+  std::atomic<int> failures{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t]() {
+      const auto& codec = CodecCollection::GetBuiltinCodec(CodecId::Utf8);
+      for (int round = 0; round < 50; round++) {
+        for (int i = 0; i < 100; i++) {
+          const std::string bytes = std::to_string(i + (round % 2) * 1000 * t);
+          auto* data = reinterpret_cast<const uint8_t*>(bytes.data());
+          Value value;
+          interner_.Intern(
+              codec.get(), data, bytes.size(),
+              [&](UtfString* str) {
+                *str = UtfString::FromUtf8(bytes);
+                return true;
+              },
+              &value);
+          if (value != Value{UtfString::FromUtf8(bytes)} ||
+              (round % 2 == 0 && value != expected[i])) {
+            failures++;
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(failures, 0);
+  // Every thread but the first added 100 strings of its own.
+  EXPECT_EQ(interner_.stats().strings, 100u + 3 * 100);
+}
+
+TEST_F(InternerTest, DecodeFailure) {
+  const uint8_t bytes[] = {'a'};
+  Value value;
+  EXPECT_FALSE(interner_.Intern(
+      CodecCollection::GetBuiltinCodec(CodecId::Utf8).get(), bytes, 1,
+      [](UtfString*) { return false; }, &value));
+  // Failures aren't remembered.
+  EXPECT_EQ(Intern(CodecId::Utf8, "a"), Value{UtfString(u"a")});
+  EXPECT_EQ(interner_.stats().strings, 1u);
+}
+
+}  // namespace binary_reader
@@ -0,0 +1,94 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/utf8.h"
+
+#include "gtest_wrapper.h"
+
+namespace binary_reader {
+
+namespace {
+
+bool IsValid(const std::string& str) {
+  return IsValidUtf8(reinterpret_cast<const uint8_t*>(str.data()),
+                     str.size());
+}
+
+}  // namespace
+
+TEST(Utf8Test, IsValid) {
+  EXPECT_TRUE(IsValid(""));
+  EXPECT_TRUE(IsValid("plain ascii text that is longer than one word"));
+  EXPECT_TRUE(IsValid("a\xc2\xa3" "b\xe2\x82\xac" "c\xf0\x90\x90\xb7"));
+  EXPECT_TRUE(IsValid("\xf4\x8f\xbf\xbf"));
+
+  EXPECT_FALSE(IsValid("\x80"));
+  EXPECT_FALSE(IsValid("abc\xc2"));
+  EXPECT_FALSE(IsValid("\xc0\xaf"));          // Overlong
+  EXPECT_FALSE(IsValid("\xe0\x80\xaf"));      // Overlong
+  EXPECT_FALSE(IsValid("\xed\xa0\x80"));      // Surrogate
+  EXPECT_FALSE(IsValid("\xf4\x90\x80\x80"));  // Past U+10FFFF
+  EXPECT_FALSE(IsValid("\xe2\x28\xa1"));
+}
+
+TEST(Utf8Test, IsValid_Long) {
+  // Put each sequence at every offset around a 32-byte block boundary so the
+  // SIMD path sees it split across blocks.
+  const std::string valid[] = {
+      "\xc2\xa3", "\xe2\x82\xac", "\xf0\x90\x90\xb7", "\xef\xbf\xbf",
+      "\xf4\x8f\xbf\xbf",
+  };
+  const std::string invalid[] = {
+      "\x80",         "\xc2",     "\xc0\xaf",         "\xe0\x80\xaf",
+      "\xed\xa0\x80", "\xe2\x82", "\xf4\x90\x80\x80", "\xf8\x88\x80",
+  };
+  for (size_t offset = 24; offset < 40; offset++) {
+    for (size_t tail : {0, 1, 40}) {
+      for (auto& seq : valid) {
+        const std::string str =
+            std::string(offset, 'a') + seq + std::string(tail, 'b');
+        EXPECT_TRUE(IsValid(str)) << offset << " " << tail;
+      }
+      for (auto& seq : invalid) {
+        const std::string str =
+            std::string(offset, 'a') + seq + std::string(tail, 'b');
+        EXPECT_FALSE(IsValid(str)) << offset << " " << tail;
+      }
+    }
+  }
+}
+
+TEST(Utf8Test, Convert) {
+  const std::string utf8 =
+      "long ascii prefix a\xc2\xa3" "b\xe2\x82\xac" "c\xf0\x90\x90\xb7";
+  const std::u16string utf16 = u"long ascii prefix a£b€c\U00010437";
+
+  std::u16string actual16 = u"x";
+  AppendUtf8AsUtf16(reinterpret_cast<const uint8_t*>(utf8.data()), utf8.size(),
+                    &actual16);
+  EXPECT_EQ(actual16, u"x" + utf16);
+
+  std::string actual8 = "x";
+  AppendUtf16AsUtf8(utf16.data(), utf16.size(), &actual8);
+  EXPECT_EQ(actual8, "x" + utf8);
+}
+
+TEST(Utf8Test, Convert_UnpairedSurrogate) {
+  const char16_t utf16[] = {'a', 0xdc37, 0xd801};
+  std::string actual;
+  AppendUtf16AsUtf8(utf16, 3, &actual);
+  EXPECT_EQ(actual, "a\xed\xb0\xb7\xed\xa0\x81");
+}
+
+}  // namespace binary_reader
@@ -0,0 +1,129 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/value_cache.h"
+
+#include <memory>
+#include <vector>
+
+#include "binary_reader/file_object.h"
+#include "gtest_wrapper.h"
+#include "public/file_object_init.h"
+
+namespace binary_reader {
+
+namespace {
+
+class TestOwner final : public ValueCache::Owner {
+ public:
+  TestOwner(ValueCache* cache, size_t count) : cache_(cache), entries_(count) {}
+  ~TestOwner() {
+    for (auto& entry : entries_)
+      cache_->Remove(&entry, this);
+  }
+
+  void Add(size_t index, size_t size) {
+    cache_->Add(&entries_[index], this, index, size);
+  }
+
+  ValueCache::Entry* entry(size_t index) {
+    return &entries_[index];
+  }
+
+  Value EvictCachedValue(size_t index) override {
+    evicted.push_back(index);
+    return Value{};
+  }
+
+  std::vector<size_t> evicted;
+
+ private:
+  ValueCache* cache_;
+  std::vector<ValueCache::Entry> entries_;
+};
+
+}  // namespace
+
+TEST(ValueCacheTest, EvictsUnusedValues) {
+  ValueCache cache{100};
+  TestOwner owner{&cache, 4};
+  owner.Add(0, 40);
+  owner.Add(1, 40);
+  owner.Add(2, 40);
+  EXPECT_EQ(cache.size(), 120u);
+
+  // Values are only evicted when trimming.  Using a value gives it a second
+  // chance, so the next oldest one is evicted.
+  EXPECT_TRUE(owner.evicted.empty());
+  cache.Touch(owner.entry(0));
+  cache.Trim();
+  EXPECT_EQ(owner.evicted, std::vector<size_t>{1});
+  EXPECT_EQ(cache.size(), 80u);
+  EXPECT_EQ(cache.evictions(), 1u);
+  EXPECT_FALSE(owner.entry(1)->linked());
+
+  owner.Add(3, 50);
+  cache.Trim();
+  EXPECT_EQ(owner.evicted, (std::vector<size_t>{1, 2}));
+  EXPECT_EQ(cache.size(), 90u);
+}
+
+TEST(ValueCacheTest, UpdateAndRemove) {
+  ValueCache cache{100};
+  TestOwner owner{&cache, 2};
+  owner.Add(0, 60);
+  owner.Add(1, 30);
+  owner.Add(0, 10);
+  EXPECT_EQ(cache.size(), 40u);
+
+  cache.Remove(owner.entry(1), &owner);
+  cache.Remove(owner.entry(1), &owner);
+  EXPECT_EQ(cache.size(), 10u);
+  cache.Touch(owner.entry(1));
+  EXPECT_FALSE(owner.entry(1)->linked());
+}
+
+TEST(ValueCacheTest, ReleasesEvictedValues) {
+  ValueCache cache{10};
+
+  // The evicted value is released by the cache once it is unlocked, so
+  // releasing an object can remove the entries for its own fields.
+  class Parent final : public ValueCache::Owner {
+   public:
+    Value EvictCachedValue(size_t) override {
+      return std::move(value);
+    }
+
+    Value value;
+  } parent;
+
+  std::weak_ptr<FileObject> child;
+  {
+    FileObjectInit init;
+    init.test_fields = {{"foo", Value{1}}};
+    auto obj = MakeFileObject(init);
+    child = obj;
+    parent.value = Value{std::move(obj)};
+  }
+
+  ValueCache::Entry entry;
+  cache.Add(&entry, &parent, 0, 20);
+  EXPECT_FALSE(child.expired());
+  cache.Trim();
+  EXPECT_TRUE(child.expired());
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_EQ(cache.evictions(), 1u);
+}
+
+}  // namespace binary_reader
@@ -0,0 +1,162 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/varint.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "gtest_wrapper.h"
+
+namespace binary_reader {
+
+namespace {
+
+void AppendLeb128(uint64_t value, std::vector<uint8_t>* output) {
+  do {
+    uint8_t byte = value & 0x7f;
+    value >>= 7;
+    if (value)
+      byte |= 0x80;
+    output->push_back(byte);
+  } while (value);
+}
+
+}  // namespace
+
+TEST(VarintTest, DecodeLeb128) {
+  uint64_t value;
+  const uint8_t one[] = {0x01};
+  EXPECT_EQ(DecodeLeb128(one, sizeof(one), false, &value), 1u);
+  EXPECT_EQ(value, 1u);
+
+  const uint8_t example[] = {0xe5, 0x8e, 0x26, 0xff};
+  EXPECT_EQ(DecodeLeb128(example, sizeof(example), false, &value), 3u);
+  EXPECT_EQ(value, 624485u);
+
+  const uint8_t max[] = {0xff, 0xff, 0xff, 0xff, 0xff,
+                         0xff, 0xff, 0xff, 0xff, 0x01};
+  EXPECT_EQ(DecodeLeb128(max, sizeof(max), false, &value), 10u);
+  EXPECT_EQ(value, UINT64_MAX);
+}
+
+TEST(VarintTest, DecodeLeb128_Errors) {
+  uint64_t value;
+  const uint8_t truncated[] = {0x80, 0x80};
+  EXPECT_EQ(DecodeLeb128(truncated, sizeof(truncated), false, &value), 0u);
+
+  const uint8_t overflow[] = {0xff, 0xff, 0xff, 0xff, 0xff,
+                              0xff, 0xff, 0xff, 0xff, 0x03};
+  EXPECT_EQ(DecodeLeb128(overflow, sizeof(overflow), false, &value), 0u);
+  // Bits past 63 that would be sign bits are still too big when unsigned.
+  const uint8_t sign_bits[] = {0xff, 0xff, 0xff, 0xff, 0xff,
+                               0xff, 0xff, 0xff, 0xff, 0x7f};
+  EXPECT_EQ(DecodeLeb128(sign_bits, sizeof(sign_bits), false, &value), 0u);
+
+  const uint8_t too_long[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                              0x80, 0x80, 0x80, 0x80, 0x00};
+  EXPECT_EQ(DecodeLeb128(too_long, sizeof(too_long), false, &value), 0u);
+}
+
+TEST(VarintTest, SignedLeb128) {
+  uint64_t value;
+  const uint8_t minus_123456[] = {0xc0, 0xbb, 0x78};
+  ASSERT_EQ(DecodeLeb128(minus_123456, sizeof(minus_123456), true, &value),
+            3u);
+  EXPECT_EQ(SignExtendLeb128(value, 3), -123456);
+
+  const uint8_t sixty_three[] = {0x3f};
+  ASSERT_EQ(DecodeLeb128(sixty_three, sizeof(sixty_three), true, &value), 1u);
+  EXPECT_EQ(SignExtendLeb128(value, 1), 63);
+
+  const uint8_t min[] = {0x80, 0x80, 0x80, 0x80, 0x80,
+                         0x80, 0x80, 0x80, 0x80, 0x7f};
+  ASSERT_EQ(DecodeLeb128(min, sizeof(min), true, &value), 10u);
+  EXPECT_EQ(SignExtendLeb128(value, 10), INT64_MIN);
+
+  // Bit 63 must match the bits past it.
+  const uint8_t overflow[] = {0x80, 0x80, 0x80, 0x80, 0x80,
+                              0x80, 0x80, 0x80, 0x80, 0x01};
+  EXPECT_EQ(DecodeLeb128(overflow, sizeof(overflow), true, &value), 0u);
+  const uint8_t mixed[] = {0x80, 0x80, 0x80, 0x80, 0x80,
+                           0x80, 0x80, 0x80, 0x80, 0x7e};
+  EXPECT_EQ(DecodeLeb128(mixed, sizeof(mixed), true, &value), 0u);
+}
+
+TEST(VarintTest, ZigZag) {
+  EXPECT_EQ(ZigZagDecode(0), 0);
+  EXPECT_EQ(ZigZagDecode(1), -1);
+  EXPECT_EQ(ZigZagDecode(2), 1);
+  EXPECT_EQ(ZigZagDecode(4294967294u), 2147483647);
+  EXPECT_EQ(ZigZagDecode(UINT64_MAX), INT64_MIN);
+}
+
+TEST(VarintTest, DecodePrefixVarint) {
+  uint64_t value;
+  const uint8_t one_byte[] = {0x7f};
+  EXPECT_EQ(DecodePrefixVarint(one_byte, sizeof(one_byte), &value), 1u);
+  EXPECT_EQ(value, 0x7fu);
+
+  const uint8_t three_bytes[] = {0xd2, 0x34, 0x56};
+  EXPECT_EQ(DecodePrefixVarint(three_bytes, sizeof(three_bytes), &value), 3u);
+  EXPECT_EQ(value, 0x123456u);
+
+  const uint8_t full[] = {0xff, 0x01, 0x23, 0x45, 0x67,
+                          0x89, 0xab, 0xcd, 0xef};
+  EXPECT_EQ(DecodePrefixVarint(full, sizeof(full), &value), 9u);
+  EXPECT_EQ(value, 0x0123456789abcdefu);
+
+  EXPECT_EQ(DecodePrefixVarint(full, 8, &value), 0u);
+}
+
+TEST(VarintTest, DecodeLeb128Array) {
+  // Mix runs of single byte values with longer values so both the fast and
+  // general paths of the vector kernel are used, plus the scalar tail.
+  std::vector<uint64_t> expected;
+  std::vector<uint8_t> buffer;
+  for (uint64_t i = 0; i < 200; i++) {
+    const uint64_t value = i % 40 < 20 ? i : i * 0x123456789ull;
+    expected.push_back(value);
+    AppendLeb128(value, &buffer);
+  }
+
+  std::vector<uint64_t> values(expected.size());
+  std::vector<uint8_t> lengths(expected.size());
+  ASSERT_EQ(DecodeLeb128Array(buffer.data(), buffer.size(), expected.size(),
+                              values.data(), lengths.data()),
+            expected.size());
+  EXPECT_EQ(values, expected);
+
+  size_t total = 0;
+  for (uint8_t length : lengths)
+    total += length;
+  EXPECT_EQ(total, buffer.size());
+}
+
+TEST(VarintTest, DecodeLeb128Array_StopsAtError) {
+  std::vector<uint8_t> buffer;
+  for (uint64_t i = 0; i < 20; i++)
+    AppendLeb128(i * 1000, &buffer);
+  // A truncated value at the end.
+  buffer.push_back(0x80);
+
+  uint64_t values[21];
+  uint8_t lengths[21];
+  EXPECT_EQ(DecodeLeb128Array(buffer.data(), buffer.size(), 21, values,
+                              lengths),
+            20u);
+  EXPECT_EQ(values[19], 19000u);
+}
+
+}  // namespace binary_reader